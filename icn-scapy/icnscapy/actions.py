@@ -24,7 +24,8 @@ __all__ = [
 conf.verb = 0
 
 def send_interest(name, chunk_id, hash_prefix_only=True, iface=None,
-                  dst_mac_addr=None, dst_ip_addr=None, component_offset=None):
+                  dst_mac_addr=None, dst_ip_addr=None, component_offset=None,
+                  f_hash=None):
     """Issue an Interest packet for content *name* with chunk_id
 
     Parameters
@@ -43,13 +44,16 @@ def send_interest(name, chunk_id, hash_prefix_only=True, iface=None,
         The destination IP address
     component_offset : str, optional
         String of component offsets. If None, it is computed by the function
+    f_hash : callable, optional
+        The hash function to use, CRC32 is used if not specified
     """
     sendp(interest_over_ip(name, chunk_id, hash_prefix_only=hash_prefix_only,
                            dst_mac_addr=dst_mac_addr, dst_ip_addr=dst_ip_addr,
-                           component_offset=component_offset), iface=iface)
+                           component_offset=component_offset, f_hash=f_hash), iface=iface)
 
 def send_seq_interests(name, n_chunks, hash_prefix_only=True, iface=None,
-                       dst_mac_addr=None, dst_ip_addr=None, component_offset=None):
+                       dst_mac_addr=None, dst_ip_addr=None, component_offset=None,
+                  f_hash=None):
     """Request content *name* from chunk *1* to *n_chunks* sequentially
 
     Parameters
@@ -68,14 +72,17 @@ def send_seq_interests(name, n_chunks, hash_prefix_only=True, iface=None,
         The destination IP address
     component_offset : str, optional
         String of component offsets. If None, it is computed by the function
+    f_hash : callable, optional
+        The hash function to use, CRC32 is used if not specified
     """
     for i in range(n_chunks):
         sendp(interest_over_ip(name, i, hash_prefix_only=hash_prefix_only,
                                dst_mac_addr=dst_mac_addr, dst_ip_addr=dst_ip_addr,
-                               component_offset=component_offset), iface=iface)
+                               component_offset=component_offset, f_hash=f_hash), iface=iface)
 
 def send_data(name, chunk_id, payload="", hash_prefix_only=True, iface=None,
-              dst_mac_addr=None, dst_ip_addr=None, component_offset=None):
+              dst_mac_addr=None, dst_ip_addr=None, component_offset=None,
+              f_hash=None):
     """Issue a Data packet for content *name* with chunk_id and paylod *payload*
 
     Parameters
@@ -96,7 +103,9 @@ def send_data(name, chunk_id, payload="", hash_prefix_only=True, iface=None,
         The destination IP address
     component_offset : str, optional
         String of component offsets. If None, it is computed by the function
+    f_hash : callable, optional
+        The hash function to use, CRC32 is used if not specified
     """
     sendp(data_over_ip(name, chunk_id, payload=payload, hash_prefix_only=hash_prefix_only,
                        dst_mac_addr=dst_mac_addr, dst_ip_addr=dst_ip_addr,
-                       component_offset=component_offset), iface=iface)
+                       component_offset=component_offset, f_hash=f_hash), iface=iface)
@@ -16,6 +16,7 @@ __all__ = [
     'IcnData',
     'interest_over_ip',
     'data_over_ip',
+    'name_hash',
           ]
 
 # IP protocol field indicating ICN payload.
@@ -26,6 +27,17 @@ IP_PROTO_ICN = 253
 TLV_TYPE_NAME_COMPONENTS_OFFSET =   0x0001
 TLV_TYPE_NAME_SEGMENT_IDS_OFFSETS = 0x0002
 
+# Seed of the hash of names computed by the router (MASTER_CRC_SEED)
+NAME_HASH_SEED = 0x11111111
+
+# Table of the CRC32C (Castagnoli) polynomial, reflected
+CRC32C_TABLE = []
+for _i in range(256):
+    _crc = _i
+    for _ in range(8):
+        _crc = (_crc >> 1) ^ (0x82F63B78 if _crc & 1 else 0)
+    CRC32C_TABLE.append(_crc)
+
 class IcnInterest(Packet):
     """Alcatel-Lucent ICN Interest packet format
 
@@ -129,10 +141,35 @@ def int_to_ipv4(intval):
     """
     l = [0, 0, 0, 0]
     for i in range(4):
-        l[-i] = str(intval % 256)
+        l[3 - i] = str(intval % 256)
         intval >>= 8
     return ".".join(l)
 
+def name_hash(name):
+    """Return the hash of a name computed by the router, i.e. the CRC32C of
+    the name seeded with MASTER_CRC_SEED, as computed by DPDK rte_hash_crc
+
+    rte_hash_crc pads the trailing bytes of the name with zeros up to a
+    multiple of 4 bytes, and so does this function.
+
+    Use it with hash_prefix_only=False to build packets whose hash can be
+    trusted by a router started with --trust-name-hash.
+
+    Parameters
+    ----------
+    name : str
+        The full chunk name
+
+    Returns
+    -------
+    hash : int
+        The hash of the name (32 bits)
+    """
+    crc = NAME_HASH_SEED
+    for ch in name + "\x00" * (-len(name) % 4):
+        crc = CRC32C_TABLE[(crc ^ ord(ch)) & 0xFF] ^ (crc >> 8)
+    return crc
+
 def compute_offset(name):
     """Return byte array with offsets of component separators
 
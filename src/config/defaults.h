@@ -143,6 +143,12 @@
  */
 #define MBUF_SIZE (2048 + sizeof(struct rte_mbuf) + RTE_PKTMBUF_HEADROOM)
 
+/**
+ * Size of the private area of packet buffers, which stores the descriptor of
+ * the parsed packet (struct icn_desc). Must be a multiple of 8
+ */
+#define MBUF_PRIV_SIZE 64
+
 /**
  * Number of packet buffers per NUMA socket
  */
@@ -153,6 +159,26 @@
  */
 #define MEMPOOL_CACHE_SIZE 256
 
+/**
+ * Data room of an mbuf carrying only the Ethernet header of a packet
+ * transmitted to a face.
+ *
+ * Data packets (received or served from the CS) are never modified once they
+ * have been received. Each transmission gets its own small header mbuf
+ * chained to an indirect mbuf pointing to the shared, read-only packet.
+ */
+#define HDR_MBUF_DATA_SIZE (2 * RTE_PKTMBUF_HEADROOM)
+
+/**
+ * Number of header mbufs per NUMA socket
+ */
+#define NB_HDR_MBUF (NB_MBUF * 2)
+
+/**
+ * Number of indirect mbufs per NUMA socket
+ */
+#define NB_CLONE_MBUF (NB_MBUF * 2)
+
 
 /******************* Data plane configuration **********************/
 
@@ -174,6 +200,117 @@
 #define CS_NUM_BUCKETS      1024
 #define CS_MAX_ELEMENTS     4096
 
+/**
+ * Number of 4-bit counters of the counting Bloom filter tracking the content
+ * of each per-lcore CS, rounded up to a power of 2. Interests whose name is
+ * not in the filter skip the CS lookup. Set to 0 to disable the filter.
+ *
+ * The default (8 counters per element, 16 KB) keeps the false positive rate
+ * around 3% with CS_BF_NUM_HASHES hash functions and fits the L2 cache
+ */
+#define CS_BF_SIZE          (CS_MAX_ELEMENTS * 8)
+
+/**
+ * Number of hash functions of the CS Bloom filter
+ */
+#define CS_BF_NUM_HASHES    3
+
+/**
+ * Segment index of the CS, used if enabled for chunks whose name ends with a
+ * segment ID. Chunks are stored in blocks of CS_SEG_BLOCK_SIZE consecutive
+ * segments of an object (at most 8), sharing one copy of the object prefix.
+ * By default it holds as many chunks as the CS ring.
+ */
+// Each value is per core
+#define CS_SEG_BLOCK_SIZE   8
+#define CS_SEG_NUM_BUCKETS  (CS_NUM_BUCKETS / CS_SEG_BLOCK_SIZE)
+#define CS_SEG_MAX_BLOCKS   (CS_MAX_ELEMENTS / CS_SEG_BLOCK_SIZE)
+
+/**
+ * Max freshness period of a CS entry, in milliseconds. Longer freshness
+ * periods, carried by Data packets or configured per prefix, are capped
+ */
+#define CS_MAX_FRESHNESS_MS (6 * 3600 * 1000)
+
+/**
+ * Max number of per-prefix default freshness periods
+ */
+#define CS_MAX_FRESHNESS_RULES 32
+
+/**
+ * Max number of CS entries checked for expiry each time the CS is swept
+ */
+#define CS_SWEEP_BUDGET     64
+
+/**
+ * Max number of prefix purges in progress on a CS, and of purge requests
+ * waiting to be served
+ */
+#define CS_MAX_PURGES       8
+#define CS_PURGE_QUEUE_SIZE 16
+
+/**
+ * Max time spent purging the CS each time the TX buffers are drained, in
+ * microseconds
+ */
+#define CS_PURGE_BUDGET_US  5
+
+/**
+ * Max number of entries of a shard of the shared CS purged with the shard
+ * locked
+ */
+#define CS_SHARED_PURGE_BATCH 64
+
+/**
+ * Time the control plane waits for evicted mbufs of the shared CS to be freed
+ * when a purge fills up the limbo list of a shard, in microseconds
+ */
+#define CS_SHARED_PURGE_WAIT_US 100
+
+/**
+ * Number of shards of the CS shared by the lcores of a NUMA socket, if
+ * enabled. The shared CS is sized as the sum of the per-lcore CSs it replaces
+ */
+#define CS_SHARED_SHARDS    16
+
+/* CS disk tier */
+// Each value is per core. The disk tier is only used if a file is given
+#define CS_DISK_NUM_BUCKETS     65536
+#define CS_DISK_MAX_ELEMENTS    262144
+
+/**
+ * Size of a slot of the CS disk tier, i.e. max size of a packet spilled to disk
+ */
+#define CS_DISK_SLOT_SIZE 2048
+
+/**
+ * Size of the I/O request and completion rings of a CS disk tier
+ */
+#define CS_DISK_RING_SIZE 1024
+
+/**
+ * Max number of I/O requests of a disk tier served by the helper thread in a
+ * batch
+ */
+#define CS_DISK_IO_BURST 32
+
+/**
+ * Sleep time of the disk I/O helper thread when no request is pending, in
+ * microseconds
+ */
+#define CS_DISK_IO_IDLE_US 10
+
+/**
+ * Max length of the path of the file storing the CS disk tier
+ */
+#define CS_DISK_PATH_LEN 256
+
+/**
+ * Min number of mbufs left in the packet pool of a socket while an lcore
+ * reloads a CS snapshot, so that packets can still be received
+ */
+#define CS_SNAPSHOT_MBUF_RESERVE (NB_MBUF / 4)
+
 
 /**
  * Max size of burst transmitted to be sent to a TX port in a batch
@@ -189,6 +326,158 @@
  */
 #define BURST_TX_DRAIN_US 100
 
+/**
+ * Bounds of the number of packets buffered for a TX port before they are sent
+ * in a batch, with adaptive TX batching. Batches grow up to TX_BURST_MAX under
+ * heavy load, while packets expected to be fewer than TX_BURST_MIN within the
+ * latency SLO are sent at each poll instead of waiting for a batch
+ */
+#define TX_BURST_MIN 4
+#define TX_BURST_MAX (2 * MAX_PKT_BURST)
+
+/**
+ * Period over which the rate of packets buffered for each TX port is measured
+ * to adapt its batching, in microseconds
+ */
+#define TX_RATE_PERIOD_US 1000
+
+/**
+ * Max number of packets held in the software backlog of each TX queue while
+ * the queue of the NIC is full. Must be a power of 2
+ */
+#define TX_BACKLOG_SIZE 512
+
+/**
+ * Bytes credited to a class of a TX backlog at each DRR round per unit of
+ * weight. At least the size of the largest packet, so that each class
+ * transmits at least one packet per round
+ */
+#define TX_DRR_QUANTUM 1536
+
+/**
+ * Max DRR weight of a class of a TX backlog, so that its deficit, i.e. its
+ * quantum plus the bytes left from the previous round, less than a packet,
+ * fits in 32 bits
+ */
+#define TX_DRR_MAX_WEIGHT ((UINT32_MAX - UINT16_MAX) / TX_DRR_QUANTUM)
+
+/**
+ * Number of buckets of the histograms of TX batching delay. Bucket 0 counts
+ * delays below 1 us, bucket i delays between 2^(i-1) and 2^i us and the last
+ * one all longer delays
+ */
+#define TX_DELAY_HIST_BUCKETS 12
+
+/**
+ * Size of the rings connecting RX lcores to workers and workers to TX lcores
+ * in pipeline mode. Must be a power of 2
+ */
+#define PIPELINE_RING_SIZE 1024
+
+/**
+ * Number of shards of the PIT and CS in eventdev mode, i.e. of flows of the
+ * event device. Each shard is processed by one worker at a time
+ */
+#define EVENTDEV_NB_SHARDS 256
+
+/**
+ * Name of the software event device used in eventdev mode
+ */
+#define EVENTDEV_NAME "event_sw0"
+
+/**
+ * Number of Interests for a name served from the CS of its owner lcore within
+ * an epoch of HOT_NAMES_EPOCH_US which make the name hot, i.e. replicated in
+ * the CS of all lcores
+ */
+#define HOT_NAMES_THRESHOLD 2000
+
+/**
+ * Duration of the epochs over which hot names are detected, in microseconds
+ */
+#define HOT_NAMES_EPOCH_US 100000
+
+/**
+ * Freshness period of the replicas of hot names, in milliseconds. Replicas
+ * are refreshed at every epoch while their name is hot, so it must be longer
+ * than HOT_NAMES_EPOCH_US
+ */
+#define HOT_REPLICA_TTL_MS 300
+
+/**
+ * Period at which the control plane checks the load of forwarding lcores
+ * with elastic scaling, in microseconds
+ */
+#define ELASTIC_PERIOD_US 500000
+
+/**
+ * Average load of active lcores, in percent of their cycles spent processing
+ * packets, above which a parked lcore is activated
+ */
+#define ELASTIC_LOAD_HIGH 70
+
+/**
+ * Average load of active lcores, in percent, below which an lcore is parked
+ */
+#define ELASTIC_LOAD_LOW 25
+
+/**
+ * Min number of active forwarding lcores with elastic scaling
+ */
+#define ELASTIC_MIN_LCORES 1
+
+/**
+ * Time a parked lcore sleeps before checking whether it is activated, in
+ * microseconds
+ */
+#define ELASTIC_PARK_SLEEP_US 1000
+
+/**
+ * Max number of CS entries an lcore visits at each iteration of its loop when
+ * migrating them to the lcores their names are steered to
+ */
+#define ELASTIC_MIGRATE_BUDGET 64
+
+/**
+ * Number of consecutive empty polls after which an idle lcore pauses the CPU
+ * between polls
+ */
+#define IDLE_PAUSE_POLLS 64
+
+/**
+ * Number of rte_pause() calls between two polls of a pausing lcore
+ */
+#define IDLE_PAUSES 32
+
+/**
+ * Number of consecutive empty polls after which an idle lcore sleeps between
+ * polls, with the sleep and RX interrupt idle policies
+ */
+#define IDLE_SLEEP_POLLS 1024
+
+/**
+ * Duration of the first sleep of an idle lcore, in microseconds. Each further
+ * empty poll doubles it, up to IDLE_SLEEP_MAX_US
+ */
+#define IDLE_SLEEP_MIN_US 8
+
+/**
+ * Max duration of a sleep of an idle lcore, in microseconds
+ */
+#define IDLE_SLEEP_MAX_US 1000
+
+/**
+ * Number of consecutive empty polls after which an idle lcore waits for RX
+ * interrupts, with the RX interrupt idle policy, i.e. once sleeps are long
+ */
+#define IDLE_INTR_POLLS (IDLE_SLEEP_POLLS + 16)
+
+/**
+ * Max time an lcore waits for RX interrupts, in milliseconds, after which it
+ * polls again, e.g. the rings from other lcores, which raise no interrupt
+ */
+#define IDLE_INTR_TIMEOUT_MS 10
+
 /**
  * Number of packets ahead to prefetch, when reading received packets
  */
@@ -204,6 +493,25 @@
  */
 #define PIT_TTL_US 5000000
 
+/**
+ * Max number of Interests of a face admitted at once by the rate limit of the
+ * face on each lcore, if enabled
+ */
+#define FACE_RATE_BURST 64
+
+/**
+ * With the RTT forwarding strategy, one Interest out of STRATEGY_PROBE_PERIOD
+ * with several next hops is forwarded to a next hop other than the best one,
+ * to keep measuring it. Must be a power of 2
+ */
+#define STRATEGY_PROBE_PERIOD 32
+
+/**
+ * Max time the control plane waits for a command before checking whether
+ * the application is stopping, in microseconds
+ */
+#define CTRL_RECV_TIMEOUT_US 100000
+
 /******************* Hash config ***************************/
 
 /**
@@ -220,5 +528,12 @@
  */
 #define MASTER_CRC_SEED (uint32_t) CRC_SEED[0]
 
+/**
+ * When the hash of names embedded by producers in the source IPv4 address is
+ * trusted, one packet out of NAME_HASH_VERIFY_PERIOD on average has its name
+ * hashed anyway to verify it. Must be a power of 2
+ */
+#define NAME_HASH_VERIFY_PERIOD 64
+
 
 #endif /* _DEFAULTS_H_ */
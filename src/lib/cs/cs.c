@@ -6,6 +6,7 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include <stdio.h>
 
 #include <rte_hash_crc.h>
@@ -18,9 +19,10 @@
 #include <config.h>
 
 #include "cs.h"
+#include "cs_disk.h"
 
 
-cs_t* cs_create(int num_buckets, int max_elements, int socket) {
+cs_t* cs_create(int num_buckets, int max_elements, uint32_t bf_size, int socket) {
 	cs_t *cs;
 	void *p;
 	
@@ -57,27 +59,420 @@ cs_t* cs_create(int num_buckets, int max_elements, int socket) {
 		return NULL;
 	}
 	cs->ring = (struct cs_entry *) p;
+
+	/* Allocate space for the Bloom filter, two 4-bit counters per byte */
+	if(bf_size > 0) {
+		bf_size = rte_align32pow2(RTE_MAX(bf_size, 2U));
+		p = rte_zmalloc_socket("CS_BF", bf_size / 2, RTE_CACHE_LINE_SIZE, socket);
+		if(p == NULL) {
+			return NULL;
+		}
+		cs->bf = (uint8_t *) p;
+		cs->bf_mask = bf_size - 1;
+	}
 	return cs;
 }
 
 
+/*
+ * Add (delta = 1) or remove (delta = -1) an item to the Bloom filter.
+ * Saturated counters are never decremented, since the number of items they
+ * count is unknown
+ */
 static inline
-int8_t __cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
-		struct rte_mbuf *mbuf, uint32_t crc) {
-	uint32_t bucket;
+void cs_bf_update(cs_t *cs, uint32_t crc, int8_t delta) {
+	uint32_t i, idx, step;
+	uint8_t shift, counter;
+	if(cs->bf == NULL) {
+		return;
+	}
+	step = cs_bf_step(crc);
+	for (i = 0, idx = crc; i < CS_BF_NUM_HASHES; i++, idx += step) {
+		counter = cs_bf_counter(cs->bf, idx & cs->bf_mask);
+		if(unlikely(counter == 0x0F) || (delta < 0 && unlikely(counter == 0))) {
+			continue;
+		}
+		shift = ((idx & cs->bf_mask) & 1) << 2;
+		if(delta > 0) {
+			cs->bf[(idx & cs->bf_mask) >> 1] += (uint8_t) (1 << shift);
+		} else {
+			cs->bf[(idx & cs->bf_mask) >> 1] -= (uint8_t) (1 << shift);
+		}
+	}
+}
+
+
+/*
+ * Release the mbuf of an evicted entry, writing it to the disk tier, if any
+ */
+static inline
+void cs_evict_mbuf(cs_t *cs, struct rte_mbuf *mbuf, uint32_t crc, uint32_t expiry) {
+	if(cs->disk != NULL && !cs_is_expired(expiry, cs->now)) {
+		cs_disk_spill(cs->disk, mbuf, crc, expiry);
+	} else {
+		rte_pktmbuf_free(mbuf);
+	}
+}
+
+
+/*
+ * Move the bottom of the ring past entries already removed
+ */
+static inline
+void cs_skip_inactive(cs_t *cs) {
+	while(!is_cs_empty(cs) && cs->ring[cs->bottom].active == 0) {
+		cs->bottom = (cs->bottom + 1) % cs->max_elements;
+	}
+}
+
+
+/*
+ * Unlink an entry from the hash table and the ring, given its index in the
+ * ring, without releasing its mbuf
+ */
+static inline
+void cs_unlink_entry(cs_t *cs, uint32_t index) {
+	struct cs_entry *e = &cs->ring[index];
+	cs->table[e->bucket].busy[e->tab] = 0;
+	cs_bf_update(cs, cs->table[e->bucket].entry[e->tab].crc, -1);
+	e->active = 0;
+	if(index == cs->bottom) {
+		cs_skip_inactive(cs);
+	}
+}
+
+
+/*
+ * Remove an expired or purged entry, given its index in the ring
+ */
+static inline
+void cs_remove_entry(cs_t *cs, uint32_t index) {
+	struct rte_mbuf *mbuf = cs->ring[index].mbuf;
+	cs_unlink_entry(cs, index);
+	rte_pktmbuf_free(mbuf);
+}
+
+
+/*
+ * Return whether an entry of the ring is under the prefix of a purge in
+ * progress and was inserted before the purge was requested
+ */
+static inline
+uint8_t cs_is_purged(cs_t *cs, uint32_t index) {
+	struct cs_entry *e = &cs->ring[index];
+	uint32_t i, seq;
+	seq = cs_seq(cs, index);
+	for (i = 0; i < cs->nb_purges; i++) {
+		if(cs->purge[i].mem && (int32_t) (seq - cs->purge[i].end) < 0 &&
+				cs_name_has_prefix(cs->purge[i].prefix, cs->purge[i].prefix_len,
+						e->name, e->name_len)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/* Return the number of blocks in the segment index */
+static inline
+uint32_t cs_seg_occupancy(cs_t *cs) {
+	return (cs->seg.top + cs->seg.max_elements - cs->seg.bottom) % cs->seg.max_elements;
+}
+
+
+/* Return the sequence number of a block of the segment index */
+static inline
+uint32_t cs_seg_seq(cs_t *cs, uint32_t index) {
+	return cs->seg.inserted - (cs->seg.top + cs->seg.max_elements - index) % cs->seg.max_elements;
+}
+
+
+/* Return the key of a block in the segment index hash table */
+static inline
+uint32_t cs_seg_key(const uint8_t *prefix, uint8_t prefix_len, uint32_t block) {
+	return rte_hash_crc_4byte(block, rte_hash_crc(prefix, prefix_len, MASTER_CRC_SEED));
+}
+
+
+/*
+ * Return the index in the ring of a block of the segment index, -ENOENT if
+ * not found
+ */
+static inline
+int32_t cs_seg_find(cs_t *cs, const uint8_t *prefix, uint8_t prefix_len,
+		uint32_t block, uint32_t key) {
+	struct cs_bucket *bucket;
+	struct cs_seg_block *b;
 	uint8_t entry;
+
+	bucket = &cs->seg.table[key % cs->seg.num_buckets];
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (likely(bucket->busy[entry] == 0)) {
+			continue;
+		}
+		if(unlikely(bucket->entry[entry].crc != key)) {
+			continue;
+		}
+		b = &cs->seg.ring[bucket->entry[entry].index];
+		if(unlikely(b->block != block || b->prefix_len != prefix_len)) {
+			continue;
+		}
+		if (unlikely(memcmp(prefix, b->prefix, prefix_len) != 0)) {
+			continue;
+		}
+		return (int32_t) bucket->entry[entry].index;
+	}
+	return -ENOENT;
+}
+
+
+/*
+ * Move the bottom of the segment index ring past blocks already removed
+ */
+static inline
+void cs_seg_skip_inactive(cs_t *cs) {
+	while(cs->seg.bottom != cs->seg.top && cs->seg.ring[cs->seg.bottom].active == 0) {
+		cs->seg.bottom = (cs->seg.bottom + 1) % cs->seg.max_elements;
+	}
+}
+
+
+/*
+ * Remove segments of a block, given as a bitmap, releasing their mbufs. The
+ * block is removed once it holds no segments. Return the number of segments
+ * removed
+ */
+static inline
+uint32_t cs_seg_remove(cs_t *cs, uint32_t index, uint8_t mask) {
+	struct cs_seg_block *b = &cs->seg.ring[index];
+	uint32_t i, removed = 0;
+
+	mask &= b->present;
+	for (i = 0; i < CS_SEG_BLOCK_SIZE; i++) {
+		if((mask & (1 << i)) == 0) {
+			continue;
+		}
+		cs_bf_update(cs, b->crc[i], -1);
+		rte_pktmbuf_free(b->mbuf[i]);
+		removed++;
+	}
+	b->present &= ~mask;
+	cs->seg.segments -= removed;
+	if(b->present == 0) {
+		cs->seg.table[b->bucket].busy[b->tab] = 0;
+		b->active = 0;
+		if(index == cs->seg.bottom) {
+			cs_seg_skip_inactive(cs);
+		}
+	}
+	return removed;
+}
+
+
+/*
+ * Evict the bottom block of the segment index
+ */
+static inline
+void cs_seg_evict(cs_t *cs) {
+	struct cs_seg_block *b = &cs->seg.ring[cs->seg.bottom];
+	uint32_t i;
+
+	for (i = 0; i < CS_SEG_BLOCK_SIZE; i++) {
+		if((b->present & (1 << i)) == 0) {
+			continue;
+		}
+		cs_bf_update(cs, b->crc[i], -1);
+		cs_evict_mbuf(cs, b->mbuf[i], b->crc[i], b->expiry[i]);
+		cs->seg.segments--;
+	}
+	b->present = 0;
+	cs->seg.table[b->bucket].busy[b->tab] = 0;
+	b->active = 0;
+	cs->seg.bottom = (cs->seg.bottom + 1) % cs->seg.max_elements;
+}
+
+
+/*
+ * Return the bitmap of the segments of a block under the prefix of a purge,
+ * which may be the prefix of the object or the name of a single segment
+ */
+static inline
+uint8_t cs_seg_match(const struct cs_purge *p, const struct cs_seg_block *b) {
+	uint32_t id;
+	if(cs_name_has_prefix(p->prefix, p->prefix_len, b->prefix, b->prefix_len)) {
+		return (uint8_t) ((1 << CS_SEG_BLOCK_SIZE) - 1);
+	}
+	if(p->prefix_len == b->prefix_len + CS_SEG_ID_LEN &&
+			memcmp(p->prefix, b->prefix, b->prefix_len) == 0) {
+		memcpy(&id, p->prefix + b->prefix_len, sizeof(id));
+		id = rte_be_to_cpu_32(id);
+		if(id / CS_SEG_BLOCK_SIZE == b->block) {
+			return (uint8_t) (1 << (id % CS_SEG_BLOCK_SIZE));
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Return the bitmap of the segments of a block covered by purges in progress
+ * requested after the block was inserted
+ */
+static inline
+uint8_t cs_seg_purge_mask(cs_t *cs, uint32_t index) {
+	uint32_t i, seq;
+	uint8_t mask = 0;
+	seq = cs_seg_seq(cs, index);
+	for (i = 0; i < cs->nb_purges; i++) {
+		if(cs->purge[i].seg && (int32_t) (seq - cs->purge[i].seg_end) < 0) {
+			mask |= cs_seg_match(&cs->purge[i], &cs->seg.ring[index]);
+		}
+	}
+	return mask;
+}
+
+
+static inline
+int8_t cs_seg_insert(cs_t *cs, uint8_t *name, uint8_t prefix_len, uint32_t seg_id,
+		struct rte_mbuf *mbuf, uint32_t crc, uint32_t freshness_ms) {
+	struct cs_seg_index *seg = &cs->seg;
+	struct cs_seg_block *b;
+	uint32_t block, key, bucket;
+	int32_t index;
+	uint8_t i, entry, mask;
+
+	block = seg_id / CS_SEG_BLOCK_SIZE;
+	i = seg_id % CS_SEG_BLOCK_SIZE;
+	key = cs_seg_key(name, prefix_len, block);
+	index = cs_seg_find(cs, name, prefix_len, block, key);
+	if(index >= 0 && unlikely(cs->nb_purges > 0)) {
+		/*
+		 * The block predates purges covering some of its segments: purge
+		 * them now. If the new segment is covered too, the block is replaced,
+		 * otherwise the new segment would look purged
+		 */
+		mask = cs_seg_purge_mask(cs, index);
+		if(unlikely(mask != 0)) {
+			cs->purged += cs_seg_remove(cs, index, mask);
+			if(mask & (1 << i)) {
+				cs_seg_remove(cs, index, (uint8_t) ((1 << CS_SEG_BLOCK_SIZE) - 1));
+			}
+			if(seg->ring[index].active == 0) {
+				index = -ENOENT;
+			}
+		}
+	}
+	if(index < 0) {
+		/* Insert a new block */
+		bucket = key % seg->num_buckets;
+		for (entry = 0; entry < BUCKET_SIZE; entry++) {
+			if (likely(seg->table[bucket].busy[entry] == 0)) {
+				break;
+			}
+		}
+		if(unlikely(entry == BUCKET_SIZE)) {
+			return -ENOSPC;
+		}
+		/* if full, evict a block, in FIFO fashion */
+		if(likely(((seg->top + 1) % seg->max_elements) == seg->bottom)) {
+			cs_seg_skip_inactive(cs);
+		}
+		if(likely(((seg->top + 1) % seg->max_elements) == seg->bottom)) {
+			cs_seg_evict(cs);
+		}
+		index = (int32_t) seg->top;
+		b = &seg->ring[index];
+		seg->table[bucket].busy[entry] = 1;
+		seg->table[bucket].entry[entry].crc = key;
+		seg->table[bucket].entry[entry].index = seg->top;
+		b->active = 1;
+		b->bucket = bucket;
+		b->tab = entry;
+		b->prefix_len = prefix_len;
+		rte_memcpy(b->prefix, name, prefix_len);
+		b->present = 0;
+		b->block = block;
+		seg->top = (seg->top + 1) % seg->max_elements;
+		seg->inserted++;
+	}
+	b = &seg->ring[index];
+	if(b->present & (1 << i)) {
+		/* Replace the copy of the segment already stored */
+		rte_pktmbuf_free(b->mbuf[i]);
+	} else {
+		b->present |= (uint8_t) (1 << i);
+		seg->segments++;
+		cs_bf_update(cs, crc, 1);
+	}
+	b->crc[i] = crc;
+	b->mbuf[i] = mbuf;
+	b->expiry[i] = cs_expiry(cs->now, freshness_ms);
+	return 0;
+}
+
+
+static inline
+struct rte_mbuf *cs_seg_lookup(cs_t *cs, uint8_t *name, uint8_t prefix_len,
+		uint32_t seg_id, int8_t *miss) {
+	struct cs_seg_block *b;
+	uint32_t block;
+	int32_t index;
+	uint8_t i;
+
+	block = seg_id / CS_SEG_BLOCK_SIZE;
+	i = seg_id % CS_SEG_BLOCK_SIZE;
+	index = cs_seg_find(cs, name, prefix_len, block, cs_seg_key(name, prefix_len, block));
+	*miss = -ENOENT;
+	if(index < 0) {
+		return NULL;
+	}
+	b = &cs->seg.ring[index];
+	if((b->present & (1 << i)) == 0) {
+		return NULL;
+	}
+	/* Segment found but stale: remove it */
+	if(unlikely(cs_is_expired(b->expiry[i], cs->now))) {
+		cs->expired += cs_seg_remove(cs, index, (uint8_t) (1 << i));
+		*miss = -ESTALE;
+		return NULL;
+	}
+	/* Segment found but under a prefix being purged: remove it */
+	if(unlikely(cs->nb_purges > 0) && (cs_seg_purge_mask(cs, index) & (1 << i))) {
+		cs->purged += cs_seg_remove(cs, index, (uint8_t) (1 << i));
+		*miss = -ECANCELED;
+		return NULL;
+	}
+	return b->mbuf[i];
+}
+
+
+static inline
+int8_t __cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
+		struct rte_mbuf *mbuf, uint32_t crc, uint32_t freshness_ms) {
+	uint32_t bucket, evicted_crc, seg_id;
+	uint8_t entry, prefix_len;
 	
+	/* Chunks of segmented objects go to the segment index, if enabled */
+	if(cs->seg.table != NULL && cs_seg_split(name, name_len, &prefix_len, &seg_id)) {
+		return cs_seg_insert(cs, name, prefix_len, seg_id, mbuf, crc, freshness_ms);
+	}
 	/* Get index of corresponding bucket */
 	bucket = crc % cs->num_buckets;
 	/* Iterate all buckets till find one free and insert */
 	for (entry = 0; entry < BUCKET_SIZE; entry++) {
 		if (likely(cs->table[bucket].busy[entry] == 0)) {
 			/* if full, evict a content, in FIFO fashion*/
+			if(likely(is_cs_full(cs))) {
+				cs_skip_inactive(cs);
+			}
 			if(likely(is_cs_full(cs))) {
 				cs->table[cs->ring[cs->bottom].bucket].busy[cs->ring[cs->bottom].tab] = 0;
 				cs->ring[cs->bottom].active = 0;
-				/* Free pointer to mbuf holding the actual packet */
-				rte_pktmbuf_free(cs->ring[cs->bottom].mbuf);
+				evicted_crc = cs->table[cs->ring[cs->bottom].bucket].entry[cs->ring[cs->bottom].tab].crc;
+				cs_bf_update(cs, evicted_crc, -1);
+				/* Release pointer to mbuf holding the actual packet */
+				cs_evict_mbuf(cs, cs->ring[cs->bottom].mbuf, evicted_crc,
+						cs->ring[cs->bottom].expiry);
 				if(unlikely(cs->bottom == cs->max_elements - 1)) {
 					cs->bottom = 0;
 				} else {
@@ -94,7 +489,10 @@ int8_t __cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
 			cs->ring[cs->top].name_len = name_len;
 			rte_memcpy(cs->ring[cs->top].name, name, name_len);
 			cs->ring[cs->top].mbuf = mbuf;
+			cs->ring[cs->top].expiry = cs_expiry(cs->now, freshness_ms);
 			cs->top = (cs->top + 1) % cs->max_elements;
+			cs->inserted++;
+			cs_bf_update(cs, crc, 1);
 			return 0;
 		}
 	}
@@ -103,21 +501,71 @@ int8_t __cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
 
 
 int8_t cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
-		struct rte_mbuf *mbuf, uint32_t crc) {
-	return __cs_insert_with_hash(cs, name, name_len, mbuf, crc);
+		struct rte_mbuf *mbuf, uint32_t crc, uint32_t freshness_ms) {
+	return __cs_insert_with_hash(cs, name, name_len, mbuf, crc, freshness_ms);
 }
 
 
-int8_t cs_insert(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf) {
+int8_t cs_insert(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf,
+		uint32_t freshness_ms) {
 	uint32_t crc = rte_hash_crc(name, name_len, MASTER_CRC_SEED);
-	return __cs_insert_with_hash(cs, name, name_len, mbuf, crc);
+	return __cs_insert_with_hash(cs, name, name_len, mbuf, crc, freshness_ms);
+}
+
+
+/* Return the later of two expiration times */
+static inline uint32_t
+cs_later_expiry(uint32_t expiry, uint32_t new_expiry) {
+	if(expiry == CS_NO_EXPIRY || new_expiry == CS_NO_EXPIRY) {
+		return CS_NO_EXPIRY;
+	}
+	return (int32_t) (new_expiry - expiry) > 0 ? new_expiry : expiry;
+}
+
+
+int8_t cs_refresh_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
+		uint32_t crc, uint32_t freshness_ms) {
+	struct cs_entry *e;
+	struct cs_seg_block *b;
+	uint32_t bucket, seg_id, block;
+	int32_t index;
+	uint8_t entry, prefix_len, i;
+
+	if(cs->seg.table != NULL && cs_seg_split(name, name_len, &prefix_len, &seg_id)) {
+		block = seg_id / CS_SEG_BLOCK_SIZE;
+		i = seg_id % CS_SEG_BLOCK_SIZE;
+		index = cs_seg_find(cs, name, prefix_len, block, cs_seg_key(name, prefix_len, block));
+		if(index < 0 || (cs->seg.ring[index].present & (1 << i)) == 0) {
+			return -ENOENT;
+		}
+		b = &cs->seg.ring[index];
+		b->expiry[i] = cs_later_expiry(b->expiry[i], cs_expiry(cs->now, freshness_ms));
+		return 0;
+	}
+	bucket = crc % cs->num_buckets;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if(cs->table[bucket].busy[entry] == 0 || cs->table[bucket].entry[entry].crc != crc) {
+			continue;
+		}
+		e = &cs->ring[cs->table[bucket].entry[entry].index];
+		if(name_len != e->name_len || memcmp(name, e->name, name_len) != 0) {
+			continue;
+		}
+		e->expiry = cs_later_expiry(e->expiry, cs_expiry(cs->now, freshness_ms));
+		return 0;
+	}
+	return -ENOENT;
 }
 
 
 struct rte_mbuf *__cs_lookup_with_hash(cs_t *cs, uint8_t *name,
-		uint8_t name_len, uint32_t crc) {
-	uint32_t bucket;
-	uint8_t entry;
+		uint8_t name_len, uint32_t crc, int8_t *miss) {
+	uint32_t bucket, seg_id;
+	uint8_t entry, prefix_len;
+	if(cs->seg.table != NULL && cs_seg_split(name, name_len, &prefix_len, &seg_id)) {
+		return cs_seg_lookup(cs, name, prefix_len, seg_id, miss);
+	}
+	*miss = -ENOENT;
 	/* Get index of corresponding bucket */
 	bucket = crc % cs->num_buckets;
 	/* Iterate all buckets till find one free and insert */
@@ -137,6 +585,20 @@ struct rte_mbuf *__cs_lookup_with_hash(cs_t *cs, uint8_t *name,
 			/* name lengths do not match, keep iterating bucket */
 			continue;
 		}
+		/* Element found but stale: remove it */
+		if(unlikely(cs_is_expired(cs->ring[cs->table[bucket].entry[entry].index].expiry, cs->now))) {
+			cs_remove_entry(cs, cs->table[bucket].entry[entry].index);
+			cs->expired++;
+			*miss = -ESTALE;
+			return NULL;
+		}
+		/* Element found but under a prefix being purged: remove it */
+		if(unlikely(cs->nb_purges > 0) && cs_is_purged(cs, cs->table[bucket].entry[entry].index)) {
+			cs_remove_entry(cs, cs->table[bucket].entry[entry].index);
+			cs->purged++;
+			*miss = -ECANCELED;
+			return NULL;
+		}
 		/* Element found. Remove it and return pointer to face bitmask */
 		return cs->ring[cs->table[bucket].entry[entry].index].mbuf;
 	}
@@ -145,14 +607,324 @@ struct rte_mbuf *__cs_lookup_with_hash(cs_t *cs, uint8_t *name,
 
 
 struct rte_mbuf *cs_lookup_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
-		uint32_t crc) {
-	return __cs_lookup_with_hash(cs, name, name_len, crc);
+		uint32_t crc, int8_t *miss) {
+	return __cs_lookup_with_hash(cs, name, name_len, crc, miss);
 }
 
 
 struct rte_mbuf *cs_lookup(cs_t *cs, uint8_t *name, uint8_t name_len) {
 	uint32_t crc = rte_hash_crc(name, name_len, MASTER_CRC_SEED);
-	return __cs_lookup_with_hash(cs, name, name_len, crc);
+	int8_t miss;
+	return __cs_lookup_with_hash(cs, name, name_len, crc, &miss);
+}
+
+
+uint32_t cs_purge_expired(cs_t *cs, uint32_t budget) {
+	struct cs_seg_block *b;
+	uint32_t checked, removed, purged = 0;
+	uint8_t i, mask;
+
+	/* Restart from the bottom if the cursor is not in the ring any more */
+	if((cs->sweep + cs->max_elements - cs->bottom) % cs->max_elements >= cs_occupancy(cs)) {
+		cs->sweep = cs->bottom;
+	}
+	for (checked = 0; checked < budget && cs->sweep != cs->top; checked++) {
+		if(cs->ring[cs->sweep].active &&
+				cs_is_expired(cs->ring[cs->sweep].expiry, cs->now)) {
+			cs_remove_entry(cs, cs->sweep);
+			cs->expired++;
+			purged++;
+		}
+		cs->sweep = (cs->sweep + 1) % cs->max_elements;
+	}
+	if(cs->seg.table == NULL) {
+		return purged;
+	}
+	/* Same for the segment index, one block at a time */
+	if((cs->seg.sweep + cs->seg.max_elements - cs->seg.bottom) % cs->seg.max_elements >= cs_seg_occupancy(cs)) {
+		cs->seg.sweep = cs->seg.bottom;
+	}
+	for (checked = 0; checked < budget && cs->seg.sweep != cs->seg.top; checked++) {
+		b = &cs->seg.ring[cs->seg.sweep];
+		mask = 0;
+		for (i = 0; b->active && i < CS_SEG_BLOCK_SIZE; i++) {
+			if((b->present & (1 << i)) && cs_is_expired(b->expiry[i], cs->now)) {
+				mask |= (uint8_t) (1 << i);
+			}
+		}
+		if(mask != 0) {
+			removed = cs_seg_remove(cs, cs->seg.sweep, mask);
+			cs->expired += removed;
+			purged += removed;
+		}
+		cs->seg.sweep = (cs->seg.sweep + 1) % cs->seg.max_elements;
+	}
+	return purged;
+}
+
+
+int8_t cs_freshness_set(struct cs_freshness_rules *rules, const uint8_t *prefix,
+		uint8_t prefix_len, uint32_t freshness_ms) {
+	uint32_t i;
+	if(prefix_len == 0 || prefix_len > MAX_NAME_LEN) {
+		return -EINVAL;
+	}
+	for (i = 0; i < rules->nb_rules; i++) {
+		if(rules->rule[i].prefix_len == prefix_len &&
+				memcmp(rules->rule[i].prefix, prefix, prefix_len) == 0) {
+			rules->rule[i].freshness_ms = freshness_ms;
+			return 0;
+		}
+	}
+	if(rules->nb_rules == CS_MAX_FRESHNESS_RULES) {
+		return -ENOSPC;
+	}
+	rules->rule[i].freshness_ms = freshness_ms;
+	rules->rule[i].prefix_len = prefix_len;
+	rte_memcpy(rules->rule[i].prefix, prefix, prefix_len);
+	/* Make the rule visible only once it is complete */
+	rte_smp_wmb();
+	rules->nb_rules++;
+	return 0;
+}
+
+
+int cs_seg_enable(cs_t *cs, uint32_t num_buckets, uint32_t max_blocks, int socket) {
+	void *p;
+
+	/* The segments of a block are tracked by an 8-bit bitmap */
+	RTE_BUILD_BUG_ON(CS_SEG_BLOCK_SIZE > 8);
+
+	cs->seg.num_buckets = num_buckets;
+	/* One more ring entry to distinguish between full and empty ring */
+	cs->seg.max_elements = max_blocks + 1;
+	printf("CS segment index size %u blocks of %u segments\n", cs->seg.max_elements,
+			CS_SEG_BLOCK_SIZE);
+
+	p = rte_zmalloc_socket("CS_SEG_RING", cs->seg.max_elements*sizeof(struct cs_seg_block),
+			RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		return -ENOMEM;
+	}
+	cs->seg.ring = (struct cs_seg_block *) p;
+
+	/* The index is enabled once its table is set */
+	p = rte_zmalloc_socket("CS_SEG_TABLE", cs->seg.num_buckets*sizeof(struct cs_bucket),
+			RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		return -ENOMEM;
+	}
+	cs->seg.table = (struct cs_bucket *) p;
+	return 0;
+}
+
+
+int8_t cs_purge_request(cs_t *cs, const uint8_t *prefix, uint8_t prefix_len) {
+	struct cs_purge_queue *q = &cs->purge_queue;
+	struct cs_purge_req *req;
+	if(prefix_len == 0 || prefix_len > MAX_NAME_LEN) {
+		return -EINVAL;
+	}
+	if(q->head - q->tail == CS_PURGE_QUEUE_SIZE) {
+		return -ENOSPC;
+	}
+	req = &q->req[q->head % CS_PURGE_QUEUE_SIZE];
+	req->prefix_len = prefix_len;
+	rte_memcpy(req->prefix, prefix, prefix_len);
+	/* Make the request visible only once it is complete */
+	rte_smp_wmb();
+	q->head++;
+	return 0;
+}
+
+
+/*
+ * Start serving queued purge requests, as long as there is room for them.
+ * If all purges in progress only wait for the disk tier to wrap around, the
+ * whole disk tier is invalidated to make room
+ */
+static inline
+void cs_purge_accept(cs_t *cs) {
+	struct cs_purge_queue *q = &cs->purge_queue;
+	struct cs_purge_req *req;
+	struct cs_purge *p;
+	uint32_t i;
+
+	while (q->tail != q->head) {
+		if(cs->nb_purges == CS_MAX_PURGES) {
+			for (i = 0; i < cs->nb_purges; i++) {
+				if(cs->purge[i].mem || cs->purge[i].seg) {
+					return;
+				}
+			}
+			cs->disk_watermark = cs->disk->written;
+			cs->nb_purges = 0;
+		}
+		rte_smp_rmb();
+		req = &q->req[q->tail % CS_PURGE_QUEUE_SIZE];
+		p = &cs->purge[cs->nb_purges];
+		p->prefix_len = req->prefix_len;
+		rte_memcpy(p->prefix, req->prefix, req->prefix_len);
+		/* Only entries already in the CS or disk tier need to be purged */
+		p->end = cs->inserted;
+		p->sweep = cs->inserted - cs_occupancy(cs);
+		p->mem = !is_cs_empty(cs);
+		p->seg = 0;
+		if(cs->seg.table != NULL) {
+			p->seg_end = cs->seg.inserted;
+			p->seg_sweep = cs->seg.inserted - cs_seg_occupancy(cs);
+			p->seg = cs->seg.top != cs->seg.bottom;
+		}
+		p->disk = 0;
+		if(cs->disk != NULL) {
+			p->disk_end = cs->disk->written;
+			p->disk = cs->disk->top != cs->disk->bottom;
+		}
+		q->tail++;
+		if(p->mem || p->seg || p->disk) {
+			cs->nb_purges++;
+		}
+	}
+}
+
+
+uint32_t cs_purge_step(cs_t *cs, uint64_t budget) {
+	struct cs_purge *p;
+	uint64_t start;
+	uint32_t i, index, bottom_seq, removed, checked = 0, purged = 0;
+
+	if(likely(cs->nb_purges == 0 && cs->purge_queue.tail == cs->purge_queue.head)) {
+		return 0;
+	}
+	start = rte_rdtsc();
+	cs_purge_accept(cs);
+	for (i = 0; i < cs->nb_purges; i++) {
+		p = &cs->purge[i];
+		if(p->disk && (int32_t) (cs_disk_seq(cs->disk, cs->disk->bottom) - p->disk_end) >= 0) {
+			/* All slots written before the request have been overwritten */
+			p->disk = 0;
+		}
+		if(p->mem) {
+			/* Entries evicted meanwhile do not need to be swept */
+			bottom_seq = cs->inserted - cs_occupancy(cs);
+			if((int32_t) (p->sweep - bottom_seq) < 0) {
+				p->sweep = bottom_seq;
+			}
+			while ((int32_t) (p->sweep - p->end) < 0) {
+				if((++checked & 0x0F) == 0 && rte_rdtsc() - start > budget) {
+					return purged;
+				}
+				index = (cs->top + cs->max_elements - (cs->inserted - p->sweep)) % cs->max_elements;
+				if(cs->ring[index].active && cs_name_has_prefix(p->prefix, p->prefix_len,
+						cs->ring[index].name, cs->ring[index].name_len)) {
+					cs_remove_entry(cs, index);
+					cs->purged++;
+					purged++;
+				}
+				p->sweep++;
+			}
+			p->mem = 0;
+		}
+		if(p->seg) {
+			bottom_seq = cs->seg.inserted - cs_seg_occupancy(cs);
+			if((int32_t) (p->seg_sweep - bottom_seq) < 0) {
+				p->seg_sweep = bottom_seq;
+			}
+			while ((int32_t) (p->seg_sweep - p->seg_end) < 0) {
+				if((++checked & 0x0F) == 0 && rte_rdtsc() - start > budget) {
+					return purged;
+				}
+				index = (cs->seg.top + cs->seg.max_elements - (cs->seg.inserted - p->seg_sweep))
+						% cs->seg.max_elements;
+				if(cs->seg.ring[index].active) {
+					removed = cs_seg_remove(cs, index, cs_seg_match(p, &cs->seg.ring[index]));
+					cs->purged += removed;
+					purged += removed;
+				}
+				p->seg_sweep++;
+			}
+			p->seg = 0;
+		}
+	}
+	/* Retire completed purges */
+	for (i = 0; i < cs->nb_purges; ) {
+		if(cs->purge[i].mem || cs->purge[i].seg || cs->purge[i].disk) {
+			i++;
+			continue;
+		}
+		cs->nb_purges--;
+		if(i != cs->nb_purges) {
+			cs->purge[i] = cs->purge[cs->nb_purges];
+		}
+	}
+	return purged;
+}
+
+
+uint8_t cs_purge_check_disk(cs_t *cs, const uint8_t *name, uint8_t name_len,
+		uint32_t slot) {
+	uint32_t i, seq;
+	seq = cs_disk_seq(cs->disk, slot);
+	if((int32_t) (seq - cs->disk_watermark) < 0) {
+		goto purged;
+	}
+	for (i = 0; i < cs->nb_purges; i++) {
+		if(cs->purge[i].disk && (int32_t) (seq - cs->purge[i].disk_end) < 0 &&
+				cs_name_has_prefix(cs->purge[i].prefix, cs->purge[i].prefix_len,
+						name, name_len)) {
+			goto purged;
+		}
+	}
+	return 0;
+
+purged:
+	cs_disk_remove(cs->disk, slot);
+	cs->purged++;
+	return 1;
+}
+
+
+void cs_migration_start(cs_t *cs, struct cs_migration *mig) {
+	mig->end = cs->inserted;
+	mig->sweep = cs->inserted - cs_occupancy(cs);
+}
+
+
+uint32_t cs_migrate_step(cs_t *cs, struct cs_migration *mig, uint32_t budget,
+		cs_migrate_t migrate, void *arg) {
+	struct cs_entry *e;
+	uint64_t units_per_s;
+	uint32_t index, bottom_seq, checked, freshness_ms, moved = 0;
+	int ret;
+
+	/* Entries evicted meanwhile do not need to be migrated */
+	bottom_seq = cs->inserted - cs_occupancy(cs);
+	if((int32_t) (mig->sweep - bottom_seq) < 0) {
+		mig->sweep = bottom_seq;
+	}
+	units_per_s = RTE_MAX(rte_get_tsc_hz() >> CS_TIME_SHIFT, 1ULL);
+	for (checked = 0; checked < budget && (int32_t) (mig->sweep - mig->end) < 0; checked++) {
+		index = (cs->top + cs->max_elements - (cs->inserted - mig->sweep)) % cs->max_elements;
+		e = &cs->ring[index];
+		if(e->active && !cs_is_expired(e->expiry, cs->now)) {
+			freshness_ms = 0;
+			if(e->expiry != CS_NO_EXPIRY) {
+				freshness_ms = (uint32_t) RTE_MAX((uint64_t) (e->expiry - cs->now) * 1000 /
+						units_per_s, 1ULL);
+			}
+			ret = migrate(e->mbuf, cs->table[e->bucket].entry[e->tab].crc, freshness_ms, arg);
+			if(ret < 0) {
+				/* Retried at the next call */
+				break;
+			}
+			if(ret == 0) {
+				cs_unlink_entry(cs, index);
+				moved++;
+			}
+		}
+		mig->sweep++;
+	}
+	return moved;
 }
 
 
@@ -178,6 +950,24 @@ void cs_free(cs_t *cs) {
 	if(cs->ring != NULL) {
 		rte_free(cs->ring);
 	}
+	if(cs->bf != NULL) {
+		rte_free(cs->bf);
+	}
+	if(cs->seg.ring != NULL) {
+		for (bucket = 0; bucket < cs->seg.max_elements; bucket++) {
+			if(cs->seg.ring[bucket].active) {
+				for (entry = 0; entry < CS_SEG_BLOCK_SIZE; entry++) {
+					if(cs->seg.ring[bucket].present & (1 << entry)) {
+						rte_pktmbuf_free(cs->seg.ring[bucket].mbuf[entry]);
+					}
+				}
+			}
+		}
+		rte_free(cs->seg.ring);
+	}
+	if(cs->seg.table != NULL) {
+		rte_free(cs->seg.table);
+	}
 	rte_free(cs);
 	return;
 }
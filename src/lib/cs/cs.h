@@ -13,7 +13,37 @@
  *
  * Content Store (CS)
  *
- * The content store evicts items according to the the FIFO replacement policy
+ * The content store evicts items according to the the FIFO replacement policy.
+ * If a disk tier is attached to the CS, evicted items are written to it
+ * instead of being discarded.
+ *
+ * The content of the CS can be tracked by a counting Bloom filter of 4-bit
+ * counters, small enough to stay in cache, so that most lookups of names not
+ * in the CS do not need to access the hash table.
+ *
+ * Each entry may have a freshness period, after which it is not served any
+ * more. Expired entries are removed when found by a lookup or by a sweep of
+ * the ring, which checks a bounded number of entries at each call. As in the
+ * PIT, removed entries leave holes in the ring which are reclaimed once the
+ * bottom of the ring reaches them.
+ *
+ * All entries under a name prefix can be purged. The control plane posts
+ * purge requests on a queue of the CS, which its lcore serves within a cycle
+ * budget. Since the ring is a FIFO log, only the entries inserted before a
+ * request may need to be purged: each entry has a sequence number (its
+ * insertion count, derived from its position in the ring) and a request only
+ * sweeps entries older than itself, once. Until the sweep completes, lookups
+ * hitting an entry older than the request and under its prefix remove it.
+ * Slots of the disk tier, whose names are not in memory, are checked only
+ * when looked up, the same way.
+ *
+ * Optionally, chunks of segmented objects, i.e. whose name ends with a
+ * CS_SEG_ID_LEN-byte segment ID component, are stored in a separate segment
+ * index. Its entries are blocks of CS_SEG_BLOCK_SIZE consecutive segments of
+ * an object, which store the object prefix once and are evicted as a whole in
+ * FIFO order. Lookups of sequential chunks hit the same bucket and block.
+ * This is transparent to users of the CS, which still insert and look up full
+ * chunk names.
  */
 
 #include <stdlib.h>
@@ -22,11 +52,27 @@
 #include <stdint.h>
 #include <errno.h>
 
+#include <rte_common.h>
 #include <rte_memory.h>
 #include <rte_cycles.h>
+#include <rte_hash_crc.h>
+#include <rte_byteorder.h>
+#include <rte_prefetch.h>
 
 #include <config.h>
 
+/**
+ * The CS measures time in units of 2^CS_TIME_SHIFT CPU cycles, which lets
+ * expiration times fit in 32 bits (i.e. about 20 us per unit and 13 hours of
+ * range with a 3 GHz TSC)
+ */
+#define CS_TIME_SHIFT 16
+
+/**
+ * Expiration time of entries which never expire
+ */
+#define CS_NO_EXPIRY 0
+
 /**
  * Number of entries in a bucket
  *
@@ -71,9 +117,114 @@ struct cs_entry {
 	uint8_t name_len;			 /**< length of name in CS entry*/
 	uint8_t name[MAX_NAME_LEN]; /**< name in CS entry */
 	struct rte_mbuf *mbuf;		/*< pointer to the RTE mbuf containing the packet */
+	uint32_t expiry;			 /**< expiration time in CS time units, CS_NO_EXPIRY if none */
 }__attribute__((__packed__)) __rte_cache_aligned;
 
 
+/**
+ * Length of the segment ID component ending the name of a chunk of a
+ * segmented object
+ */
+#define CS_SEG_ID_LEN 4
+
+/**
+ * Entry of the segment index of the CS: block of consecutive segments of an
+ * object
+ *
+ * This is one element of the segment index ring
+ */
+struct cs_seg_block {
+	uint8_t active;				 /**< flag indicating whether this entry is used */
+	uint32_t bucket;			 /**< bucket in the table, need this pointer for eviction */
+	uint8_t tab;				 /**< tab in bucket, need this pointer for eviction */
+	uint8_t prefix_len;			 /**< length of the object prefix, including the last separator */
+	uint8_t prefix[MAX_NAME_LEN]; /**< object prefix */
+	uint8_t present;			 /**< bitmap of the segments stored */
+	uint32_t block;				 /**< block number, i.e. segment ID / CS_SEG_BLOCK_SIZE */
+	uint32_t crc[CS_SEG_BLOCK_SIZE];	/**< CRC32 hashes of the chunk names */
+	uint32_t expiry[CS_SEG_BLOCK_SIZE];	/**< expiration times of the segments */
+	struct rte_mbuf *mbuf[CS_SEG_BLOCK_SIZE];	/**< pointers to the RTE mbufs containing the segments */
+}__attribute__((__packed__)) __rte_cache_aligned;
+
+/**
+ * Segment index of the CS
+ */
+struct cs_seg_index {
+	struct cs_bucket *table;	/**< pointer to hash table, NULL if the index is disabled */
+	struct cs_seg_block *ring;	/**< pointer to ring of blocks */
+	uint32_t max_elements;		/**< size of the ring */
+	uint32_t num_buckets;		/**< number of buckets in the hash table */
+	uint32_t top;				/**< index of top (most recently inserted) block */
+	uint32_t bottom;			/**< index of bottom (least recently inserted) block */
+	uint32_t inserted;			/**< number of blocks inserted, i.e. sequence number of the next block */
+	uint32_t sweep;				/**< index of the next block checked for expiry by a sweep */
+	uint32_t segments;			/**< number of segments stored */
+};
+
+/**
+ * Default freshness period of Data whose name is under a prefix
+ */
+struct cs_freshness_rule {
+	uint32_t freshness_ms;		/**< freshness period in milliseconds, 0 for none */
+	uint8_t prefix_len;			/**< length of the prefix */
+	uint8_t prefix[MAX_NAME_LEN];	/**< name prefix */
+};
+
+/**
+ * Table of default freshness periods of Data not carrying one
+ *
+ * Rules are only added, by the control plane, while forwarding lcores read
+ * them: a rule is written before the number of rules is incremented
+ */
+struct cs_freshness_rules {
+	volatile uint32_t nb_rules;	/**< number of rules */
+	struct cs_freshness_rule rule[CS_MAX_FRESHNESS_RULES];	/**< rules */
+};
+
+
+/**
+ * Request to purge all entries under a name prefix
+ */
+struct cs_purge_req {
+	uint8_t prefix_len;			/**< length of the prefix */
+	uint8_t prefix[MAX_NAME_LEN];	/**< name prefix */
+};
+
+/**
+ * Queue of purge requests posted by the control plane
+ *
+ * Single producer (control plane) and single consumer (lcore owning the CS)
+ */
+struct cs_purge_queue {
+	volatile uint32_t head;		/**< number of requests posted */
+	volatile uint32_t tail;		/**< number of requests accepted by the lcore */
+	struct cs_purge_req req[CS_PURGE_QUEUE_SIZE];	/**< requests */
+};
+
+/**
+ * Purge in progress
+ *
+ * Sequence numbers count insertions in the in-memory CS or writes in the
+ * disk tier. Entries with a sequence number lower than the end of a purge
+ * were inserted before the purge was requested.
+ */
+struct cs_purge {
+	uint8_t prefix_len;			/**< length of the prefix */
+	uint8_t prefix[MAX_NAME_LEN];	/**< name prefix */
+	uint8_t mem;				/**< 1 while the in-memory CS has not been swept */
+	uint8_t disk;				/**< 1 while the disk tier may hold matching slots */
+	uint8_t seg;				/**< 1 while the segment index has not been swept */
+	uint32_t sweep;				/**< sequence number of the next entry to sweep */
+	uint32_t end;				/**< sequence number of the first entry inserted after the request */
+	uint32_t seg_sweep;			/**< sequence number of the next block to sweep */
+	uint32_t seg_end;			/**< sequence number of the first block inserted after the request */
+	uint32_t disk_end;			/**< sequence number of the first slot written after the request */
+};
+
+
+/* Disk tier, defined in cs_disk.h */
+struct cs_disk;
+
 /**
  * Content Store (CS)
  */
@@ -84,6 +235,19 @@ typedef struct {
 	uint32_t num_buckets;		/**< number of buckets in the hash table */
 	uint32_t top;		 		/**< index of top (most recently inserted) entry */
 	uint32_t bottom;			/**< index of bottom (least recently inserted) entry */
+	struct cs_disk *disk;		/**< disk tier receiving evicted entries, if any */
+	uint8_t *bf;				/**< counting Bloom filter, two counters per byte, NULL if disabled */
+	uint32_t bf_mask;			/**< number of counters of the Bloom filter minus one */
+	uint32_t now;				/**< current time in CS time units, set with cs_set_time */
+	uint32_t sweep;				/**< index of the next entry checked for expiry by a sweep */
+	uint32_t expired;			/**< number of expired entries removed */
+	uint32_t inserted;			/**< number of entries inserted, i.e. sequence number of the next entry */
+	uint32_t nb_purges;			/**< number of purges in progress */
+	uint32_t purged;			/**< number of entries removed by purges */
+	uint32_t disk_watermark;	/**< sequence number of the oldest valid slot of the disk tier */
+	struct cs_seg_index seg;	/**< segment index, if enabled */
+	struct cs_purge purge[CS_MAX_PURGES];	/**< purges in progress */
+	struct cs_purge_queue purge_queue;	/**< purge requests posted by the control plane */
 } __attribute__((__packed__)) __rte_cache_aligned cs_t;
 
 
@@ -129,6 +293,280 @@ uint8_t is_cs_full(cs_t *cs) {
 	return ((cs->top + 1) % cs->max_elements) == cs->bottom;
 }
 
+/**
+ * Convert a TSC value to CS time units
+ *
+ * @param tsc
+ *   TSC value
+ *
+ * @return
+ *   time in CS time units
+ */
+static inline
+uint32_t cs_time(uint64_t tsc) {
+	return (uint32_t) (tsc >> CS_TIME_SHIFT);
+}
+
+/**
+ * Return the expiration time of an entry inserted now
+ *
+ * @param now
+ *   current time in CS time units
+ * @param freshness_ms
+ *   freshness period in milliseconds, 0 if the entry does not expire
+ *
+ * @return
+ *   expiration time in CS time units, CS_NO_EXPIRY if the entry does not
+ *   expire
+ */
+static inline
+uint32_t cs_expiry(uint32_t now, uint32_t freshness_ms) {
+	uint32_t expiry;
+	if(freshness_ms == 0) {
+		return CS_NO_EXPIRY;
+	}
+	expiry = now + (uint32_t) ((uint64_t) RTE_MIN(freshness_ms, (uint32_t) CS_MAX_FRESHNESS_MS)
+			* (rte_get_tsc_hz() >> CS_TIME_SHIFT) / 1000);
+	return expiry == CS_NO_EXPIRY ? 1 : expiry;
+}
+
+/**
+ * Return whether an expiration time has passed
+ *
+ * @param expiry
+ *   expiration time in CS time units
+ * @param now
+ *   current time in CS time units
+ *
+ * @return
+ *   1 if expired, 0 otherwise
+ */
+static inline
+uint8_t cs_is_expired(uint32_t expiry, uint32_t now) {
+	return expiry != CS_NO_EXPIRY && (int32_t) (expiry - now) <= 0;
+}
+
+/**
+ * Set the current time of the CS, used to check expiration of its entries
+ *
+ * @param cs
+ *   pointer to the CS
+ * @param tsc
+ *   current TSC value
+ */
+static inline
+void cs_set_time(cs_t *cs, uint64_t tsc) {
+	cs->now = cs_time(tsc);
+}
+
+/**
+ * Return the sequence number of an entry of the CS ring
+ *
+ * @param cs
+ *   pointer to the CS
+ * @param index
+ *   index of the entry in the ring, between bottom and top
+ *
+ * @return
+ *   sequence number of the entry
+ */
+static inline
+uint32_t cs_seq(cs_t *cs, uint32_t index) {
+	return cs->inserted - (cs->top + cs->max_elements - index) % cs->max_elements;
+}
+
+/**
+ * Split the name of a chunk of a segmented object in object prefix and
+ * segment ID
+ *
+ * @param name
+ *   name of the chunk
+ * @param name_len
+ *   length of the name
+ * @param prefix_len
+ *   where to write the length of the object prefix, including the last
+ *   separator
+ * @param seg_id
+ *   where to write the segment ID
+ *
+ * @return
+ *   1 if the name ends with a segment ID, 0 otherwise
+ */
+static inline
+uint8_t cs_seg_split(const uint8_t *name, uint8_t name_len, uint8_t *prefix_len,
+		uint32_t *seg_id) {
+	uint32_t id;
+	if(name_len <= CS_SEG_ID_LEN || name[name_len - CS_SEG_ID_LEN - 1] != COMPONENT_SEP) {
+		return 0;
+	}
+	*prefix_len = name_len - CS_SEG_ID_LEN;
+	memcpy(&id, name + *prefix_len, sizeof(id));
+	*seg_id = rte_be_to_cpu_32(id);
+	return 1;
+}
+
+/**
+ * Return whether a name is under a prefix, i.e. the prefix matches whole
+ * components of the name
+ *
+ * @param prefix
+ *   name prefix
+ * @param prefix_len
+ *   length of the prefix
+ * @param name
+ *   name
+ * @param name_len
+ *   length of the name
+ *
+ * @return
+ *   1 if the name is under the prefix, 0 otherwise
+ */
+static inline
+uint8_t cs_name_has_prefix(const uint8_t *prefix, uint8_t prefix_len,
+		const uint8_t *name, uint8_t name_len) {
+	if(prefix_len > name_len || memcmp(prefix, name, prefix_len) != 0) {
+		return 0;
+	}
+	return prefix_len == name_len || name[prefix_len] == COMPONENT_SEP ||
+			prefix[prefix_len - 1] == COMPONENT_SEP;
+}
+
+/**
+ * Return the default freshness period of a Data, i.e. the one of the rule
+ * with the longest prefix of its name
+ *
+ * @param rules
+ *   pointer to the table of rules
+ * @param name
+ *   name of the Data
+ * @param name_len
+ *   length of the name
+ *
+ * @return
+ *   freshness period in milliseconds, 0 if no rule matches
+ */
+static inline
+uint32_t cs_freshness_lookup(const struct cs_freshness_rules *rules,
+		const uint8_t *name, uint8_t name_len) {
+	const struct cs_freshness_rule *rule;
+	uint32_t i, nb_rules, freshness_ms = 0;
+	uint8_t best_len = 0;
+
+	nb_rules = rules->nb_rules;
+	for (i = 0; i < nb_rules; i++) {
+		rule = &rules->rule[i];
+		if(rule->prefix_len <= best_len ||
+				!cs_name_has_prefix(rule->prefix, rule->prefix_len, name, name_len)) {
+			continue;
+		}
+		best_len = rule->prefix_len;
+		freshness_ms = rule->freshness_ms;
+	}
+	return freshness_ms;
+}
+
+/**
+ * Add or update the default freshness period of a prefix
+ *
+ * @param rules
+ *   pointer to the table of rules
+ * @param prefix
+ *   name prefix
+ * @param prefix_len
+ *   length of the prefix
+ * @param freshness_ms
+ *   freshness period in milliseconds, 0 for none
+ *
+ * @return
+ *  - 0 if the rule has been added or updated
+ *  - -EINVAL if the prefix is too long or empty
+ *  - -ENOSPC if the table is full
+ */
+int8_t cs_freshness_set(struct cs_freshness_rules *rules, const uint8_t *prefix,
+		uint8_t prefix_len, uint32_t freshness_ms);
+
+/**
+ * Return the increment between the indexes of the counters of an item in the
+ * CS Bloom filter (double hashing). It is odd, so that indexes are distinct
+ */
+static inline
+uint32_t cs_bf_step(uint32_t crc) {
+	return rte_hash_crc_4byte(crc, CRC_SEED[1]) | 1;
+}
+
+/**
+ * Return the value of a counter of the CS Bloom filter
+ */
+static inline
+uint8_t cs_bf_counter(const uint8_t *bf, uint32_t i) {
+	return (bf[i >> 1] >> ((i & 1) << 2)) & 0x0F;
+}
+
+/**
+ * Return whether an item may be in the CS, according to its Bloom filter
+ *
+ * @param cs
+ *   pointer to the CS
+ * @param crc
+ *   CRC32 hash of the chunk name
+ *
+ * @return
+ *   0 if the item is certainly not in the CS, 1 if it may be in the CS or the
+ *   Bloom filter is disabled
+ */
+static inline
+uint8_t cs_bf_may_contain(cs_t *cs, uint32_t crc) {
+	uint32_t i, idx, step;
+	if(cs->bf == NULL) {
+		return 1;
+	}
+	step = cs_bf_step(crc);
+	for (i = 0, idx = crc; i < CS_BF_NUM_HASHES; i++, idx += step) {
+		if(cs_bf_counter(cs->bf, idx & cs->bf_mask) == 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Prefetch the bucket of the hash table of the CS where an item would be
+ *
+ * This is the first of the two prefetch steps of a staged lookup of a burst
+ * of names: the bucket of each name is prefetched, then the ring entries
+ * matching their hashes (see cs_prefetch_entry), so that the memory accesses
+ * of all lookups of the burst overlap.
+ *
+ * @param cs
+ *   pointer to the CS
+ * @param crc
+ *   CRC32 hash of the chunk name
+ */
+static inline
+void cs_prefetch_bucket(cs_t *cs, uint32_t crc) {
+	rte_prefetch0(&cs->table[crc % cs->num_buckets]);
+}
+
+/**
+ * Prefetch the ring entries of the CS whose hash matches the one of an item,
+ * once its bucket has been prefetched with cs_prefetch_bucket
+ *
+ * @param cs
+ *   pointer to the CS
+ * @param crc
+ *   CRC32 hash of the chunk name
+ */
+static inline
+void cs_prefetch_entry(cs_t *cs, uint32_t crc) {
+	struct cs_bucket *bucket = &cs->table[crc % cs->num_buckets];
+	uint8_t entry;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if(bucket->busy[entry] && bucket->entry[entry].crc == crc) {
+			rte_prefetch0(&cs->ring[bucket->entry[entry].index]);
+		}
+	}
+}
+
 /**
  * Free the memory allocated for the CS
  *
@@ -146,13 +584,51 @@ void cs_free(cs_t *cs);
  * @param max_elements
  *   Max number of elements supported, i.e. size of the circular log associated
  *   to the CS hash table
+ * @param bf_size
+ *   Number of counters of the Bloom filter, 0 to disable it
  * @param socket
  *   ID of the NUMA socket on which the CS will be created
  *
  * @return
  *   pointer to the CS
  */
-cs_t* cs_create(int num_buckets, int  max_elements, int socket);
+cs_t* cs_create(int num_buckets, int  max_elements, uint32_t bf_size, int socket);
+
+/**
+ * Attach a disk tier to the Content Store
+ *
+ * From now on, items evicted from the CS are written to the disk tier.
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param disk
+ *   Pointer to the disk tier
+ */
+static inline
+void cs_set_disk(cs_t *cs, struct cs_disk *disk) {
+	cs->disk = disk;
+}
+
+/**
+ * Enable the segment index of the Content Store
+ *
+ * From now on, chunks of segmented objects are stored in the segment index
+ * instead of the CS ring.
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param num_buckets
+ *   The number of buckets in the segment index hash table
+ * @param max_blocks
+ *   Max number of blocks of CS_SEG_BLOCK_SIZE segments stored
+ * @param socket
+ *   ID of the NUMA socket on which the index will be created
+ *
+ * @return
+ *  - 0 if the index has been created
+ *  - -ENOMEM if the index could not be allocated
+ */
+int cs_seg_enable(cs_t *cs, uint32_t num_buckets, uint32_t max_blocks, int socket);
 
 /**
  * Insert a new chunk in the Content Store, given CRC32 hash of the chunk name.
@@ -169,13 +645,16 @@ cs_t* cs_create(int num_buckets, int  max_elements, int socket);
  *   Pointer to the mbuf storing the Data packet to add to the CS
  * @param crc
  *   CRC32 hash of the chunk name
+ * @param freshness_ms
+ *   Freshness period of the chunk in milliseconds, 0 if it does not expire
  *
  * @return
  *  - 0 if inserted correctly
  *  - -ENOSPC if the hash table bucket is full (very unlikely)
  *
  */
-int8_t cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf, uint32_t crc);
+int8_t cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf,
+		uint32_t crc, uint32_t freshness_ms);
 
 /**
  * Insert a new chunk in the Content Store
@@ -190,12 +669,171 @@ int8_t cs_insert_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte
  *   Length of the chunk name to insert
  * @param mbuf
  *   Pointer to the mbuf storing the Data packet to add to the CS
+ * @param freshness_ms
+ *   Freshness period of the chunk in milliseconds, 0 if it does not expire
  *
  * @return
  *  - 0 if inserted correctly
  *  - -ENOSPC if the hash table bucket is full (very unlikely)
  */
-int8_t cs_insert(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf);
+int8_t cs_insert(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbuf,
+		uint32_t freshness_ms);
+
+/**
+ * Extend the freshness period of a chunk already in the CS, e.g. when another
+ * copy of it is received. Chunks which do not expire, or expire later than
+ * the new freshness period, are left unchanged
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param name
+ *   Name of the chunk
+ * @param name_len
+ *   Length of the chunk name
+ * @param crc
+ *   CRC32 hash of the chunk name
+ * @param freshness_ms
+ *   Freshness period of the chunk from now in milliseconds, 0 if it does not expire
+ *
+ * @return
+ *  - 0 if the chunk is in the CS
+ *  - -ENOENT otherwise
+ */
+int8_t cs_refresh_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len,
+		uint32_t crc, uint32_t freshness_ms);
+
+/**
+ * Remove expired entries from the CS, checking at most a given number of
+ * entries of the ring from where the previous call stopped
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param budget
+ *   Max number of entries to check
+ *
+ * @return
+ *   Number of entries removed
+ */
+uint32_t cs_purge_expired(cs_t *cs, uint32_t budget);
+
+/**
+ * Post a request to purge all entries under a name prefix
+ *
+ * Called by the control plane. The request is served by the lcore owning
+ * the CS in subsequent calls to cs_purge_step
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param prefix
+ *   Name prefix
+ * @param prefix_len
+ *   Length of the prefix
+ *
+ * @return
+ *  - 0 if the request has been posted
+ *  - -EINVAL if the prefix is too long or empty
+ *  - -ENOSPC if the queue of requests is full
+ */
+int8_t cs_purge_request(cs_t *cs, const uint8_t *prefix, uint8_t prefix_len);
+
+/**
+ * Serve purge requests, sweeping the CS for at most a given number of CPU
+ * cycles
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param budget
+ *   Max number of CPU cycles to spend
+ *
+ * @return
+ *   Number of entries removed
+ */
+uint32_t cs_purge_step(cs_t *cs, uint64_t budget);
+
+/**
+ * Return whether a slot of the disk tier, found by looking up a name, has
+ * been purged. If so, the slot is removed from the disk tier
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param name
+ *   Name looked up
+ * @param name_len
+ *   Length of the name
+ * @param slot
+ *   Slot returned by cs_disk_lookup
+ *
+ * @return
+ *   1 if the slot has been purged, 0 otherwise
+ */
+uint8_t cs_purge_check_disk(cs_t *cs, const uint8_t *name, uint8_t name_len,
+		uint32_t slot);
+
+/**
+ * Migration of the entries of a CS, e.g. to the CS of other lcores. Only the
+ * entries inserted before the migration starts are visited, once, by sequence
+ * number, as by purges
+ */
+struct cs_migration {
+	uint32_t sweep;		/**< sequence number of the next entry to visit */
+	uint32_t end;		/**< sequence number of the first entry not to visit */
+};
+
+/**
+ * Function called on each entry visited by a migration, with the mbuf of the
+ * entry, the CRC32 hash of its name and its remaining freshness period in ms
+ * (0 if it never expires). It returns:
+ *  - 0 if it took the mbuf over, in which case the entry is removed from the
+ *    CS without releasing the mbuf
+ *  - a positive value if the entry stays in the CS
+ *  - a negative value if the entry cannot be migrated now, in which case the
+ *    migration stops and the entry is visited again by the next step
+ */
+typedef int (*cs_migrate_t)(struct rte_mbuf *mbuf, uint32_t crc,
+		uint32_t freshness_ms, void *arg);
+
+/**
+ * Start a migration of all entries currently in the CS. Entries of the
+ * segment index are not migrated
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param mig
+ *   Migration to start
+ */
+void cs_migration_start(cs_t *cs, struct cs_migration *mig);
+
+/**
+ * Tell whether a migration has visited all its entries
+ *
+ * @param mig
+ *   Pointer to the migration, zeroed if never started
+ */
+static inline
+uint8_t cs_migration_done(const struct cs_migration *mig) {
+	return mig->sweep == mig->end;
+}
+
+/**
+ * Continue a migration, visiting at most a given number of entries. Expired
+ * entries are skipped
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param mig
+ *   Migration in progress
+ * @param budget
+ *   Max number of entries to visit
+ * @param migrate
+ *   Function called on each entry visited
+ * @param arg
+ *   Argument passed to migrate
+ *
+ * @return
+ *   Number of entries taken over by migrate
+ */
+uint32_t cs_migrate_step(cs_t *cs, struct cs_migration *mig, uint32_t budget,
+		cs_migrate_t migrate, void *arg);
 
 /**
  * Lookup an item in cache, given CRC32 hash of the chunk name
@@ -208,12 +846,19 @@ int8_t cs_insert(cs_t *cs, uint8_t *name, uint8_t name_len, struct rte_mbuf *mbu
  *   Length of the chunk name to look up
  * @param crc
  *   CRC32 hash of the chunk name
+ * @param miss
+ *   Set, in case of a miss, to:
+ *    - -ENOENT if the chunk is not in the CS
+ *    - -ESTALE if it expired
+ *    - -ECANCELED if it has been purged
  *
  * @return
  *  - pointer to RTE mbuf containg the Data packet, in case of a hit
- *  - NULL, in case of a miss
+ *  - NULL, in case of a miss or if the chunk expired or has been purged, in
+ *    which case it is removed
  */
-struct rte_mbuf *cs_lookup_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len, uint32_t crc);
+struct rte_mbuf *cs_lookup_with_hash(cs_t *cs, uint8_t *name, uint8_t name_len, uint32_t crc,
+		int8_t *miss);
 
 /**
  * Lookup an item in cache
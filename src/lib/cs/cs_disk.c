@@ -0,0 +1,358 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <rte_version.h>
+#include <rte_malloc.h>
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_ring.h>
+#include <rte_mempool.h>
+
+#include <config.h>
+
+#include "cs_disk.h"
+
+/**
+ * Arguments of the helper thread
+ */
+struct cs_disk_io_conf {
+	pthread_t thread;
+	volatile uint8_t stop;		/**< set to stop the thread */
+	unsigned nb_disks;
+	cs_disk_t *disks[APP_MAX_LCORES];
+};
+
+/* Helper thread running, if any */
+static struct cs_disk_io_conf *io_conf;
+
+
+/*
+ * Create a ring in memory allocated on a socket, so that it can be freed
+ * with the disk tier
+ */
+static struct rte_ring *
+cs_disk_ring_create(const char *name, int socket) {
+	struct rte_ring *r;
+	ssize_t size;
+
+	size = rte_ring_get_memsize(CS_DISK_RING_SIZE);
+	if(size < 0) {
+		return NULL;
+	}
+	r = rte_zmalloc_socket(name, size, RTE_CACHE_LINE_SIZE, socket);
+	if(r == NULL) {
+		return NULL;
+	}
+	if(rte_ring_init(r, name, CS_DISK_RING_SIZE, RING_F_SP_ENQ | RING_F_SC_DEQ) != 0) {
+		rte_free(r);
+		return NULL;
+	}
+	return r;
+}
+
+
+cs_disk_t *cs_disk_create(int fd, uint64_t base, int num_buckets,
+		int max_elements, int socket, unsigned id) {
+	cs_disk_t *disk;
+	void *p;
+	char name[RTE_RING_NAMESIZE];
+
+	p = rte_zmalloc_socket("CS_DISK", sizeof(cs_disk_t), RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		return NULL;
+	}
+	disk = (cs_disk_t *) p;
+
+	disk->fd = fd;
+	disk->base = base;
+	disk->num_buckets = num_buckets;
+	/*
+	 * As in the in-memory CS, one slot is always kept unused to distinguish
+	 * between the case in which the ring is full and the ring is empty
+	 */
+	disk->max_elements = max_elements + 1;
+
+	/* Allocate space for the index hash table */
+	p = rte_zmalloc_socket("CS_DISK_TABLE", disk->num_buckets*sizeof(struct cs_bucket),
+			RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		goto fail;
+	}
+	disk->table = (struct cs_bucket *) p;
+
+	/* Allocate space for the ring of slots */
+	p = rte_zmalloc_socket("CS_DISK_SLOTS", disk->max_elements*sizeof(struct cs_disk_slot),
+			RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		goto fail;
+	}
+	disk->slots = (struct cs_disk_slot *) p;
+
+	/*
+	 * There are less requests than ring entries, so that enqueueing a
+	 * request on a ring never fails
+	 */
+	snprintf(name, sizeof(name), "CS_DISK_REQ_%u", id);
+	disk->req_ring = cs_disk_ring_create(name, socket);
+	if(disk->req_ring == NULL) {
+		goto fail;
+	}
+	snprintf(name, sizeof(name), "CS_DISK_CPL_%u", id);
+	disk->cpl_ring = cs_disk_ring_create(name, socket);
+	if(disk->cpl_ring == NULL) {
+		goto fail;
+	}
+	/* Created last, as mempools cannot be freed before DPDK 16.07 */
+	snprintf(name, sizeof(name), "CS_DISK_POOL_%u", id);
+	disk->req_pool = rte_mempool_create(name, CS_DISK_RING_SIZE - 1,
+			sizeof(struct cs_disk_req), 0, 0, NULL, NULL, NULL, NULL,
+			socket, 0);
+	if(disk->req_pool == NULL) {
+		goto fail;
+	}
+	return disk;
+
+fail:
+	cs_disk_free(disk);
+	return NULL;
+}
+
+
+int8_t cs_disk_spill(cs_disk_t *disk, struct rte_mbuf *mbuf, uint32_t crc,
+		uint32_t expiry) {
+	struct cs_disk_req *req;
+	uint32_t bucket;
+	uint8_t entry;
+
+	/* Only packets stored in a single segment fitting a slot are written */
+	if(unlikely(mbuf->nb_segs != 1 || mbuf->pkt_len > CS_DISK_SLOT_SIZE)) {
+		goto drop;
+	}
+	bucket = crc % disk->num_buckets;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (likely(disk->table[bucket].busy[entry] == 0)) {
+			break;
+		}
+	}
+	if(unlikely(entry == BUCKET_SIZE)) {
+		goto drop;
+	}
+	if(unlikely(rte_mempool_get(disk->req_pool, (void **) &req) < 0)) {
+		goto drop;
+	}
+	req->op = CS_DISK_OP_WRITE;
+	req->slot = disk->top;
+	req->crc = crc;
+	req->len = (uint16_t) mbuf->pkt_len;
+	req->mbuf = mbuf;
+	req->interest = NULL;
+	if(unlikely(rte_ring_sp_enqueue(disk->req_ring, req) < 0)) {
+		rte_mempool_put(disk->req_pool, req);
+		goto drop;
+	}
+	/* if full, evict the least recently written slot */
+	if(likely(is_cs_disk_full(disk))) {
+		if(likely(disk->slots[disk->bottom].active)) {
+			disk->table[disk->slots[disk->bottom].bucket].busy[disk->slots[disk->bottom].tab] = 0;
+			disk->slots[disk->bottom].active = 0;
+		}
+		disk->bottom = (disk->bottom + 1) % disk->max_elements;
+	}
+	disk->table[bucket].busy[entry] = 1;
+	disk->table[bucket].entry[entry].crc = crc;
+	disk->table[bucket].entry[entry].index = disk->top;
+	disk->slots[disk->top].active = 1;
+	disk->slots[disk->top].bucket = bucket;
+	disk->slots[disk->top].tab = entry;
+	disk->slots[disk->top].len = req->len;
+	disk->slots[disk->top].expiry = expiry;
+	disk->top = (disk->top + 1) % disk->max_elements;
+	disk->written++;
+	disk->writes++;
+	return 0;
+
+drop:
+	disk->write_drops++;
+	rte_pktmbuf_free(mbuf);
+	return -ENOSPC;
+}
+
+
+int32_t cs_disk_lookup(cs_disk_t *disk, uint32_t crc, uint32_t now) {
+	uint32_t bucket, slot;
+	uint8_t entry;
+	bucket = crc % disk->num_buckets;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (likely(disk->table[bucket].busy[entry] == 0)) {
+			continue;
+		}
+		if(unlikely(disk->table[bucket].entry[entry].crc != crc)) {
+			continue;
+		}
+		slot = disk->table[bucket].entry[entry].index;
+		if(unlikely(cs_is_expired(disk->slots[slot].expiry, now))) {
+			/* The slot is reclaimed when the log wraps around */
+			disk->table[bucket].busy[entry] = 0;
+			disk->slots[slot].active = 0;
+			continue;
+		}
+		return (int32_t) slot;
+	}
+	return -ENOENT;
+}
+
+
+void cs_disk_remove(cs_disk_t *disk, uint32_t slot) {
+	if(disk->slots[slot].active) {
+		disk->table[disk->slots[slot].bucket].busy[disk->slots[slot].tab] = 0;
+		disk->slots[slot].active = 0;
+	}
+}
+
+
+int8_t cs_disk_read(cs_disk_t *disk, uint32_t slot, uint32_t crc,
+		struct rte_mbuf *buf, struct rte_mbuf *interest, uint8_t port) {
+	struct cs_disk_req *req;
+	uint16_t len;
+
+	len = disk->slots[slot].len;
+	if(unlikely(rte_pktmbuf_append(buf, len) == NULL)) {
+		return -ENOSPC;
+	}
+	if(unlikely(rte_mempool_get(disk->req_pool, (void **) &req) < 0)) {
+		return -ENOSPC;
+	}
+	req->op = CS_DISK_OP_READ;
+	req->status = 0;
+	req->port = port;
+	req->slot = slot;
+	req->crc = crc;
+	req->len = len;
+	req->mbuf = buf;
+	req->interest = interest;
+	if(unlikely(rte_ring_sp_enqueue(disk->req_ring, req) < 0)) {
+		rte_mempool_put(disk->req_pool, req);
+		return -ENOSPC;
+	}
+	disk->reads++;
+	return 0;
+}
+
+
+/*
+ * Perform an I/O request. Writes are completed here, reads are handed back
+ * to the lcore owning the tier.
+ */
+static inline
+void cs_disk_do_io(cs_disk_t *disk, struct cs_disk_req *req) {
+	off_t offset;
+	ssize_t ret;
+
+	offset = (off_t) (disk->base + (uint64_t) req->slot * CS_DISK_SLOT_SIZE);
+	if(req->op == CS_DISK_OP_WRITE) {
+		/*
+		 * A failed write is not reported: a later read of the slot fails
+		 * name verification and is counted as a read error
+		 */
+		ret = pwrite(disk->fd, rte_pktmbuf_mtod(req->mbuf, void *), req->len, offset);
+		RTE_SET_USED(ret);
+		rte_pktmbuf_free(req->mbuf);
+		rte_mempool_put(disk->req_pool, req);
+		return;
+	}
+	ret = pread(disk->fd, rte_pktmbuf_mtod(req->mbuf, void *), req->len, offset);
+	req->status = (ret == req->len) ? 0 : -1;
+	rte_ring_sp_enqueue(disk->cpl_ring, req);
+}
+
+
+/* Main loop of the helper thread */
+static void *cs_disk_io_loop(void *arg) {
+	struct cs_disk_io_conf *conf = (struct cs_disk_io_conf *) arg;
+	struct cs_disk_req *reqs[CS_DISK_IO_BURST];
+	unsigned i, j, n, idle;
+
+	while (likely(!conf->stop)) {
+		idle = 1;
+		for (i = 0; i < conf->nb_disks; i++) {
+			n = rte_ring_sc_dequeue_burst(conf->disks[i]->req_ring,
+					(void **) reqs, CS_DISK_IO_BURST);
+			for (j = 0; j < n; j++) {
+				cs_disk_do_io(conf->disks[i], reqs[j]);
+			}
+			if (n > 0) {
+				idle = 0;
+			}
+		}
+		if (idle) {
+			usleep(CS_DISK_IO_IDLE_US);
+		}
+	}
+	return NULL;
+}
+
+
+int cs_disk_io_start(cs_disk_t **disks, unsigned nb_disks) {
+	struct cs_disk_io_conf *conf;
+	unsigned i;
+
+	if(nb_disks > APP_MAX_LCORES || io_conf != NULL) {
+		return -1;
+	}
+	conf = (struct cs_disk_io_conf *) malloc(sizeof(struct cs_disk_io_conf));
+	if(conf == NULL) {
+		return -1;
+	}
+	conf->stop = 0;
+	conf->nb_disks = nb_disks;
+	for (i = 0; i < nb_disks; i++) {
+		conf->disks[i] = disks[i];
+	}
+	if(pthread_create(&conf->thread, NULL, cs_disk_io_loop, conf) != 0) {
+		free(conf);
+		return -1;
+	}
+	io_conf = conf;
+	return 0;
+}
+
+
+void cs_disk_io_stop(void) {
+	if(io_conf == NULL) {
+		return;
+	}
+	io_conf->stop = 1;
+	pthread_join(io_conf->thread, NULL);
+	free(io_conf);
+	io_conf = NULL;
+}
+
+
+void cs_disk_free(cs_disk_t *disk) {
+	if(disk == NULL) {
+		return;
+	}
+	if(disk->table != NULL) {
+		rte_free(disk->table);
+	}
+	if(disk->slots != NULL) {
+		rte_free(disk->slots);
+	}
+	rte_free(disk->req_ring);
+	rte_free(disk->cpl_ring);
+#if RTE_VERSION >= RTE_VERSION_NUM(16, 7, 0, 0)
+	rte_mempool_free(disk->req_pool);
+#endif
+	rte_free(disk);
+	return;
+}
@@ -0,0 +1,298 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _CS_DISK_H_
+#define _CS_DISK_H_
+
+/**
+ * @file
+ *
+ * Disk tier of the Content Store (CS)
+ *
+ * Packets evicted from the in-memory CS are written in fixed-size slots of a
+ * region of a file or block device. Like the in-memory CS, a disk tier is a
+ * circular log of slots evicted in FIFO order, indexed by a linear open index
+ * hash table. Only a compact index (CRC hash of the name, bucket pointers and
+ * packet length) is kept in memory: names are verified when a slot is read
+ * back.
+ *
+ * All I/O operations are performed by a helper thread so that forwarding
+ * lcores never block. Each disk tier has a request ring, on which its lcore
+ * posts read and write requests, and a completion ring, which the lcore polls
+ * for completed reads. Since the helper thread serves the requests of a tier
+ * in order, a read always returns the content that the index pointed to when
+ * the read was posted.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include <rte_memory.h>
+#include <rte_mbuf.h>
+#include <rte_ring.h>
+#include <rte_mempool.h>
+
+#include <config.h>
+
+#include "cs.h"
+
+/**
+ * Type of disk tier I/O requests
+ */
+#define CS_DISK_OP_WRITE 0
+#define CS_DISK_OP_READ  1
+
+/**
+ * Entry of the disk tier index
+ *
+ * This is one element of the disk tier ring. It is deliberately small because
+ * a disk tier has many more slots than the in-memory CS.
+ */
+struct cs_disk_slot {		// Size: 12 bytes
+	uint32_t bucket;		/**< bucket in the table, need this pointer for eviction */
+	uint8_t tab;			/**< tab in bucket, need this pointer for eviction */
+	uint8_t active;			/**< flag indicating whether this slot is used */
+	uint16_t len;			/**< length of the packet stored in the slot */
+	uint32_t expiry;		/**< expiration time in CS time units, as in the in-memory CS */
+} __attribute__((__packed__));
+
+/**
+ * I/O request exchanged between a forwarding lcore and the helper thread
+ */
+struct cs_disk_req {
+	uint8_t op;					/**< CS_DISK_OP_WRITE or CS_DISK_OP_READ */
+	int8_t status;				/**< 0 if the I/O succeeded, -1 otherwise */
+	uint8_t port;				/**< face from which the parked Interest was received */
+	uint16_t len;				/**< number of bytes to write or read */
+	uint32_t slot;				/**< slot of the disk tier */
+	uint32_t crc;				/**< CRC32 hash of the name */
+	struct rte_mbuf *mbuf;		/**< packet to write or buffer to read into */
+	struct rte_mbuf *interest;	/**< parked Interest, answered when the read completes */
+} __rte_cache_aligned;
+
+/**
+ * Disk tier of a Content Store
+ */
+typedef struct cs_disk {
+	struct cs_bucket *table;		/**< pointer to hash table */
+	struct cs_disk_slot *slots;		/**< pointer to ring of slots */
+	uint32_t max_elements;			/**< size of the slot ring */
+	uint32_t num_buckets;			/**< number of buckets in the hash table */
+	uint32_t top;					/**< index of top (most recently written) slot */
+	uint32_t bottom;				/**< index of bottom (least recently written) slot */
+	uint32_t written;				/**< number of slots written, i.e. sequence number of the next slot */
+	int fd;							/**< file descriptor of file or block device */
+	uint64_t base;					/**< offset of the region of this tier in the file */
+	struct rte_ring *req_ring;		/**< requests posted by the lcore */
+	struct rte_ring *cpl_ring;		/**< reads completed by the helper thread */
+	struct rte_mempool *req_pool;	/**< pool of I/O requests */
+	uint32_t writes;				/**< number of packets written */
+	uint32_t write_drops;			/**< number of packets not written (ring or pool full) */
+	uint32_t reads;					/**< number of reads posted */
+	uint32_t read_errors;			/**< number of reads failed or not matching */
+} __rte_cache_aligned cs_disk_t;
+
+
+/**
+ * Return whether the disk tier is full or not
+ *
+ * @param disk
+ *   pointer to the disk tier
+ *
+ * @return
+ *   1 if the disk tier is full, 0 otherwise
+ */
+static inline
+uint8_t is_cs_disk_full(cs_disk_t *disk) {
+	return ((disk->top + 1) % disk->max_elements) == disk->bottom;
+}
+
+/**
+ * Return the sequence number of a slot, i.e. the number of slots written
+ * before it
+ *
+ * @param disk
+ *   pointer to the disk tier
+ * @param slot
+ *   slot, between bottom and top
+ *
+ * @return
+ *   sequence number of the slot
+ */
+static inline
+uint32_t cs_disk_seq(cs_disk_t *disk, uint32_t slot) {
+	return disk->written - (disk->top + disk->max_elements - slot) % disk->max_elements;
+}
+
+/**
+ * Create a disk tier
+ *
+ * @param fd
+ *   File descriptor of the file or block device storing the packets
+ * @param base
+ *   Offset in the file of the region used by this tier
+ * @param num_buckets
+ *   The number of buckets in the index hash table
+ * @param max_elements
+ *   Max number of packets stored, i.e. number of slots of the region
+ * @param socket
+ *   ID of the NUMA socket on which the index will be created
+ * @param id
+ *   Unique identifier of the tier, used to name its rings and pools
+ *
+ * @return
+ *   pointer to the disk tier, NULL if it could not be created
+ */
+cs_disk_t *cs_disk_create(int fd, uint64_t base, int num_buckets,
+		int max_elements, int socket, unsigned id);
+
+/**
+ * Write a packet evicted from the in-memory CS to the disk tier
+ *
+ * If the disk tier is full, the least recently written slot is overwritten.
+ * The mbuf is owned by the disk tier after this call: it is freed once
+ * written, or immediately if it cannot be written.
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param mbuf
+ *   Pointer to the mbuf storing the Data packet
+ * @param crc
+ *   CRC32 hash of the name of the Data packet
+ * @param expiry
+ *   Expiration time of the Data packet in CS time units
+ *
+ * @return
+ *  - 0 if the write has been posted
+ *  - -ENOSPC if the packet does not fit a slot or no request could be posted
+ */
+int8_t cs_disk_spill(cs_disk_t *disk, struct rte_mbuf *mbuf, uint32_t crc,
+		uint32_t expiry);
+
+/**
+ * Look up a CRC32 hash in the index of the disk tier
+ *
+ * Since names are not stored in the index, a hit needs to be verified once
+ * the slot has been read.
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param crc
+ *   CRC32 hash of the name
+ * @param now
+ *   Current time in CS time units. Expired slots are removed from the index
+ *
+ * @return
+ *  - the slot storing a packet whose name has the given hash
+ *  - -ENOENT if there is no such slot
+ */
+int32_t cs_disk_lookup(cs_disk_t *disk, uint32_t crc, uint32_t now);
+
+/**
+ * Remove a slot from the index of the disk tier. It is reclaimed when the log
+ * wraps around
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param slot
+ *   Slot to remove, as returned by cs_disk_lookup
+ */
+void cs_disk_remove(cs_disk_t *disk, uint32_t slot);
+
+/**
+ * Post the read of a slot, parking the Interest that triggered it
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param slot
+ *   Slot to read, as returned by cs_disk_lookup
+ * @param crc
+ *   CRC32 hash of the name
+ * @param buf
+ *   Empty mbuf in which the packet is read
+ * @param interest
+ *   Interest to park until the read completes
+ * @param port
+ *   Face from which the Interest was received
+ *
+ * @return
+ *  - 0 if the read has been posted
+ *  - -ENOSPC if no request could be posted
+ */
+int8_t cs_disk_read(cs_disk_t *disk, uint32_t slot, uint32_t crc,
+		struct rte_mbuf *buf, struct rte_mbuf *interest, uint8_t port);
+
+/**
+ * Retrieve completed reads
+ *
+ * The caller owns the mbufs of the returned requests and must release each
+ * request with cs_disk_req_free.
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param reqs
+ *   Array in which pointers to completed requests are written
+ * @param n
+ *   Max number of requests to retrieve
+ *
+ * @return
+ *   Number of completed requests retrieved
+ */
+static inline
+unsigned cs_disk_poll(cs_disk_t *disk, struct cs_disk_req **reqs, unsigned n) {
+	return rte_ring_sc_dequeue_burst(disk->cpl_ring, (void **) reqs, n);
+}
+
+/**
+ * Release a request retrieved with cs_disk_poll
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ * @param req
+ *   Pointer to the request
+ */
+static inline
+void cs_disk_req_free(cs_disk_t *disk, struct cs_disk_req *req) {
+	rte_mempool_put(disk->req_pool, req);
+}
+
+/**
+ * Start the helper thread performing the I/O requests of all disk tiers
+ *
+ * @param disks
+ *   Array of pointers to disk tiers
+ * @param nb_disks
+ *   Number of disk tiers
+ *
+ * @return
+ *   0 if the thread has been started, -1 otherwise
+ */
+int cs_disk_io_start(cs_disk_t **disks, unsigned nb_disks);
+
+/**
+ * Stop the helper thread, once the lcores posting requests are stopped, and
+ * wait for it to exit. Requests still queued are not performed. Must be
+ * called before the file of the disk tiers is closed
+ */
+void cs_disk_io_stop(void);
+
+/**
+ * Free the memory allocated for the disk tier. Its pool of requests is only
+ * freed with DPDK 16.07 or later
+ *
+ * The file descriptor is not closed, because it can be shared by other tiers.
+ *
+ * @param disk
+ *   Pointer to the disk tier
+ */
+void cs_disk_free(cs_disk_t *disk);
+
+#endif /* _CS_DISK_H_ */
@@ -0,0 +1,349 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <rte_hash_crc.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_branch_prediction.h>
+#include <rte_common.h>
+#include <rte_atomic.h>
+#include <rte_mbuf.h>
+
+#include <config.h>
+
+#include "cs_shared.h"
+
+
+cs_shared_t *cs_shared_create(uint32_t num_buckets, uint32_t max_elements,
+		uint32_t nb_shards, int socket) {
+	cs_shared_t *cs;
+	struct cs_shared_shard *shard;
+	uint32_t i;
+	void *p;
+
+	p = rte_zmalloc_socket("CS_SHARED", sizeof(cs_shared_t), RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		return NULL;
+	}
+	cs = (cs_shared_t *) p;
+
+	cs->nb_shards = nb_shards;
+	cs->num_buckets = RTE_MAX(num_buckets / nb_shards, 1U);
+	/* One more ring entry to distinguish between full and empty ring */
+	cs->max_elements = RTE_MAX(max_elements / nb_shards, 1U) + 1;
+	/*
+	 * At most one mbuf is evicted per insertion and lcores go through a
+	 * quiescent state at each iteration of their loop, so a limbo list as
+	 * large as the ring is never expected to fill up
+	 */
+	cs->limbo_size = cs->max_elements;
+	printf("Shared CS size %u (%u shards)\n", cs->max_elements * nb_shards, nb_shards);
+
+	p = rte_zmalloc_socket("CS_SHARED_SHARDS", nb_shards*sizeof(struct cs_shared_shard),
+			RTE_CACHE_LINE_SIZE, socket);
+	if(p == NULL) {
+		return NULL;
+	}
+	cs->shards = (struct cs_shared_shard *) p;
+
+	for (i = 0; i < nb_shards; i++) {
+		shard = &cs->shards[i];
+		rte_spinlock_init(&shard->lock);
+		p = rte_zmalloc_socket("CS_SHARED_TABLE", cs->num_buckets*sizeof(struct cs_shared_bucket),
+				RTE_CACHE_LINE_SIZE, socket);
+		if(p == NULL) {
+			return NULL;
+		}
+		shard->table = (struct cs_shared_bucket *) p;
+		p = rte_zmalloc_socket("CS_SHARED_RING", cs->max_elements*sizeof(struct cs_entry),
+				RTE_CACHE_LINE_SIZE, socket);
+		if(p == NULL) {
+			return NULL;
+		}
+		shard->ring = (struct cs_entry *) p;
+		p = rte_zmalloc_socket("CS_SHARED_LIMBO", cs->limbo_size*sizeof(struct cs_shared_limbo_entry),
+				RTE_CACHE_LINE_SIZE, socket);
+		if(p == NULL) {
+			return NULL;
+		}
+		shard->limbo = (struct cs_shared_limbo_entry *) p;
+	}
+	return cs;
+}
+
+
+/* Mark the start of a modification of a bucket, failing concurrent lookups */
+static inline
+void cs_shared_write_begin(struct cs_shared_bucket *bucket) {
+	bucket->seq++;
+	rte_smp_wmb();
+}
+
+
+/* Mark the end of a modification of a bucket */
+static inline
+void cs_shared_write_end(struct cs_shared_bucket *bucket) {
+	rte_smp_wmb();
+	bucket->seq++;
+}
+
+
+/*
+ * Free the mbufs evicted before the oldest quiescent state of all registered
+ * lcores. Called with the shard lock held
+ */
+static inline
+void cs_shared_reclaim(cs_shared_t *cs, struct cs_shared_shard *shard) {
+	uint64_t min_quiescent = UINT64_MAX;
+	unsigned lcore_id;
+
+	if(shard->limbo_head == shard->limbo_tail) {
+		return;
+	}
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if(cs->lcore[lcore_id].registered &&
+				cs->lcore[lcore_id].quiescent < min_quiescent) {
+			min_quiescent = cs->lcore[lcore_id].quiescent;
+		}
+	}
+	while (shard->limbo_head != shard->limbo_tail &&
+			shard->limbo[shard->limbo_head].tsc < min_quiescent) {
+		rte_pktmbuf_free(shard->limbo[shard->limbo_head].mbuf);
+		shard->limbo_head = (shard->limbo_head + 1) % cs->limbo_size;
+	}
+}
+
+
+int8_t cs_shared_insert_with_hash(cs_shared_t *cs, uint8_t *name,
+		uint8_t name_len, struct rte_mbuf *mbuf, uint32_t crc,
+		uint32_t freshness_ms) {
+	struct cs_shared_shard *shard;
+	struct cs_shared_bucket *bucket, *old;
+	struct cs_entry *e;
+	uint8_t entry;
+	int8_t ret = -ENOSPC;
+
+	shard = &cs->shards[crc % cs->nb_shards];
+	bucket = &shard->table[(crc / cs->nb_shards) % cs->num_buckets];
+
+	if(unlikely(!rte_spinlock_trylock(&shard->lock))) {
+		cs->lcore[rte_lcore_id()].lock_waits++;
+		rte_spinlock_lock(&shard->lock);
+	}
+	cs_shared_reclaim(cs, shard);
+
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (likely((bucket->busy & (1 << entry)) == 0)) {
+			break;
+		}
+	}
+	if(unlikely(entry == BUCKET_SIZE)) {
+		goto out;
+	}
+	/* if full, evict a content, in FIFO fashion, skipping purged entries */
+	while (unlikely(shard->bottom != shard->top && shard->ring[shard->bottom].active == 0)) {
+		shard->bottom = (shard->bottom + 1) % cs->max_elements;
+	}
+	if(likely(((shard->top + 1) % cs->max_elements) == shard->bottom)) {
+		if(unlikely(((shard->limbo_tail + 1) % cs->limbo_size) == shard->limbo_head)) {
+			goto out;
+		}
+		e = &shard->ring[shard->bottom];
+		old = &shard->table[e->bucket];
+		cs_shared_write_begin(old);
+		old->busy &= ~(1 << e->tab);
+		e->active = 0;
+		cs_shared_write_end(old);
+		/* Lookups may still be using the mbuf, free it later */
+		shard->limbo[shard->limbo_tail].mbuf = e->mbuf;
+		shard->limbo[shard->limbo_tail].tsc = rte_rdtsc();
+		shard->limbo_tail = (shard->limbo_tail + 1) % cs->limbo_size;
+		shard->bottom = (shard->bottom + 1) % cs->max_elements;
+	}
+	/* Now insert new content */
+	e = &shard->ring[shard->top];
+	cs_shared_write_begin(bucket);
+	bucket->busy |= (1 << entry);
+	bucket->entry[entry].crc = crc;
+	bucket->entry[entry].index = shard->top;
+	e->active = 1;
+	e->bucket = bucket - shard->table;
+	e->tab = entry;
+	e->name_len = name_len;
+	rte_memcpy(e->name, name, name_len);
+	e->mbuf = mbuf;
+	e->expiry = cs_expiry(cs->lcore[rte_lcore_id()].now, freshness_ms);
+	cs_shared_write_end(bucket);
+	shard->top = (shard->top + 1) % cs->max_elements;
+	shard->inserted++;
+	ret = 0;
+
+out:
+	rte_spinlock_unlock(&shard->lock);
+	return ret;
+}
+
+
+struct rte_mbuf *cs_shared_lookup_with_hash(cs_shared_t *cs, uint8_t *name,
+		uint8_t name_len, uint32_t crc) {
+	struct cs_shared_shard *shard;
+	struct cs_shared_bucket *bucket;
+	struct cs_entry *e;
+	struct rte_mbuf *mbuf;
+	uint32_t seq;
+	uint8_t entry, busy;
+
+	shard = &cs->shards[crc % cs->nb_shards];
+	bucket = &shard->table[(crc / cs->nb_shards) % cs->num_buckets];
+
+retry:
+	seq = bucket->seq;
+	if(unlikely(seq & 1)) {
+		/* A writer is modifying the bucket */
+		cs->lcore[rte_lcore_id()].read_retries++;
+		rte_pause();
+		goto retry;
+	}
+	rte_smp_rmb();
+	mbuf = NULL;
+	busy = bucket->busy;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (likely((busy & (1 << entry)) == 0)) {
+			continue;
+		}
+		if(unlikely(bucket->entry[entry].crc != crc)) {
+			continue;
+		}
+		/* found element with matching CRC, now verify if name matches */
+		e = &shard->ring[bucket->entry[entry].index];
+		if(unlikely(name_len != e->name_len)) {
+			continue;
+		}
+		if (unlikely(memcmp(name, e->name, name_len) != 0)) {
+			continue;
+		}
+		if (likely(!cs_is_expired(e->expiry, cs->lcore[rte_lcore_id()].now))) {
+			mbuf = e->mbuf;
+		}
+		break;
+	}
+	rte_smp_rmb();
+	if(unlikely(bucket->seq != seq)) {
+		/* The bucket or the entry changed while being read */
+		cs->lcore[rte_lcore_id()].read_retries++;
+		goto retry;
+	}
+	/*
+	 * The mbuf cannot have been freed yet even if it was evicted meanwhile,
+	 * because this lcore has not gone through a quiescent state since
+	 */
+	if(mbuf != NULL) {
+		rte_pktmbuf_refcnt_update(mbuf, 1);
+	}
+	return mbuf;
+}
+
+
+/* Return the number of entries in the ring of a shard */
+static inline
+uint32_t cs_shared_occupancy(cs_shared_t *cs, struct cs_shared_shard *shard) {
+	return (shard->top + cs->max_elements - shard->bottom) % cs->max_elements;
+}
+
+
+uint32_t cs_shared_purge(cs_shared_t *cs, const uint8_t *prefix, uint8_t prefix_len) {
+	struct cs_shared_shard *shard;
+	struct cs_shared_bucket *bucket;
+	struct cs_entry *e;
+	uint32_t i, n, index, sweep, end, bottom_seq, purged = 0;
+	uint8_t limbo_full;
+
+	for (i = 0; i < cs->nb_shards; i++) {
+		shard = &cs->shards[i];
+		rte_spinlock_lock(&shard->lock);
+		/* Only entries inserted before the request need to be purged */
+		end = shard->inserted;
+		sweep = end - cs_shared_occupancy(cs, shard);
+		rte_spinlock_unlock(&shard->lock);
+
+		while ((int32_t) (sweep - end) < 0) {
+			limbo_full = 0;
+			rte_spinlock_lock(&shard->lock);
+			cs_shared_reclaim(cs, shard);
+			bottom_seq = shard->inserted - cs_shared_occupancy(cs, shard);
+			if((int32_t) (sweep - bottom_seq) < 0) {
+				sweep = bottom_seq;
+			}
+			for (n = 0; n < CS_SHARED_PURGE_BATCH && (int32_t) (sweep - end) < 0; n++) {
+				index = (shard->top + cs->max_elements - (shard->inserted - sweep))
+						% cs->max_elements;
+				e = &shard->ring[index];
+				if(e->active && cs_name_has_prefix(prefix, prefix_len, e->name, e->name_len)) {
+					if(((shard->limbo_tail + 1) % cs->limbo_size) == shard->limbo_head) {
+						limbo_full = 1;
+						break;
+					}
+					bucket = &shard->table[e->bucket];
+					cs_shared_write_begin(bucket);
+					bucket->busy &= ~(1 << e->tab);
+					e->active = 0;
+					cs_shared_write_end(bucket);
+					shard->limbo[shard->limbo_tail].mbuf = e->mbuf;
+					shard->limbo[shard->limbo_tail].tsc = rte_rdtsc();
+					shard->limbo_tail = (shard->limbo_tail + 1) % cs->limbo_size;
+					purged++;
+				}
+				sweep++;
+			}
+			rte_spinlock_unlock(&shard->lock);
+			/* Let lcores go through a quiescent state before going on */
+			if(limbo_full) {
+				usleep(CS_SHARED_PURGE_WAIT_US);
+			}
+		}
+	}
+	return purged;
+}
+
+
+void cs_shared_free(cs_shared_t *cs) {
+	struct cs_shared_shard *shard;
+	uint32_t i, j;
+
+	if(cs == NULL) {
+		return;
+	}
+	for (i = 0; cs->shards != NULL && i < cs->nb_shards; i++) {
+		shard = &cs->shards[i];
+		if(shard->ring != NULL) {
+			for (j = 0; j < cs->max_elements; j++) {
+				if(shard->ring[j].active) {
+					rte_pktmbuf_free(shard->ring[j].mbuf);
+				}
+			}
+			rte_free(shard->ring);
+		}
+		if(shard->limbo != NULL) {
+			for (j = shard->limbo_head; j != shard->limbo_tail; j = (j + 1) % cs->limbo_size) {
+				rte_pktmbuf_free(shard->limbo[j].mbuf);
+			}
+			rte_free(shard->limbo);
+		}
+		if(shard->table != NULL) {
+			rte_free(shard->table);
+		}
+	}
+	if(cs->shards != NULL) {
+		rte_free(cs->shards);
+	}
+	rte_free(cs);
+	return;
+}
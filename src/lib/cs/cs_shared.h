@@ -0,0 +1,263 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _CS_SHARED_H_
+#define _CS_SHARED_H_
+
+/**
+ * @file
+ *
+ * Shared Content Store (CS)
+ *
+ * Content Store shared by all forwarding lcores of a NUMA socket, which allows
+ * an lcore to serve content cached by another one, e.g. when a Data is not
+ * received on the same queue as the Interest which requested it.
+ *
+ * The CS is split in shards, each of them with its own hash table, FIFO ring
+ * and lock. Writers (insertions and evictions) lock the shard of the name.
+ * Readers do not take any lock: each bucket has a sequence number which a
+ * writer makes odd while it modifies the bucket or one of the entries it
+ * points to. A reader retries its lookup if the sequence number changed while
+ * it was reading.
+ *
+ * A reader takes a reference on the mbuf it found, so the mbuf of an evicted
+ * entry cannot be freed immediately: an lcore may have read the pointer but
+ * not yet incremented the reference counter. Evicted mbufs are parked in a
+ * per-shard limbo list and freed once all lcores using the CS have gone
+ * through a quiescent state, i.e. they have been reported by
+ * cs_shared_quiescent() after the eviction.
+ *
+ * Expired entries are not served but, since lookups do not write the CS,
+ * they are only removed by FIFO eviction. Purges of a prefix are performed by
+ * the control plane, which sweeps each shard in small batches so that the
+ * lock of a shard is never held for long.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <rte_memory.h>
+#include <rte_cycles.h>
+#include <rte_spinlock.h>
+#include <rte_lcore.h>
+
+#include <config.h>
+
+#include "cs.h"
+
+/**
+ * A bucket of the hash table of the shared CS
+ *
+ * Compared to a bucket of the per-lcore CS, the busy flags are packed in a
+ * bitmap to make room for the sequence number in the same cache line
+ */
+struct cs_shared_bucket {	// Size: 64 bytes = 1 cache line
+	volatile uint32_t seq;	/**< sequence number, odd while the bucket is modified */
+	uint8_t busy;			/**< bitmap of busy entries */
+	struct cs_table_entry entry[BUCKET_SIZE];	/**< Hash-table entry */
+}  __attribute__((__packed__)) __rte_cache_aligned;
+
+/**
+ * Evicted mbuf waiting to be freed
+ */
+struct cs_shared_limbo_entry {
+	struct rte_mbuf *mbuf;	/**< evicted mbuf */
+	uint64_t tsc;			/**< time of eviction */
+};
+
+/**
+ * Shard of a shared CS
+ */
+struct cs_shared_shard {
+	rte_spinlock_t lock;		/**< lock taken by writers */
+	struct cs_shared_bucket *table;	/**< pointer to hash table */
+	struct cs_entry *ring;		/**< pointer to ring of CS entries */
+	uint32_t top;				/**< index of top (most recently inserted) entry */
+	uint32_t bottom;			/**< index of bottom (least recently inserted) entry */
+	struct cs_shared_limbo_entry *limbo;	/**< ring of evicted mbufs */
+	uint32_t limbo_head;		/**< index of the oldest evicted mbuf */
+	uint32_t limbo_tail;		/**< index of the next free limbo entry */
+	uint32_t inserted;			/**< number of entries inserted, i.e. sequence number of the next entry */
+} __rte_cache_aligned;
+
+/**
+ * State of an lcore using the shared CS
+ *
+ * Each lcore writes only its own cache line
+ */
+struct cs_shared_lcore {
+	volatile uint64_t quiescent;	/**< time of the last quiescent state */
+	uint32_t now;				/**< time of the last quiescent state in CS time units */
+	uint8_t registered;			/**< flag indicating whether the lcore uses the CS */
+	uint32_t read_retries;		/**< number of lookups retried due to a concurrent write */
+	uint32_t lock_waits;		/**< number of writes which found the shard locked */
+} __rte_cache_aligned;
+
+/**
+ * Shared Content Store
+ */
+typedef struct {
+	struct cs_shared_shard *shards;	/**< array of shards */
+	uint32_t nb_shards;			/**< number of shards */
+	uint32_t num_buckets;		/**< number of buckets in the hash table of a shard */
+	uint32_t max_elements;		/**< size of the ring of a shard */
+	uint32_t limbo_size;		/**< size of the limbo ring of a shard */
+	struct cs_shared_lcore lcore[APP_MAX_LCORES];	/**< state of lcores */
+} __rte_cache_aligned cs_shared_t;
+
+
+/**
+ * Create a shared Content Store
+ *
+ * @param num_buckets
+ *   The total number of buckets in the CS hash tables
+ * @param max_elements
+ *   Max number of elements supported
+ * @param nb_shards
+ *   Number of shards
+ * @param socket
+ *   ID of the NUMA socket on which the CS will be created
+ *
+ * @return
+ *   pointer to the CS, NULL if it could not be created
+ */
+cs_shared_t *cs_shared_create(uint32_t num_buckets, uint32_t max_elements,
+		uint32_t nb_shards, int socket);
+
+/**
+ * Register an lcore as user of the shared CS
+ *
+ * Must be called for all lcores before any of them accesses the CS
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param lcore_id
+ *   ID of the lcore
+ */
+static inline
+void cs_shared_register(cs_shared_t *cs, unsigned lcore_id) {
+	cs->lcore[lcore_id].registered = 1;
+	cs->lcore[lcore_id].quiescent = 0;
+}
+
+/**
+ * Unregister an lcore which stops using the shared CS, so that it does not
+ * prevent evicted mbufs from being freed
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param lcore_id
+ *   ID of the lcore
+ */
+static inline
+void cs_shared_unregister(cs_shared_t *cs, unsigned lcore_id) {
+	cs->lcore[lcore_id].registered = 0;
+}
+
+/**
+ * Report a quiescent state of the calling lcore, i.e. a point where it does
+ * not hold any pointer read from the CS without a reference on it
+ *
+ * This also sets the current time of the lcore, used to set and check
+ * expiration times of entries
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param lcore_id
+ *   ID of the calling lcore
+ * @param tsc
+ *   Current TSC value
+ */
+static inline
+void cs_shared_quiescent(cs_shared_t *cs, unsigned lcore_id, uint64_t tsc) {
+	cs->lcore[lcore_id].now = cs_time(tsc);
+	cs->lcore[lcore_id].quiescent = tsc;
+}
+
+/**
+ * Insert a new chunk in the shared Content Store, given CRC32 hash of the
+ * chunk name.
+ *
+ * If the shard of the chunk is full, evict an item according to FIFO policy.
+ * The CS owns the reference to the mbuf held by the caller once inserted.
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param name
+ *   Name of the chunk to insert
+ * @param name_len
+ *   Length of the chunk name to insert
+ * @param mbuf
+ *   Pointer to the mbuf storing the Data packet to add to the CS
+ * @param crc
+ *   CRC32 hash of the chunk name
+ * @param freshness_ms
+ *   Freshness period of the chunk in milliseconds, 0 if it does not expire
+ *
+ * @return
+ *  - 0 if inserted correctly
+ *  - -ENOSPC if the hash table bucket or the limbo list is full
+ */
+int8_t cs_shared_insert_with_hash(cs_shared_t *cs, uint8_t *name,
+		uint8_t name_len, struct rte_mbuf *mbuf, uint32_t crc,
+		uint32_t freshness_ms);
+
+/**
+ * Lookup an item in the shared Content Store, given CRC32 hash of the chunk
+ * name
+ *
+ * In case of a hit, a reference is taken on the returned mbuf, which the
+ * caller must release with rte_pktmbuf_free.
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param name
+ *   Name of the chunk to look up
+ * @param name_len
+ *   Length of the chunk name to look up
+ * @param crc
+ *   CRC32 hash of the chunk name
+ *
+ * @return
+ *  - pointer to RTE mbuf containg the Data packet, in case of a hit
+ *  - NULL, in case of a miss or if the chunk expired
+ */
+struct rte_mbuf *cs_shared_lookup_with_hash(cs_shared_t *cs, uint8_t *name,
+		uint8_t name_len, uint32_t crc);
+
+/**
+ * Purge all entries under a name prefix from the shared CS
+ *
+ * Called by the control plane. Entries inserted while the purge is in
+ * progress are not purged. This blocks until all shards have been swept
+ *
+ * @param cs
+ *   Pointer to the CS
+ * @param prefix
+ *   Name prefix
+ * @param prefix_len
+ *   Length of the prefix
+ *
+ * @return
+ *   Number of entries removed
+ */
+uint32_t cs_shared_purge(cs_shared_t *cs, const uint8_t *prefix, uint8_t prefix_len);
+
+/**
+ * Free the memory allocated for the shared CS
+ *
+ * Must only be called once no lcore uses the CS any more
+ *
+ * @param cs
+ *   Pointer to the CS
+ */
+void cs_shared_free(cs_shared_t *cs);
+
+#endif /* _CS_SHARED_H_ */
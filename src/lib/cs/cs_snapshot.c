@@ -0,0 +1,261 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <rte_branch_prediction.h>
+#include <rte_byteorder.h>
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+#include <rte_memcpy.h>
+
+#include <config.h>
+
+#include "cs_snapshot.h"
+
+/**
+ * State of the writer of a snapshot, which goes through the CSs three times:
+ * to count entries, to write them and to write packets
+ */
+struct cs_snapshot_writer {
+	FILE *f;				/**< file being written */
+	uint8_t pass;			/**< 0: count, 1: write entries, 2: write packets */
+	uint32_t nb_entries;	/**< number of entries counted */
+	uint64_t offset;		/**< offset of the next packet */
+	uint32_t now;			/**< current time in CS time units */
+	uint64_t units_per_s;	/**< CS time units per second */
+	int error;				/**< 0, or errno of the first failed write */
+};
+
+
+/* Save a packet of a CS */
+static void
+cs_snapshot_visit(struct cs_snapshot_writer *w, const uint8_t *name,
+		uint8_t name_len, uint32_t crc, uint32_t expiry, struct rte_mbuf *m) {
+	struct cs_snapshot_entry entry;
+
+	/* Packets chained to other mbufs are not saved */
+	if(m->nb_segs != 1 || m->pkt_len > UINT16_MAX || cs_is_expired(expiry, w->now)) {
+		return;
+	}
+	switch (w->pass) {
+	case 0:
+		w->nb_entries++;
+		break;
+	case 1:
+		memset(&entry, 0, sizeof(entry));
+		entry.offset = w->offset;
+		entry.crc = crc;
+		entry.freshness_ms = 0;
+		if(expiry != CS_NO_EXPIRY) {
+			entry.freshness_ms = (uint32_t) RTE_MAX((uint64_t) (expiry - w->now) * 1000 /
+					w->units_per_s, 1ULL);
+		}
+		entry.len = (uint16_t) m->pkt_len;
+		entry.name_len = name_len;
+		memcpy(entry.name, name, name_len);
+		if(fwrite(&entry, sizeof(entry), 1, w->f) != 1 && w->error == 0) {
+			w->error = errno;
+		}
+		w->offset += m->pkt_len;
+		break;
+	default:
+		if(fwrite(rte_pktmbuf_mtod(m, void *), m->pkt_len, 1, w->f) != 1 && w->error == 0) {
+			w->error = errno;
+		}
+		break;
+	}
+}
+
+
+/* Save the packets of a CS, from the least to the most recently inserted */
+static void
+cs_snapshot_visit_cs(struct cs_snapshot_writer *w, cs_t *cs) {
+	struct cs_entry *e;
+	struct cs_seg_block *b;
+	uint8_t name[MAX_NAME_LEN];
+	uint32_t index, seg_id, i;
+
+	for (index = cs->bottom; index != cs->top; index = (index + 1) % cs->max_elements) {
+		e = &cs->ring[index];
+		if(e->active) {
+			cs_snapshot_visit(w, e->name, e->name_len,
+					cs->table[e->bucket].entry[e->tab].crc, e->expiry, e->mbuf);
+		}
+	}
+	if(cs->seg.table == NULL) {
+		return;
+	}
+	for (index = cs->seg.bottom; index != cs->seg.top;
+			index = (index + 1) % cs->seg.max_elements) {
+		b = &cs->seg.ring[index];
+		if(!b->active) {
+			continue;
+		}
+		memcpy(name, b->prefix, b->prefix_len);
+		for (i = 0; i < CS_SEG_BLOCK_SIZE; i++) {
+			if((b->present & (1 << i)) == 0) {
+				continue;
+			}
+			seg_id = rte_cpu_to_be_32(b->block * CS_SEG_BLOCK_SIZE + i);
+			memcpy(name + b->prefix_len, &seg_id, CS_SEG_ID_LEN);
+			cs_snapshot_visit(w, name, b->prefix_len + CS_SEG_ID_LEN, b->crc[i],
+					b->expiry[i], b->mbuf[i]);
+		}
+	}
+}
+
+
+int cs_snapshot_save(const char *path, cs_t **cs, unsigned nb_cs) {
+	struct cs_snapshot_writer w;
+	struct cs_snapshot_hdr hdr;
+	char tmp_path[CS_DISK_PATH_LEN + 8];
+	unsigned i;
+
+	if(snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int) sizeof(tmp_path)) {
+		return -ENAMETOOLONG;
+	}
+	memset(&w, 0, sizeof(w));
+	w.now = cs_time(rte_rdtsc());
+	w.units_per_s = RTE_MAX(rte_get_tsc_hz() >> CS_TIME_SHIFT, 1ULL);
+	for (i = 0; i < nb_cs; i++) {
+		if(cs[i] != NULL) {
+			cs_snapshot_visit_cs(&w, cs[i]);
+		}
+	}
+
+	w.f = fopen(tmp_path, "w");
+	if(w.f == NULL) {
+		return -errno;
+	}
+	w.offset = sizeof(hdr) + (uint64_t) w.nb_entries * sizeof(struct cs_snapshot_entry);
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = CS_SNAPSHOT_MAGIC;
+	hdr.version = CS_SNAPSHOT_VERSION;
+	hdr.nb_entries = w.nb_entries;
+	/* The size is written last, once known */
+	if(fwrite(&hdr, sizeof(hdr), 1, w.f) != 1) {
+		w.error = errno;
+	}
+	for (w.pass = 1; w.pass <= 2 && w.error == 0; w.pass++) {
+		for (i = 0; i < nb_cs; i++) {
+			if(cs[i] != NULL) {
+				cs_snapshot_visit_cs(&w, cs[i]);
+			}
+		}
+	}
+	hdr.size = w.offset;
+	if(w.error == 0 && (fseek(w.f, 0, SEEK_SET) != 0 ||
+			fwrite(&hdr, sizeof(hdr), 1, w.f) != 1)) {
+		w.error = errno;
+	}
+	if(fclose(w.f) != 0 && w.error == 0) {
+		w.error = errno;
+	}
+	if(w.error == 0 && rename(tmp_path, path) != 0) {
+		w.error = errno;
+	}
+	if(w.error != 0) {
+		unlink(tmp_path);
+		return -w.error;
+	}
+	return (int) w.nb_entries;
+}
+
+
+int cs_snapshot_open(const char *path, struct cs_snapshot *snap) {
+	struct stat st;
+	int fd, ret;
+
+	memset(snap, 0, sizeof(*snap));
+	fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		return -errno;
+	}
+	if(fstat(fd, &st) != 0) {
+		ret = -errno;
+		close(fd);
+		return ret;
+	}
+	if((uint64_t) st.st_size < sizeof(struct cs_snapshot_hdr)) {
+		close(fd);
+		return -EINVAL;
+	}
+	snap->addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(snap->addr == MAP_FAILED) {
+		snap->addr = NULL;
+		return -errno;
+	}
+	snap->size = st.st_size;
+	snap->hdr = (const struct cs_snapshot_hdr *) snap->addr;
+	snap->entries = (const struct cs_snapshot_entry *) (snap->hdr + 1);
+	if(snap->hdr->magic != CS_SNAPSHOT_MAGIC || snap->hdr->version != CS_SNAPSHOT_VERSION ||
+			snap->hdr->size != snap->size || sizeof(struct cs_snapshot_hdr) +
+			(uint64_t) snap->hdr->nb_entries * sizeof(struct cs_snapshot_entry) > snap->size) {
+		cs_snapshot_close(snap);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+
+uint32_t cs_snapshot_load(const struct cs_snapshot *snap, cs_t *cs,
+		struct rte_mempool *pool, unsigned reserve, cs_snapshot_owner_t owner,
+		void *arg) {
+	const struct cs_snapshot_entry *entry;
+	const uint8_t *pkt;
+	struct rte_mbuf *m;
+	uint32_t i, loaded = 0;
+
+	for (i = 0; i < snap->hdr->nb_entries; i++) {
+		entry = &snap->entries[i];
+		if(unlikely(entry->offset + entry->len > snap->size ||
+				entry->name_len == 0 || entry->name_len > MAX_NAME_LEN)) {
+			continue;
+		}
+		pkt = (const uint8_t *) snap->addr + entry->offset;
+		if(!owner(pkt, entry->len, entry->crc, arg)) {
+			continue;
+		}
+		if(rte_mempool_count(pool) < reserve) {
+			break;
+		}
+		m = rte_pktmbuf_alloc(pool);
+		if(m == NULL) {
+			break;
+		}
+		if(rte_pktmbuf_append(m, entry->len) == NULL) {
+			rte_pktmbuf_free(m);
+			continue;
+		}
+		rte_memcpy(rte_pktmbuf_mtod(m, void *), pkt, entry->len);
+		if(cs_insert_with_hash(cs, (uint8_t *) entry->name, entry->name_len, m,
+				entry->crc, entry->freshness_ms) < 0) {
+			rte_pktmbuf_free(m);
+			continue;
+		}
+		loaded++;
+	}
+	return loaded;
+}
+
+
+void cs_snapshot_close(struct cs_snapshot *snap) {
+	if(snap->addr != NULL) {
+		munmap(snap->addr, snap->size);
+	}
+	memset(snap, 0, sizeof(*snap));
+}
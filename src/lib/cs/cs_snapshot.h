@@ -0,0 +1,159 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _CS_SNAPSHOT_H_
+#define _CS_SNAPSHOT_H_
+
+/**
+ * @file
+ *
+ * Snapshots of the Content Store (CS)
+ *
+ * The content of the per-lcore CSs can be saved to a file on shutdown and
+ * reloaded on startup, so that caches do not need to warm up again. A
+ * snapshot file has a header, an array of fixed-size entries (index) and
+ * the packets, stored back to back. It is memory mapped when reloaded, so
+ * that all lcores can scan it in parallel, each of them loading the entries
+ * it owns.
+ *
+ * Entries are saved from the least to the most recently inserted, so that
+ * reloading them preserves their FIFO order. Freshness periods are saved as
+ * the time left before expiry.
+ */
+
+#include <stdint.h>
+
+#include <rte_mbuf.h>
+#include <rte_mempool.h>
+
+#include <config.h>
+
+#include "cs.h"
+
+#define CS_SNAPSHOT_MAGIC   0x50414E5353475541ULL	/**< "AUGSSNAP" */
+#define CS_SNAPSHOT_VERSION 1
+
+/**
+ * Header of a snapshot file
+ */
+struct cs_snapshot_hdr {
+	uint64_t magic;				/**< CS_SNAPSHOT_MAGIC */
+	uint32_t version;			/**< CS_SNAPSHOT_VERSION */
+	uint32_t nb_entries;		/**< number of entries */
+	uint64_t size;				/**< size of the file */
+} __attribute__((__packed__));
+
+/**
+ * Entry of a snapshot file
+ */
+struct cs_snapshot_entry {
+	uint64_t offset;			/**< offset of the packet in the file */
+	uint32_t crc;				/**< CRC32 hash of the name */
+	uint32_t freshness_ms;		/**< time left before expiry in milliseconds, 0 if none */
+	uint16_t len;				/**< length of the packet */
+	uint8_t name_len;			/**< length of the name */
+	uint8_t name[MAX_NAME_LEN];	/**< name */
+} __attribute__((__packed__));
+
+/**
+ * Snapshot file mapped in memory
+ */
+struct cs_snapshot {
+	void *addr;					/**< address of the mapping */
+	uint64_t size;				/**< size of the mapping */
+	const struct cs_snapshot_hdr *hdr;		/**< header */
+	const struct cs_snapshot_entry *entries;	/**< entries */
+};
+
+/**
+ * Function telling whether an lcore owns a packet of a snapshot
+ *
+ * @param pkt
+ *   Packet, starting with its Ethernet header
+ * @param len
+ *   Length of the packet
+ * @param crc
+ *   CRC32 hash of the name of the packet
+ * @param arg
+ *   Argument passed to cs_snapshot_load
+ *
+ * @return
+ *   1 if the packet must be loaded, 0 otherwise
+ */
+typedef int (*cs_snapshot_owner_t)(const uint8_t *pkt, uint16_t len, uint32_t crc,
+		void *arg);
+
+/**
+ * Save the content of CSs to a file
+ *
+ * The file is written under a temporary name and then renamed, so that an
+ * existing snapshot, possibly mapped, is replaced atomically.
+ *
+ * @param path
+ *   Path of the file
+ * @param cs
+ *   Array of pointers to CSs, NULL entries are skipped
+ * @param nb_cs
+ *   Number of CSs
+ *
+ * @return
+ *  - number of entries saved
+ *  - -errno if the file could not be written
+ */
+int cs_snapshot_save(const char *path, cs_t **cs, unsigned nb_cs);
+
+/**
+ * Map a snapshot file in memory
+ *
+ * @param path
+ *   Path of the file
+ * @param snap
+ *   Snapshot to initialize
+ *
+ * @return
+ *  - 0 if the snapshot has been mapped
+ *  - -ENOENT if there is no such file
+ *  - -EINVAL if the file is not a valid snapshot
+ *  - -errno if the file could not be mapped
+ */
+int cs_snapshot_open(const char *path, struct cs_snapshot *snap);
+
+/**
+ * Load the entries of a snapshot owned by the calling lcore in its CS
+ *
+ * Loading stops if less than reserve mbufs are left in the pool, so that
+ * packets can still be received.
+ *
+ * @param snap
+ *   Snapshot
+ * @param cs
+ *   CS of the calling lcore
+ * @param pool
+ *   Pool from which mbufs storing the packets are allocated
+ * @param reserve
+ *   Min number of mbufs left in the pool
+ * @param owner
+ *   Function selecting the entries to load
+ * @param arg
+ *   Argument passed to the owner function
+ *
+ * @return
+ *   Number of entries loaded
+ */
+uint32_t cs_snapshot_load(const struct cs_snapshot *snap, cs_t *cs,
+		struct rte_mempool *pool, unsigned reserve, cs_snapshot_owner_t owner,
+		void *arg);
+
+/**
+ * Unmap a snapshot file
+ *
+ * @param snap
+ *   Snapshot
+ */
+void cs_snapshot_close(struct cs_snapshot *snap);
+
+#endif /* _CS_SNAPSHOT_H_ */
@@ -153,6 +153,33 @@ int16_t fib_hash_table_lookup_with_hash(fibh_t* fib_hash_table, uint8_t *name,
 }
 
 
+int8_t fib_hash_table_lookup_nexthops_with_hash(fibh_t* fib_hash_table,
+							uint8_t *name, uint8_t name_len, uint32_t crc,
+							struct fib_nexthop *nexthops) {
+	struct fib_fwd_entry *fwd;
+	uint32_t bucket;
+	uint8_t entry;
+	int8_t n = 0;
+
+	bucket = crc % fib_hash_table->num_buckets;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if (unlikely(fib_hash_table->htbl[bucket].busy[entry] == 0)) {
+			continue;
+		}
+		if(unlikely(fib_hash_table->htbl[bucket].entry[entry].crc != crc)) {
+			continue;
+		}
+		fwd = &fib_hash_table->fwd_table[fib_hash_table->htbl[bucket].entry[entry].index];
+		if(likely(name_len == fwd->name_len && memcmp(name, fwd->name, name_len) == 0)) {
+			nexthops[n].index = fib_hash_table->htbl[bucket].entry[entry].index;
+			nexthops[n].face = fwd->face;
+			n++;
+		}
+	}
+	return n == 0 ? -ENOENT : n;
+}
+
+
 static inline
 int8_t __fib_hash_table_del_key_with_hash(fibh_t* fib_hash_table, uint8_t *name,
 							uint8_t name_len, uint32_t crc, uint8_t face) {
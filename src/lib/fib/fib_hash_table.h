@@ -74,6 +74,19 @@ struct fib_fwd_entry {	// This is equal to a line size (64 B)
 	uint8_t name[MAX_NAME_LEN];  /**< name in FIB entry */
 }__attribute__((__packed__)) __rte_cache_aligned;
 
+/**
+ * Max number of next hops of a name prefix, all stored in the same bucket
+ */
+#define FIB_MAX_NEXTHOPS	BUCKET_SIZE
+
+/**
+ * Next hop of a name prefix, i.e. one of its forwarding entries
+ */
+struct fib_nexthop {
+	uint32_t index;		/**< index of the entry in the forwarding table */
+	uint8_t face;		/**< index of next hop face */
+};
+
 /**
  * FIB hash table
  */
@@ -220,6 +233,28 @@ int16_t fib_hash_table_lookup(fibh_t* fib_hash_table, uint8_t *name,
 int16_t fib_hash_table_lookup_with_hash(fibh_t* fib_hash_table, uint8_t *name,
 							uint8_t name_len, uint32_t crc);
 
+/**
+ * Lookup all the next hops of an entry in the hash table
+ *
+ * @param fib_hash_table
+ *   Pointer to the FIB hash table
+ * @param name
+ *   Name to look up
+ * @param name_len
+ *   Length of the name to look up
+ * @param crc
+ *   The CRC32 hash of the name
+ * @param nexthops
+ *   Array of FIB_MAX_NEXTHOPS elements, set to the next hops of the key
+ *
+ * @return
+ * 	- The number of next hops of the key, if the key is present
+ * 	- -ENOENT if the key is not found.
+ */
+int8_t fib_hash_table_lookup_nexthops_with_hash(fibh_t* fib_hash_table,
+							uint8_t *name, uint8_t name_len, uint32_t crc,
+							struct fib_nexthop *nexthops);
+
 /**
  * Delete a key from the FIB hash table 
  * 
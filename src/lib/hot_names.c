@@ -0,0 +1,44 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+
+#include "hot_names.h"
+
+hot_names_t *hot_names_create(uint32_t hot_threshold, uint32_t cool_threshold,
+		uint64_t epoch_us, int socket) {
+	hot_names_t *h;
+
+	h = rte_zmalloc_socket("HOT_NAMES", sizeof(hot_names_t), RTE_CACHE_LINE_SIZE,
+			socket);
+	if(h == NULL) {
+		return NULL;
+	}
+	h->hot_threshold = RTE_MAX(hot_threshold, 1U);
+	h->cool_threshold = RTE_MAX(RTE_MIN(cool_threshold, h->hot_threshold), 1U);
+	h->epoch_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * epoch_us;
+	/* Epoch 0 marks slots of names never replicated */
+	h->epoch = 1;
+	h->epoch_start = rte_rdtsc();
+	return h;
+}
+
+
+void hot_names_new_epoch(hot_names_t *h, uint64_t tsc) {
+	memset(h->sketch, 0, sizeof(h->sketch));
+	h->epoch++;
+	h->epoch_start = tsc;
+}
+
+
+void hot_names_free(hot_names_t *h) {
+	rte_free(h);
+}
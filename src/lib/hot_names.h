@@ -0,0 +1,204 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _HOT_NAMES_H_
+#define _HOT_NAMES_H_
+
+/**
+ * @file
+ *
+ * Detection of hot names and tracking of their replicas
+ *
+ * Each lcore counts the Interests of the names it owns in a count-min sketch
+ * reset at every epoch. A name whose count reaches the hot threshold within an
+ * epoch is hot: its Data is replicated in the CS of the other lcores, at most
+ * once per epoch. A name replicated in the previous epoch stays hot as long as
+ * its count reaches the cool threshold, lower since its Interests are then
+ * spread over all lcores. Otherwise it cools, is no longer replicated and its
+ * replicas expire.
+ *
+ * Each lcore also records the replicas it holds, so that Interests for their
+ * names are served locally instead of being steered to the owner.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+
+/**
+ * Number of rows of the count-min sketch
+ */
+#define HOT_SKETCH_ROWS 4
+
+/**
+ * Number of counters of each row of the count-min sketch. Must be a power of 2
+ */
+#define HOT_SKETCH_COLS 1024
+
+/**
+ * Number of slots of the tables of hot names and of replicas, each name being
+ * mapped to one slot. Must be a power of 2
+ */
+#define HOT_NAMES_SLOTS 64
+
+/**
+ * Hot name owned by the lcore
+ */
+struct hot_name {
+	uint32_t crc;		/**< CRC32 hash of the name */
+	uint32_t epoch;		/**< last epoch in which the name was replicated */
+};
+
+/**
+ * Replica of a hot name owned by another lcore
+ */
+struct hot_replica {
+	uint32_t crc;		/**< CRC32 hash of the name */
+	uint64_t expiry;	/**< TSC at which the replica expires */
+};
+
+/**
+ * Hot names of an lcore
+ */
+typedef struct hot_names {
+	uint16_t sketch[HOT_SKETCH_ROWS][HOT_SKETCH_COLS];	/**< Interests per name in the current epoch */
+	uint64_t epoch_start;		/**< TSC at which the current epoch started */
+	uint64_t epoch_tsc;			/**< duration of an epoch in TSC cycles */
+	uint32_t epoch;				/**< current epoch, starting from 1 */
+	uint32_t hot_threshold;		/**< Interests per epoch making a name hot */
+	uint32_t cool_threshold;	/**< Interests per epoch keeping a replicated name hot */
+	struct hot_name hot[HOT_NAMES_SLOTS];
+	struct hot_replica replica[HOT_NAMES_SLOTS];
+} __rte_cache_aligned hot_names_t;
+
+/**
+ * Start a new epoch, resetting the sketch
+ *
+ * @param h
+ *   Hot names of the lcore
+ * @param tsc
+ *   Current TSC
+ */
+void hot_names_new_epoch(hot_names_t *h, uint64_t tsc);
+
+/**
+ * Count an Interest for a name owned by the lcore and tell whether its Data
+ * must be replicated now, i.e. whether the name is hot and has not been
+ * replicated yet in the current epoch
+ *
+ * @param h
+ *   Hot names of the lcore
+ * @param crc
+ *   CRC32 hash of the name
+ * @param tsc
+ *   Current TSC
+ *
+ * @return
+ *   1 if the Data of the name must be replicated, 0 otherwise
+ */
+static inline uint8_t
+hot_names_count(hot_names_t *h, uint32_t crc, uint64_t tsc) {
+	/* Odd multipliers spreading the hash over the columns of each row */
+	static const uint32_t mul[HOT_SKETCH_ROWS] = {
+		0x9E3779B1, 0x85EBCA77, 0xC2B2AE3D, 0x27D4EB2F
+	};
+	struct hot_name *slot;
+	uint32_t r, col, estimate = UINT16_MAX;
+	uint16_t *c;
+
+	if (unlikely(tsc - h->epoch_start > h->epoch_tsc)) {
+		hot_names_new_epoch(h, tsc);
+	}
+	for (r = 0; r < HOT_SKETCH_ROWS; r++) {
+		col = (crc * mul[r]) >> (32 - __builtin_ctz(HOT_SKETCH_COLS));
+		c = &h->sketch[r][col];
+		if (likely(*c < UINT16_MAX)) {
+			(*c)++;
+		}
+		estimate = RTE_MIN(estimate, (uint32_t) *c);
+	}
+	if (likely(estimate < h->cool_threshold)) {
+		return 0;
+	}
+	slot = &h->hot[crc & (HOT_NAMES_SLOTS - 1)];
+	if (slot->crc == crc && slot->epoch != 0) {
+		if (slot->epoch == h->epoch) {
+			return 0;
+		}
+		/* Replicated in the previous epoch: its Interests are spread */
+		if (slot->epoch + 1 != h->epoch && estimate < h->hot_threshold) {
+			return 0;
+		}
+	} else if (estimate < h->hot_threshold) {
+		return 0;
+	}
+	slot->crc = crc;
+	slot->epoch = h->epoch;
+	return 1;
+}
+
+/**
+ * Record a replica held by the lcore
+ *
+ * @param h
+ *   Hot names of the lcore
+ * @param crc
+ *   CRC32 hash of the name
+ * @param expiry
+ *   TSC at which the replica expires
+ */
+static inline void
+hot_names_replica_add(hot_names_t *h, uint32_t crc, uint64_t expiry) {
+	struct hot_replica *slot = &h->replica[crc & (HOT_NAMES_SLOTS - 1)];
+	slot->crc = crc;
+	slot->expiry = expiry;
+}
+
+/**
+ * Tell whether the lcore holds a replica of a name which has not expired
+ *
+ * @param h
+ *   Hot names of the lcore
+ * @param crc
+ *   CRC32 hash of the name
+ * @param tsc
+ *   Current TSC
+ */
+static inline uint8_t
+hot_names_is_replica(const hot_names_t *h, uint32_t crc, uint64_t tsc) {
+	const struct hot_replica *slot = &h->replica[crc & (HOT_NAMES_SLOTS - 1)];
+	return slot->crc == crc && tsc < slot->expiry;
+}
+
+/**
+ * Create the hot names of an lcore
+ *
+ * @param hot_threshold
+ *   Interests per epoch making a name hot
+ * @param cool_threshold
+ *   Interests per epoch keeping a replicated name hot
+ * @param epoch_us
+ *   Duration of an epoch in microseconds
+ * @param socket
+ *   NUMA socket on which memory is allocated
+ *
+ * @return
+ *   Pointer to the hot names, NULL if they cannot be allocated
+ */
+hot_names_t *hot_names_create(uint32_t hot_threshold, uint32_t cool_threshold,
+		uint64_t epoch_us, int socket);
+
+/**
+ * Free the hot names of an lcore
+ *
+ * @param h
+ *   Hot names to free
+ */
+void hot_names_free(hot_names_t *h);
+
+#endif /* _HOT_NAMES_H_ */
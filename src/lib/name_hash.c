@@ -0,0 +1,154 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_byteorder.h>
+#include <rte_hash_crc.h>
+
+#include <config.h>
+
+#include "name_hash.h"
+
+/* Hash the 1 to 3 trailing bytes of a name, padded with zeros as rte_hash_crc does */
+static inline uint32_t
+name_hash_tail(uint32_t state, const uint8_t *p, uint32_t len) {
+	uint32_t word = p[0];
+	if (len > 1) {
+		word |= (uint32_t) p[1] << 8;
+	}
+	if (len > 2) {
+		word |= (uint32_t) p[2] << 16;
+	}
+	return rte_hash_crc_4byte(word, state);
+}
+
+
+/*
+ * Return the hash of the first len bytes of a name, given the states of its
+ * lane after each 8-byte word. Like rte_hash_crc, 4 trailing bytes are hashed
+ * as such and other trailing bytes are padded with zeros
+ */
+static inline uint32_t
+name_hash_prefix(const uint32_t *state, const uint8_t *name, uint32_t len) {
+	uint32_t words = len / sizeof(uint64_t);
+	uint32_t hash = state[words];
+	uint32_t word;
+
+	name += words * sizeof(uint64_t);
+	len &= sizeof(uint64_t) - 1;
+	if (len >= sizeof(uint32_t)) {
+		memcpy(&word, name, sizeof(word));
+		hash = rte_hash_crc_4byte(word, hash);
+		name += sizeof(uint32_t);
+		len -= sizeof(uint32_t);
+	}
+	if (len > 0) {
+		hash = name_hash_tail(hash, name, len);
+	}
+	return hash;
+}
+
+
+/* Hash a name and its prefixes on its own, e.g. if it is too long */
+static void
+name_hash_serial(struct icn_packet *pkt, uint16_t nb_prefixes, uint32_t seed,
+		uint32_t *crc) {
+	uint16_t i, len;
+	for (i = 0; i < nb_prefixes; i++) {
+		len = rte_be_to_cpu_16(((uint16_t *) pkt->component_offsets)[i]) + 1;
+		pkt->crc[i] = rte_hash_crc(pkt->name, len, seed);
+	}
+	*crc = rte_hash_crc(pkt->name, pkt->name_len, seed);
+}
+
+
+/*
+ * Hash the names of up to NAME_HASH_LANES packets in parallel.
+ *
+ * All lanes first process their full words in lockstep, recording the state
+ * of the hash after each word, then the hashes of the prefixes and of the full
+ * names are derived from these states and the trailing bytes
+ */
+static void
+name_hash_lanes(struct icn_packet **pkts, uint16_t *nb_prefixes,
+		unsigned nb_lanes, uint32_t seed, uint32_t *crc) {
+	uint32_t state[NAME_HASH_LANES][NAME_HASH_MAX_WORDS + 1];
+	uint32_t words[NAME_HASH_LANES];
+	uint32_t w, max_words = 0, min_words = UINT32_MAX;
+	uint64_t word;
+	uint16_t len;
+	unsigned i, j;
+
+	for (i = 0; i < nb_lanes; i++) {
+		words[i] = pkts[i]->name_len / sizeof(uint64_t);
+		max_words = RTE_MAX(max_words, words[i]);
+		min_words = RTE_MIN(min_words, words[i]);
+		state[i][0] = seed;
+	}
+	/* Full bursts of names of similar length take the branchless path */
+	if (nb_lanes == NAME_HASH_LANES) {
+		for (w = 0; w < min_words; w++) {
+			for (i = 0; i < NAME_HASH_LANES; i++) {
+				memcpy(&word, pkts[i]->name + w * sizeof(uint64_t), sizeof(word));
+				state[i][w + 1] = rte_hash_crc_8byte(word, state[i][w]);
+			}
+		}
+	} else {
+		min_words = 0;
+	}
+	for (w = min_words; w < max_words; w++) {
+		for (i = 0; i < nb_lanes; i++) {
+			if (w < words[i]) {
+				memcpy(&word, pkts[i]->name + w * sizeof(uint64_t), sizeof(word));
+				state[i][w + 1] = rte_hash_crc_8byte(word, state[i][w]);
+			}
+		}
+	}
+	for (i = 0; i < nb_lanes; i++) {
+		for (j = 0; j < nb_prefixes[i]; j++) {
+			len = rte_be_to_cpu_16(((uint16_t *) pkts[i]->component_offsets)[j]) + 1;
+			/* Malformed offsets are hashed anyway, as fib_lookup does */
+			pkts[i]->crc[j] = likely(len <= pkts[i]->name_len) ?
+					name_hash_prefix(state[i], pkts[i]->name, len) :
+					rte_hash_crc(pkts[i]->name, len, seed);
+		}
+		crc[i] = name_hash_prefix(state[i], pkts[i]->name, pkts[i]->name_len);
+	}
+}
+
+
+void name_hash_burst(struct icn_packet **pkts, uint16_t nb_pkts, uint32_t seed,
+		uint32_t *crc) {
+	struct icn_packet *lanes[NAME_HASH_LANES];
+	uint16_t nb_prefixes[NAME_HASH_LANES];
+	uint16_t i, first = 0;
+	unsigned nb_lanes = 0;
+
+	for (i = 0; i < nb_pkts; i++) {
+		if (unlikely(pkts[i]->name_len > NAME_HASH_MAX_WORDS * sizeof(uint64_t))) {
+			name_hash_serial(pkts[i], RTE_MIN(pkts[i]->component_nr,
+					(uint16_t) MAX_NAME_COMPONENTS), seed, &crc[i]);
+			continue;
+		}
+		if (nb_lanes == 0) {
+			first = i;
+		}
+		lanes[nb_lanes] = pkts[i];
+		nb_prefixes[nb_lanes] = RTE_MIN(pkts[i]->component_nr,
+				(uint16_t) MAX_NAME_COMPONENTS);
+		nb_lanes++;
+		/* Lanes are consecutive packets, so they end before a long name */
+		if (nb_lanes == NAME_HASH_LANES || i + 1 == nb_pkts ||
+				pkts[i + 1]->name_len > NAME_HASH_MAX_WORDS * sizeof(uint64_t)) {
+			name_hash_lanes(lanes, nb_prefixes, nb_lanes, seed, &crc[first]);
+			nb_lanes = 0;
+		}
+	}
+}
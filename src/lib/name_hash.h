@@ -0,0 +1,62 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _NAME_HASH_H_
+#define _NAME_HASH_H_
+
+/**
+ * @file
+ *
+ * Hashing of the names of a burst of packets
+ *
+ * Names are hashed with CRC32C, whose latency is bound by the dependency
+ * chain of the crc32 instruction: each 4-byte step needs the result of the
+ * previous one. To hide this latency, the names of a burst are hashed in
+ * lanes of NAME_HASH_LANES names, interleaving one step of each lane, so that
+ * independent instructions fill the pipeline.
+ *
+ * In the same pass, the hashes of all prefixes of each name (up to each
+ * component separator) are computed, as needed by FIB lookups. Hashes are the
+ * same as the ones computed by rte_hash_crc on the same bytes, including the
+ * zero padding of trailing bytes.
+ */
+
+#include <stdint.h>
+
+#include <packet.h>
+
+/**
+ * Number of names hashed in parallel
+ */
+#define NAME_HASH_LANES 8
+
+/**
+ * Max number of 8-byte words of a name hashed in parallel with others. Longer
+ * names are hashed on their own
+ */
+#define NAME_HASH_MAX_WORDS 32
+
+/**
+ * Hash the names of a burst of parsed packets and their prefixes
+ *
+ * The hash of the prefix of the name of packet i ending with component c is
+ * stored in pkts[i]->crc[c], for all components the packet has and that fit in
+ * crc. The hash of the full name is stored in crc[i].
+ *
+ * @param pkts
+ *   Array of pointers to parsed packets
+ * @param nb_pkts
+ *   Number of packets
+ * @param seed
+ *   Seed of the hash
+ * @param crc
+ *   Array of nb_pkts hashes of the full names, filled by the function
+ */
+void name_hash_burst(struct icn_packet **pkts, uint16_t nb_pkts, uint32_t seed,
+		uint32_t *crc);
+
+#endif /* _NAME_HASH_H_ */
@@ -0,0 +1,143 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_byteorder.h>
+#include <rte_vect.h>
+
+#include <config.h>
+
+#include "name_tokenize.h"
+
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+#define NAME_TOKENIZE_BLOCK 32
+#elif defined(RTE_MACHINE_CPUFLAG_SSE2)
+#define NAME_TOKENIZE_BLOCK 16
+#else
+#define NAME_TOKENIZE_BLOCK 1
+#endif
+
+/*
+ * Return a mask with bit i set if byte i of a block of NAME_TOKENIZE_BLOCK
+ * bytes is a separator
+ */
+static inline uint32_t
+name_tokenize_block(const uint8_t *block) {
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+	__m256i v = _mm256_loadu_si256((const __m256i *) block);
+	return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v,
+			_mm256_set1_epi8((char) COMPONENT_SEP)));
+#elif defined(RTE_MACHINE_CPUFLAG_SSE2)
+	__m128i v = _mm_loadu_si128((const __m128i *) block);
+	return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v,
+			_mm_set1_epi8((char) COMPONENT_SEP)));
+#else
+	return block[0] == COMPONENT_SEP;
+#endif
+}
+
+
+/* Append the offsets of the separators of a mask found at a given base */
+static inline uint16_t
+name_tokenize_mask(uint32_t mask, uint16_t base, uint16_t *offsets,
+		uint16_t nb_offsets, uint16_t max_offsets) {
+	while (mask != 0 && nb_offsets < max_offsets) {
+		offsets[nb_offsets++] = rte_cpu_to_be_16(base + __builtin_ctz(mask));
+		mask &= mask - 1;
+	}
+	return nb_offsets;
+}
+
+
+uint16_t name_tokenize(const uint8_t *name, uint16_t name_len, uint16_t *offsets,
+		uint16_t max_offsets) {
+	uint16_t nb_offsets = 0;
+	uint16_t i = 0, rem;
+	uint32_t mask;
+
+	for (; i + NAME_TOKENIZE_BLOCK <= name_len; i += NAME_TOKENIZE_BLOCK) {
+		mask = name_tokenize_block(name + i);
+		nb_offsets = name_tokenize_mask(mask, i, offsets, nb_offsets, max_offsets);
+	}
+	rem = name_len - i;
+	if (rem == 0) {
+		return nb_offsets;
+	}
+	/*
+	 * The tail is read as the last block of the name, which overlaps bytes
+	 * already tokenized, so that no byte after the name is read
+	 */
+	if (likely(name_len >= NAME_TOKENIZE_BLOCK)) {
+		mask = name_tokenize_block(name + name_len - NAME_TOKENIZE_BLOCK);
+		mask >>= NAME_TOKENIZE_BLOCK - rem;
+		return name_tokenize_mask(mask, i, offsets, nb_offsets, max_offsets);
+	}
+	/* Names shorter than a block are tokenized byte by byte */
+	for (; i < name_len && nb_offsets < max_offsets; i++) {
+		if (name[i] == COMPONENT_SEP) {
+			offsets[nb_offsets++] = rte_cpu_to_be_16(i);
+		}
+	}
+	return nb_offsets;
+}
+
+
+int name_offsets_valid(const uint8_t *offsets, uint16_t nb_offsets, uint16_t name_len) {
+	/* The first offset has no previous one */
+	int32_t prev = -1, cur;
+	uint32_t bad = 0;
+	uint16_t i = 0;
+
+	/* Parsed packets have room for the offsets of MAX_NAME_COMPONENTS prefixes */
+	if (unlikely(nb_offsets > MAX_NAME_COMPONENTS)) {
+		return 0;
+	}
+#if defined(RTE_MACHINE_CPUFLAG_SSE4_1)
+	if (nb_offsets >= 8) {
+		/* Byte swap of 8 big-endian offsets */
+		const __m128i bswap = _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9,
+				6, 7, 4, 5, 2, 3, 0, 1);
+		const __m128i max = _mm_set1_epi16((short) (name_len - 1));
+		const __m128i first = _mm_set_epi16(0, 0, 0, 0, 0, 0, 0, -1);
+		__m128i cur_v, prev_v, last_v = _mm_setzero_si128();
+		__m128i bad_v = _mm_setzero_si128(), dec;
+
+		if (unlikely(name_len == 0)) {
+			return 0;
+		}
+		for (; i + 8 <= nb_offsets; i += 8) {
+			cur_v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (offsets +
+					i * sizeof(uint16_t))), bswap);
+			/* Offsets beyond the name */
+			bad_v = _mm_or_si128(bad_v, _mm_xor_si128(_mm_min_epu16(cur_v, max), cur_v));
+			/* Offsets not greater than the previous one, which is the last
+			 * one of the previous vector for the first lane */
+			prev_v = _mm_alignr_epi8(cur_v, last_v, 14);
+			dec = _mm_cmpeq_epi16(_mm_max_epu16(prev_v, cur_v), prev_v);
+			if (i == 0) {
+				dec = _mm_andnot_si128(first, dec);
+			}
+			bad_v = _mm_or_si128(bad_v, dec);
+			last_v = cur_v;
+		}
+		if (!_mm_testz_si128(bad_v, bad_v)) {
+			return 0;
+		}
+		prev = (uint16_t) _mm_extract_epi16(last_v, 7);
+	}
+#endif
+	/* Conditions are accumulated without branching */
+	for (; i < nb_offsets; i++) {
+		cur = offsets[2 * i] << 8 | offsets[2 * i + 1];
+		bad |= (cur >= name_len) | (cur <= prev);
+		prev = cur;
+	}
+	return !bad;
+}
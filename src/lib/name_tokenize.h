@@ -0,0 +1,69 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _NAME_TOKENIZE_H_
+#define _NAME_TOKENIZE_H_
+
+/**
+ * @file
+ *
+ * Tokenization of names into components
+ *
+ * Component offsets are the positions of the COMPONENT_SEP bytes of a name,
+ * as 16-bit big-endian integers, i.e. the same format as the value of the
+ * component offsets TLV. The prefix ending with a component is made of the
+ * bytes up to and including its offset.
+ *
+ * Offsets are found comparing 32 (AVX2) or 16 (SSE2) bytes of the name at
+ * once with the separator, and offsets received in packets are validated 8 at
+ * a time (SSE4.1), so that routers neither need the component offsets TLV nor
+ * have to trust it.
+ */
+
+#include <stdint.h>
+
+/**
+ * Find the component offsets of a name
+ *
+ * Only the first max_offsets separators are reported, so that longest prefix
+ * matches on longer names are done on their first max_offsets prefixes.
+ *
+ * @param name
+ *   Name to tokenize
+ * @param name_len
+ *   Length of the name
+ * @param offsets
+ *   Array of at least max_offsets offsets, filled with big-endian offsets
+ * @param max_offsets
+ *   Max number of offsets to report
+ *
+ * @return
+ *   Number of offsets found
+ */
+uint16_t name_tokenize(const uint8_t *name, uint16_t name_len, uint16_t *offsets,
+		uint16_t max_offsets);
+
+/**
+ * Validate component offsets received in a packet
+ *
+ * Offsets are valid if there are at most MAX_NAME_COMPONENTS of them, if they
+ * are strictly increasing and if all fall within the name, so that no prefix
+ * is longer than the name.
+ *
+ * @param offsets
+ *   Array of big-endian offsets, possibly not aligned
+ * @param nb_offsets
+ *   Number of offsets
+ * @param name_len
+ *   Length of the name
+ *
+ * @return
+ *   1 if offsets are valid, 0 otherwise
+ */
+int name_offsets_valid(const uint8_t *offsets, uint16_t nb_offsets, uint16_t name_len);
+
+#endif /* _NAME_TOKENIZE_H_ */
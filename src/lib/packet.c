@@ -5,62 +5,158 @@
  *
  */
 
+#include <string.h>
+
 #include <rte_ether.h>
 #include <rte_ip.h>
 #include <rte_common.h>
 #include <rte_byteorder.h>
 #include <rte_log.h>
+#include <rte_branch_prediction.h>
 
 #include "packet.h"
+#include "name_tokenize.h"
 #include <config.h>
 
-uint8_t parse_packet(uint8_t* pkt, struct icn_packet* icn_pkt){
+uint8_t parse_packet(uint8_t* pkt, uint16_t len, struct icn_packet* icn_pkt){
     
-	uint8_t*  ptr;   /*Pointer used to parse the packet*/
-	uint16_t* name_len;
-	uint16_t* type;
-	uint16_t* length;
+	uint8_t*  ptr;     /*Pointer used to parse the packet*/
+	uint8_t*  pkt_end; /*Pointer to the end of the packet*/
+	uint8_t*  hdr_end; /*Pointer to the end of the header*/
+	uint16_t  pkt_len;
+	uint16_t  type;
+	uint16_t  length;
 	
 	/*Parse the fixed header part*/
 	icn_pkt->hdr = (struct icn_hdr *) pkt;
-	ptr = (uint8_t *) RTE_PTR_ADD(icn_pkt->hdr, sizeof(struct icn_hdr));
+	icn_pkt->pkt = pkt;
+	icn_pkt->name = (uint8_t *) RTE_PTR_ADD(icn_pkt->hdr, ICN_HDR_NAME_OFFSET);
+	icn_pkt->name_len = 0;
+	icn_pkt->component_offsets = NULL;
+	icn_pkt->component_offsets_size = 0;
+	icn_pkt->component_nr = 0;
+	icn_pkt->freshness = 0;
+	icn_pkt->nonce = 0;
+	icn_pkt->lifetime = 0;
+
+	/* The fixed header and the name length must be in the buffer */
+	if (unlikely(len < ICN_HDR_NAME_OFFSET))
+		return 1;
 
 	/*Parse the name length*/
-	name_len = (uint16_t*) ptr;
-	icn_pkt->name_len = rte_be_to_cpu_16(*name_len);   
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, sizeof(uint16_t));
-	
+	pkt_len = rte_be_to_cpu_16(icn_pkt->hdr->pkt_len);
+	icn_pkt->name_len = rte_be_to_cpu_16(*(uint16_t *) RTE_PTR_ADD(pkt, sizeof(struct icn_hdr)));
+
+	/*
+	 * The packet must be in the buffer and the name, not empty, in the
+	 * packet. All conditions are evaluated before branching
+	 */
+	if (unlikely((pkt_len > len) | (ICN_HDR_NAME_OFFSET + icn_pkt->name_len > pkt_len) |
+			(icn_pkt->name_len == 0))) {
+		icn_pkt->name_len = 0;
+		return 1;
+	}
+	pkt_end = (uint8_t *) RTE_PTR_ADD(pkt, pkt_len);
+
 	/*Parse the name */
-	icn_pkt->name = (uint8_t *) RTE_PTR_ADD(icn_pkt->hdr, ICN_HDR_NAME_OFFSET);
 	ptr = (uint8_t *) RTE_PTR_ADD(icn_pkt->name, icn_pkt->name_len);
-	
 
-	/* If packet */ 
-	if ((ptr-pkt) >= rte_be_to_cpu_16(icn_pkt->hdr->pkt_len))
-		return 1;
-	    
-	/*Parse the name offsets */
-	type = (uint16_t*) ptr;
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, sizeof(uint16_t));
-	
-	length = (uint16_t*) ptr;
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, sizeof(uint16_t));
-	    
-	if(*type == TLV_TYPE_NAME_COMPONENTS_OFFSET_BE){
-		icn_pkt->component_offsets = ptr;
-		icn_pkt->component_offsets_size = rte_be_to_cpu_16(*length);
-		icn_pkt->component_nr = icn_pkt->component_offsets_size/2; //length of component offset is 2B
+	/*
+	 * Parse the TLVs following the name, up to the end of the header.
+	 * Unknown TLVs are skipped. Some generators only count the fixed
+	 * header in hdr_len, in which case TLVs are parsed up to the end of
+	 * the packet
+	 */
+	hdr_end = (uint8_t *) RTE_PTR_ADD(pkt, rte_be_to_cpu_16(icn_pkt->hdr->hdr_len));
+	if (hdr_end < ptr || hdr_end > pkt_end)
+		hdr_end = pkt_end;
+	while (ptr + 2 * sizeof(uint16_t) <= hdr_end) {
+		type = *(uint16_t*) ptr;
+		length = rte_be_to_cpu_16(*(uint16_t*) RTE_PTR_ADD(ptr, sizeof(uint16_t)));
+		ptr = (uint8_t *) RTE_PTR_ADD(ptr, 2 * sizeof(uint16_t));
+
+		if (unlikely(length > hdr_end - ptr))
+			break;
+
+		switch (type) {
+		case TLV_TYPE_NAME_COMPONENTS_OFFSET_BE:
+			icn_pkt->component_offsets = ptr;
+			icn_pkt->component_offsets_size = length;
+			icn_pkt->component_nr = length/2; //length of component offset is 2B
+			break;
+		case TLV_TYPE_DATA_FRESHNESS_BE:
+			if (length == TLV_DATA_FRESHNESS_LEN)
+				icn_pkt->freshness = rte_be_to_cpu_32(*(uint32_t *) ptr);
+			break;
+		case TLV_TYPE_INTEREST_NONCE_BE:
+			if (length == TLV_INTEREST_NONCE_LEN)
+				icn_pkt->nonce = *(uint32_t *) ptr;
+			break;
+		case TLV_TYPE_INTEREST_LIFETIME_BE:
+			if (length == TLV_INTEREST_LIFETIME_LEN)
+				icn_pkt->lifetime = rte_be_to_cpu_32(*(uint32_t *) ptr);
+			break;
+		default:
+			break;
+		}
+		ptr = (uint8_t *) RTE_PTR_ADD(ptr, length);
 	}
-	else
-		return 1;
-	  
-	
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, rte_be_to_cpu_16(*length));
-	
-	length = (uint16_t*) ptr;
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, sizeof(uint16_t));
-	
-	ptr = (uint8_t *) RTE_PTR_ADD(ptr, rte_be_to_cpu_16(*length));
-	
+
+	if (icn_pkt->component_offsets == NULL ||
+			!name_offsets_valid(icn_pkt->component_offsets, icn_pkt->component_nr, icn_pkt->name_len))
+		parse_name_components(icn_pkt);
+
 	return 0;
 }
+
+void parse_name_components(struct icn_packet* icn_pkt){
+	/* name_offsets is a member of a packed struct, so it may be unaligned */
+	uint16_t offsets[MAX_NAME_COMPONENTS];
+
+	icn_pkt->component_nr = name_tokenize(icn_pkt->name, icn_pkt->name_len,
+			offsets, MAX_NAME_COMPONENTS);
+	memcpy(icn_pkt->name_offsets, offsets, icn_pkt->component_nr * sizeof(uint16_t));
+	icn_pkt->component_offsets = (uint8_t *) icn_pkt->name_offsets;
+	icn_pkt->component_offsets_size = icn_pkt->component_nr * sizeof(uint16_t);
+}
+
+void icn_desc_store(const struct icn_packet* icn_pkt, uint16_t icn_offset, uint32_t crc,
+		struct icn_desc* desc){
+	desc->icn_offset = icn_offset;
+	desc->name_len = icn_pkt->name_len;
+	desc->component_nr = icn_pkt->component_nr;
+	desc->crc = crc;
+	desc->freshness = icn_pkt->freshness;
+	desc->nonce = icn_pkt->nonce;
+	desc->lifetime = icn_pkt->lifetime;
+	desc->flags = 0;
+	/* Offsets received in the packet are referenced, tokenized ones copied */
+	if (icn_pkt->component_offsets == (const uint8_t *) icn_pkt->name_offsets) {
+		desc->component_offsets = 0;
+		memcpy(desc->name_offsets, icn_pkt->name_offsets,
+				icn_pkt->component_nr * sizeof(uint16_t));
+	} else {
+		desc->component_offsets = (uint16_t) (icn_pkt->component_offsets - icn_pkt->pkt);
+	}
+}
+
+void icn_desc_load(const struct icn_desc* desc, uint8_t* buf, struct icn_packet* icn_pkt){
+	icn_pkt->pkt = (uint8_t *) RTE_PTR_ADD(buf, desc->icn_offset);
+	icn_pkt->hdr = (struct icn_hdr *) icn_pkt->pkt;
+	icn_pkt->name = (uint8_t *) RTE_PTR_ADD(icn_pkt->pkt, ICN_HDR_NAME_OFFSET);
+	icn_pkt->name_len = desc->name_len;
+	icn_pkt->component_nr = desc->component_nr;
+	icn_pkt->component_offsets_size = desc->component_nr * sizeof(uint16_t);
+	icn_pkt->freshness = desc->freshness;
+	icn_pkt->nonce = desc->nonce;
+	icn_pkt->lifetime = desc->lifetime;
+	if (desc->component_offsets == 0) {
+		memcpy(icn_pkt->name_offsets, desc->name_offsets,
+				desc->component_nr * sizeof(uint16_t));
+		icn_pkt->component_offsets = (uint8_t *) icn_pkt->name_offsets;
+	} else {
+		icn_pkt->component_offsets = (uint8_t *) RTE_PTR_ADD(icn_pkt->pkt, desc->component_offsets);
+	}
+	if (desc->component_nr < MAX_NAME_COMPONENTS)
+		icn_pkt->crc[desc->component_nr] = desc->crc;
+}
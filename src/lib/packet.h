@@ -63,11 +63,32 @@
 /* Little-endian version */
 #define TLV_TYPE_NAME_COMPONENTS_OFFSET					0x0001
 #define TLV_TYPE_NAME_SEGMENT_IDS_OFFSETS 				0x0002
+#define TLV_TYPE_DATA_FRESHNESS						0x0004
+#define TLV_TYPE_INTEREST_LIFETIME					0x0005
 
 /* Big-endian version */
 #define TLV_TYPE_NAME_COMPONENTS_OFFSET_BE 				0x0100
 #define TLV_TYPE_NAME_SEGMENT_IDS_OFFSETS_BE 				0x0200
 #define TLV_TYPE_INTEREST_NONCE_BE 					0x0300
+#define TLV_TYPE_DATA_FRESHNESS_BE 					0x0400
+#define TLV_TYPE_INTEREST_LIFETIME_BE 					0x0500
+
+/**
+ * Length of the value of the Data freshness TLV: freshness period in
+ * milliseconds, as a 32-bit big-endian integer
+ */
+#define TLV_DATA_FRESHNESS_LEN 4
+
+/**
+ * Length of the value of the Interest nonce TLV, as a 32-bit integer
+ */
+#define TLV_INTEREST_NONCE_LEN 4
+
+/**
+ * Length of the value of the Interest lifetime TLV: lifetime in milliseconds,
+ * as a 32-bit big-endian integer
+ */
+#define TLV_INTEREST_LIFETIME_LEN 4
 
 
 
@@ -109,22 +130,102 @@ struct icn_packet {
     uint16_t             component_offsets_size;  /*Size of a single component offset in the Segment ID's TLV*/
     uint8_t*		 payload;
     uint32_t		 lpm_crc; /**< CRC32 hash of name LPM */
+    uint32_t		 freshness; /**< freshness period of a Data in ms, 0 if not specified */
+    uint32_t		 nonce; /**< nonce of an Interest, as received, 0 if not specified */
+    uint32_t		 lifetime; /**< lifetime of an Interest in ms, 0 if not specified */
     uint32_t		 crc[MAX_NAME_COMPONENTS];
+    uint16_t		 name_offsets[MAX_NAME_COMPONENTS]; /**< component offsets found by tokenizing the name, if not taken from the packet */
 }__attribute__((__packed__));
 
 
+/**
+ * Compact descriptor of a parsed packet
+ *
+ * It is stored with the packet, e.g. in the private area of its mbuf, so that
+ * later processing stages, possibly on other cores, rebuild the struct
+ * icn_packet of the packet without parsing it again. Offsets are relative to
+ * the ICN header.
+ */
+struct icn_desc {
+    uint16_t		 icn_offset; /**< offset of the ICN header from the start of the buffer storing the packet */
+    uint16_t		 name_len; /**< length of the name */
+    uint16_t		 component_nr; /**< number of components */
+    uint16_t		 component_offsets; /**< offset of the component offsets TLV value, 0 if they are stored in name_offsets */
+    uint32_t		 crc; /**< CRC32 hash of the name */
+    uint32_t		 freshness; /**< freshness period of a Data in ms, 0 if not specified */
+    uint32_t		 nonce; /**< nonce of an Interest, 0 if not specified */
+    uint32_t		 lifetime; /**< lifetime of an Interest in ms, 0 if not specified */
+    uint8_t		 flags; /**< set by the lcores handling the packet, 0 when stored */
+    uint16_t		 name_offsets[MAX_NAME_COMPONENTS]; /**< component offsets found by tokenizing the name */
+}__attribute__((__packed__));
+
 /**
  * Parse the icn packet
  *
+ * Every field and TLV is checked against the length of the packet, i.e. the
+ * smallest of the buffer length and of the length in the ICN header, which can
+ * be shorter than the buffer, e.g. because of Ethernet padding. Unknown TLVs
+ * are skipped.
+ *
+ * Component offsets are taken from the component offsets TLV if present and
+ * valid, i.e. strictly increasing and within the name. Otherwise they are
+ * found by tokenizing the name (see parse_name_components), so that packets
+ * without the TLV are accepted and invalid offsets never make prefixes longer
+ * than the name.
+ *
  * @param pkt
  *   Pointer to the packet to parse
+ * @param len
+ *   Number of bytes of the buffer starting at pkt
  * @param icn_pkt pointer to an empty data structure of the type icn_packet that will be filled with the parsed packet
  *
  * @return
  * 	- 0 if packet has been parsed successfully,
- * 	- 1 otherwise
+ * 	- 1 if the packet is malformed, i.e. its header or name do not fit in it,
+ * 	  or its name is empty. Names longer than MAX_NAME_LEN are accepted, as
+ * 	  the payload of control messages is parsed as a name too
+ */
+uint8_t parse_packet(uint8_t* pkt, uint16_t len, struct icn_packet * icn_pkt);
+
+/**
+ * Find the component offsets of a parsed packet by tokenizing its name,
+ * replacing the ones taken from its component offsets TLV, if any
+ *
+ * Only the first MAX_NAME_COMPONENTS components are found.
+ *
+ * @param icn_pkt
+ *   Pointer to the parsed packet
+ */
+void parse_name_components(struct icn_packet * icn_pkt);
+
+/**
+ * Store the descriptor of a parsed packet
+ *
+ * @param icn_pkt
+ *   Pointer to the parsed packet
+ * @param icn_offset
+ *   Offset of the ICN header from the start of the buffer storing the packet
+ * @param crc
+ *   CRC32 hash of the name
+ * @param desc
+ *   Descriptor to fill
+ */
+void icn_desc_store(const struct icn_packet * icn_pkt, uint16_t icn_offset, uint32_t crc,
+		struct icn_desc * desc);
+
+/**
+ * Rebuild a parsed packet from its descriptor, without parsing it
+ *
+ * Hashes of prefixes are not restored, only the one of the full name.
+ *
+ * @param desc
+ *   Descriptor of the packet
+ * @param buf
+ *   Start of the buffer storing the packet
+ * @param icn_pkt
+ *   Structure to fill
  */
-uint8_t parse_packet(uint8_t* pkt, struct icn_packet * icn_pkt);
+void icn_desc_load(const struct icn_desc * desc, uint8_t * buf, struct icn_packet * icn_pkt);
 
 
 #endif /* _PACKET_H_ */
@@ -25,6 +25,8 @@
 pit_t* pit_create(int num_buckets, int max_elements, int socket, uint64_t ttl_us) {
 	pit_t *pit;
 	void *p;
+
+	RTE_BUILD_BUG_ON(sizeof(struct pit_entry) != RTE_CACHE_LINE_SIZE);
 	// Allocate on the specified NUMA node. If socket is SOCKET_ID_ANY, then it
 	// allocates the hash table on the socket of the calling lcore
 	p = rte_zmalloc_socket("PIT", sizeof(pit_t), RTE_CACHE_LINE_SIZE, socket);
@@ -58,6 +60,7 @@ pit_t* pit_create(int num_buckets, int max_elements, int socket, uint64_t ttl_us
 	}
 	pit->ring = (struct pit_entry *) p;
 	pit_set_ttl_us(pit, ttl_us);
+	pit_set_face_quota(pit, max_elements);
 	return pit;
 }
 
@@ -92,7 +95,8 @@ struct pit_entry *pit_lookup(pit_t *pit, uint8_t *name, uint8_t name_len,uint32_
 static inline
 int8_t __pit_lookup_and_update_with_hash(pit_t *pit,
 		uint8_t *name, uint8_t name_len, 
-		uint8_t face, uint64_t *curr_time, uint32_t crc) {
+		uint8_t face, uint64_t *curr_time, uint32_t crc,
+		struct pit_entry **inserted) {
 	uint32_t bucket;
 	uint8_t entry;
 	uint8_t free_tab = 0xFF;
@@ -149,6 +153,9 @@ int8_t __pit_lookup_and_update_with_hash(pit_t *pit,
 	if(free_tab == 0xFF || is_pit_full(pit)) {
 		return -ENOSPC;
 	}
+	if(unlikely(pit->face_entries[face] >= pit->face_quota)) {
+		return -EDQUOT;
+	}
 	/*
 	 * Now, insert the item because it is not in the PIT and there is
 	 * space to insert it.
@@ -168,6 +175,12 @@ int8_t __pit_lookup_and_update_with_hash(pit_t *pit,
 	pit->ring[pit->top].name_len = name_len;
 	rte_memcpy(pit->ring[pit->top].name, name, name_len);
 	pit->ring[pit->top].face_bitmask = (1 << face);
+	pit->ring[pit->top].face = face;
+	pit->ring[pit->top].out_face = PIT_NO_UPSTREAM;
+	pit->face_entries[face]++;
+	if(inserted != NULL) {
+		*inserted = &pit->ring[pit->top];
+	}
 	pit->top = (pit->top + 1) % pit->max_elements;
 	/*
 	 * Inform the caller that a new item was inserted and needs to be
@@ -178,18 +191,26 @@ int8_t __pit_lookup_and_update_with_hash(pit_t *pit,
 
 
 int8_t pit_lookup_and_update_with_hash(pit_t *pit, uint8_t *name, uint8_t name_len,  uint8_t face, uint64_t *curr_time, uint32_t crc) {
-	return __pit_lookup_and_update_with_hash(pit, name, name_len, face, curr_time, crc);
+	return __pit_lookup_and_update_with_hash(pit, name, name_len, face, curr_time, crc, NULL);
+}
+
+
+int8_t pit_lookup_and_update_entry_with_hash(pit_t *pit, uint8_t *name,
+		uint8_t name_len, uint8_t face, uint64_t *curr_time, uint32_t crc,
+		struct pit_entry **entry) {
+	return __pit_lookup_and_update_with_hash(pit, name, name_len, face, curr_time, crc, entry);
 }
 
 
 int8_t pit_lookup_and_update(pit_t *pit, uint8_t *name, uint8_t name_len, uint8_t face, uint64_t *curr_time) {
 	uint32_t crc = rte_hash_crc(name, name_len, MASTER_CRC_SEED);
-	return __pit_lookup_and_update_with_hash(pit, name, name_len, face, curr_time, crc);
+	return __pit_lookup_and_update_with_hash(pit, name, name_len, face, curr_time, crc, NULL);
 }
 
 
 uint64_t __pit_lookup_and_remove_with_hash(pit_t *pit, uint8_t *name,
-		uint8_t name_len, uint32_t crc) {
+		uint8_t name_len, uint32_t crc, struct pit_upstream *upstream) {
+	struct pit_entry *e;
 	uint32_t bucket;
 	uint8_t entry;
 	/* Get index of corresponding bucket */
@@ -212,12 +233,19 @@ uint64_t __pit_lookup_and_remove_with_hash(pit_t *pit, uint8_t *name,
 			continue;
 		}
 		/* Element found. Remove it and return pointer to face bitmask */
+		e = &pit->ring[pit->table[bucket].entry[entry].index];
 		pit->table[bucket].busy[entry] = 0;
-		pit->ring[pit->table[bucket].entry[entry].index].active = 0;
+		e->active = 0;
+		pit->face_entries[e->face]--;
 		if(pit->bottom == pit->table[bucket].entry[entry].index) {
 			pit->bottom = (pit->bottom + 1) % pit->max_elements;
 		}
-		return pit->ring[pit->table[bucket].entry[entry].index].face_bitmask;
+		if(upstream != NULL) {
+			upstream->send_time = e->expiry - pit->ttl + e->send_delay;
+			upstream->nexthop = e->nexthop;
+			upstream->face = e->out_face;
+		}
+		return e->face_bitmask;
 	}
 	/*
 	 * This block is reached if the searched elements in not present in
@@ -229,13 +257,30 @@ uint64_t __pit_lookup_and_remove_with_hash(pit_t *pit, uint8_t *name,
 
 
 uint64_t pit_lookup_and_remove_with_hash(pit_t *pit, uint8_t *name, uint8_t name_len, uint32_t crc) {
-	return __pit_lookup_and_remove_with_hash(pit, name, name_len, crc);
+	return __pit_lookup_and_remove_with_hash(pit, name, name_len, crc, NULL);
 }
 
 
 uint64_t pit_lookup_and_remove(pit_t *pit, uint8_t *name, uint8_t name_len) {
 	uint32_t crc = rte_hash_crc(name, name_len, MASTER_CRC_SEED);
-	return __pit_lookup_and_remove_with_hash(pit, name, name_len, crc);
+	return __pit_lookup_and_remove_with_hash(pit, name, name_len, crc, NULL);
+}
+
+
+uint64_t pit_lookup_and_remove_upstream_with_hash(pit_t *pit, uint8_t *name,
+		uint8_t name_len, uint32_t crc, struct pit_upstream *upstream) {
+	return __pit_lookup_and_remove_with_hash(pit, name, name_len, crc, upstream);
+}
+
+
+int8_t pit_set_upstream_with_hash(pit_t *pit, uint8_t *name, uint8_t name_len,
+		uint32_t crc, uint8_t face, uint16_t nexthop) {
+	struct pit_entry *e = pit_lookup(pit, name, name_len, crc);
+	if(unlikely(e == NULL)) {
+		return -ENOENT;
+	}
+	pit_set_upstream(pit, e, face, nexthop);
+	return 0;
 }
 
 
@@ -251,6 +296,7 @@ uint32_t __pit_purge_expired_with_time(pit_t *pit, uint64_t *curr_time) {
 			/* Case of active entry but expired, clean both in ring and in table */
 			pit->ring[pit->bottom].active = 0;
 			pit->table[pit->ring[pit->bottom].bucket].busy[pit->ring[pit->bottom].tab] = 0;
+			pit->face_entries[pit->ring[pit->bottom].face]--;
 		}
 		/*
 		 * We assume that if the entry in the ring is flagged as inactive,
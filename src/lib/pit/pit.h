@@ -21,8 +21,10 @@
 #include <stdint.h>
 #include <errno.h>
 
+#include <rte_common.h>
 #include <rte_memory.h>
 #include <rte_cycles.h>
+#include <rte_prefetch.h>
 
 #include <config.h>
 
@@ -34,6 +36,21 @@
  */
 #define BUCKET_SIZE	7
 
+/**
+ * Max number of faces, i.e. of bits of the face bitmask of PIT entries
+ */
+#define PIT_MAX_FACES	64
+
+/**
+ * Upstream face of PIT entries whose Interest has not been forwarded yet
+ */
+#define PIT_NO_UPSTREAM	0xFF
+
+/**
+ * Number of FIB entries which can be recorded as upstream of PIT entries
+ */
+#define PIT_MAX_NEXTHOPS	(UINT16_MAX + 1)
+
 /**
  * A single entry of a linear open index hash table
  *
@@ -69,8 +86,21 @@ struct pit_entry {
 	uint8_t name_len;			 /**< length of name in PIT entry*/
 	uint8_t name[MAX_NAME_LEN]; /**< name in PIT entry */
 	uint64_t face_bitmask;		 /**< bitmask storing all faces from the Interest was received */
+	uint8_t face;				 /**< face whose Interest created the entry, charged for it */
+	uint8_t out_face;			 /**< face the Interest was forwarded to, PIT_NO_UPSTREAM if none */
+	uint16_t nexthop;			 /**< FIB entry through which the Interest was forwarded */
+	uint32_t send_delay;		 /**< cycles from insertion to forwarding, saturated, so that the entry fits in a cache line */
 } __attribute__((__packed__)) __rte_cache_aligned;
 
+/**
+ * Upstream of a PIT entry, i.e. where and when its Interest was forwarded
+ */
+struct pit_upstream {
+	uint64_t send_time;		/**< time at which the Interest was forwarded, in CPU cycles */
+	uint32_t nexthop;		/**< FIB entry through which the Interest was forwarded */
+	uint8_t face;			/**< face the Interest was forwarded to, PIT_NO_UPSTREAM if none */
+};
+
 /**
  * Pending Interest Table (PIT)
  */
@@ -82,6 +112,8 @@ typedef struct {
 	uint32_t top;		 		/**< index of top (most recently inserted) entry */
 	uint32_t bottom;			/**< index of bottom (least recently inserted) entry */
 	uint64_t ttl;				/**< fixed TTL (in number of cycles) applied to all PIT entries */
+	uint32_t face_quota;		/**< max number of entries created by each face */
+	uint32_t face_entries[PIT_MAX_FACES];	/**< number of entries created by each face */
 } __attribute__((__packed__)) __rte_cache_aligned pit_t;
 
 /**
@@ -129,6 +161,42 @@ void pit_set_ttl_us(pit_t *pit, uint64_t ttl_us) {
 	pit->ttl = ((rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S) * ttl_us;
 }
 
+/**
+ * Set the max number of entries each face may create in the PIT, so that a
+ * face flooding the PIT with Interests cannot take all of its space. Interests
+ * of a face over its quota are not inserted
+ *
+ * @param pit
+ *   Pointer to the PIT
+ * @param quota
+ *   Max number of entries per face. By default, the size of the PIT
+ */
+static inline
+void pit_set_face_quota(pit_t *pit, uint32_t quota) {
+	pit->face_quota = quota;
+}
+
+/**
+ * Record the upstream of an entry when its Interest is forwarded, i.e. now
+ *
+ * @param pit
+ *   Pointer to the PIT
+ * @param e
+ *   Entry, as returned by pit_lookup_and_update_entry_with_hash()
+ * @param face
+ *   Face the Interest is forwarded to
+ * @param nexthop
+ *   FIB entry through which the Interest is forwarded, less than
+ *   PIT_MAX_NEXTHOPS
+ */
+static inline
+void pit_set_upstream(pit_t *pit, struct pit_entry *e, uint8_t face, uint16_t nexthop) {
+	uint64_t delay = rte_rdtsc() - (e->expiry - pit->ttl);
+	e->out_face = face;
+	e->nexthop = nexthop;
+	e->send_delay = (uint32_t) RTE_MIN(delay, (uint64_t) UINT32_MAX);
+}
+
 /**
  * Return PIT occupancy, assuming there are no holes between head and tail
  * of the circular log
@@ -172,6 +240,39 @@ uint8_t is_pit_full(pit_t *pit) {
 	return ((pit->top + 1) % pit->max_elements) == pit->bottom;
 }
 
+/**
+ * Prefetch the bucket of the hash table of the PIT where an entry would be
+ *
+ * @param pit
+ *   pointer to the PIT
+ * @param crc
+ *   CRC32 hash of the chunk name
+ */
+static inline
+void pit_prefetch_bucket(pit_t *pit, uint32_t crc) {
+	rte_prefetch0(&pit->table[crc % pit->num_buckets]);
+}
+
+/**
+ * Prefetch the ring entries of the PIT whose hash matches the one of an entry,
+ * once its bucket has been prefetched with pit_prefetch_bucket
+ *
+ * @param pit
+ *   pointer to the PIT
+ * @param crc
+ *   CRC32 hash of the chunk name
+ */
+static inline
+void pit_prefetch_entry(pit_t *pit, uint32_t crc) {
+	struct pit_bucket *bucket = &pit->table[crc % pit->num_buckets];
+	uint8_t entry;
+	for (entry = 0; entry < BUCKET_SIZE; entry++) {
+		if(bucket->busy[entry] && bucket->entry[entry].crc == crc) {
+			rte_prefetch0(&pit->ring[bucket->entry[entry].index]);
+		}
+	}
+}
+
 /**
  * Crate a PIT
  *
@@ -253,6 +354,57 @@ uint64_t pit_lookup_and_remove_with_hash(pit_t *pit,
  */
 uint64_t pit_lookup_and_remove(pit_t *pit, uint8_t *name, uint8_t name_len);
 
+/**
+ * Lookup if an entry is in the PIT and, if so, remove it and return its
+ * upstream, given CRC32 hash
+ *
+ * This function is to be called when a Data packet arrives, to measure the
+ * time taken by the upstream to return it.
+ *
+ * @param pit
+ *   Pointer to the PIT
+ * @param name
+ *   Name of the chunk to look up
+ * @param name_len
+ *   Length of the chunk name to look up
+ * @param crc
+ *   CRC32 hash of the chunk name
+ * @param upstream
+ *   Set to the upstream of the entry, if found
+ *
+ * @return
+ *   The facemask associated to the PIT entry, as
+ *   pit_lookup_and_remove_with_hash()
+ */
+uint64_t pit_lookup_and_remove_upstream_with_hash(pit_t *pit,
+		uint8_t *name, uint8_t name_len, uint32_t crc,
+		struct pit_upstream *upstream);
+
+/**
+ * Record the upstream of an entry when its Interest is forwarded, i.e. now,
+ * given CRC32 hash
+ *
+ * @param pit
+ *   Pointer to the PIT
+ * @param name
+ *   Name of the chunk
+ * @param name_len
+ *   Length of the chunk name
+ * @param crc
+ *   CRC32 hash of the chunk name
+ * @param face
+ *   Face the Interest was forwarded to
+ * @param nexthop
+ *   FIB entry through which the Interest was forwarded, less than
+ *   PIT_MAX_NEXTHOPS
+ *
+ * @return
+ *  - 0 if the upstream was recorded
+ *  - -ENOENT if the entry is not in the PIT
+ */
+int8_t pit_set_upstream_with_hash(pit_t *pit, uint8_t *name, uint8_t name_len,
+		uint32_t crc, uint8_t face, uint16_t nexthop);
+
 /**
  * Look up if an entry is in the PIT and if not there, add it, given CRC32 hash
  *
@@ -275,11 +427,43 @@ uint64_t pit_lookup_and_remove(pit_t *pit, uint8_t *name, uint8_t name_len);
  *  - 0 if the entry was already there 
  *  - 1 if the entry was not there and has been inserted by this function call
  *  - -ENOSPC if no space is available to insert the entry
+ *  - -EDQUOT if the face has as many entries as its quota
  */
 int8_t pit_lookup_and_update_with_hash(pit_t *pit,
 		uint8_t *name, uint8_t name_len,
 		uint8_t face, uint64_t *curr_time, uint32_t crc);
 
+/**
+ * Look up if an entry is in the PIT and if not there, add it and return it,
+ * given CRC32 hash
+ *
+ * This function is supposed to be called when an Interest packet arrives, to
+ * record the upstream of the entry once the Interest is forwarded without
+ * looking it up again.
+ *
+ * @param pit
+ *   Pointer to the PIT
+ * @param name
+ *   Name of the chunk to look up
+ * @param name_len
+ *   Length of the chunk name to look up
+ * @param face
+ *   Face from which Interest was received
+ * @param curr_time
+ *   Pointer to the current time in CPU cycles (used for expiration time calculation)
+ * @param crc
+ *   CRC32 hash of the name
+ * @param entry
+ *   Set to the entry inserted, if any
+ *
+ * @return
+ *   As pit_lookup_and_update_with_hash()
+ */
+int8_t pit_lookup_and_update_entry_with_hash(pit_t *pit,
+		uint8_t *name, uint8_t name_len,
+		uint8_t face, uint64_t *curr_time, uint32_t crc,
+		struct pit_entry **entry);
+
 /**
  * Look up if an entry is in the PIT and if not there, add it
  *
@@ -300,6 +484,7 @@ int8_t pit_lookup_and_update_with_hash(pit_t *pit,
  *  - 0 if the entry was already there 
  *  - 1 if the entry was not there and has been inserted by this function call
  *  - -ENOSPC if no space is available to insert the entry
+ *  - -EDQUOT if the face has as many entries as its quota
  */
 int8_t pit_lookup_and_update(pit_t *pit, uint8_t *name, uint8_t name_len,
 		uint8_t face, uint64_t *curr_time);
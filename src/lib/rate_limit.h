@@ -0,0 +1,79 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _RATE_LIMIT_H_
+#define _RATE_LIMIT_H_
+
+/**
+ * @file
+ *
+ * Token bucket rate limiter
+ *
+ * The bucket is implemented as the equivalent Generic Cell Rate Algorithm
+ * (GCRA): instead of a number of tokens refilled over time, it keeps the
+ * theoretical arrival time (TAT) of the next packet, which each conforming
+ * packet pushes back by the interval between two tokens. A packet conforms
+ * unless the TAT is more than a bucket size worth of intervals ahead of the
+ * current time. Checking a packet takes a comparison and an addition, without
+ * any division.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_cycles.h>
+
+/**
+ * Rate limiter
+ */
+struct rate_limit {
+	uint64_t tat;			/**< theoretical arrival time of the next packet, in TSC cycles */
+	uint64_t interval;		/**< TSC cycles between two tokens, 0 if the rate is not limited */
+	uint64_t tolerance;		/**< max advance of the TAT on the current time, i.e. bucket size */
+} __attribute__((__packed__));
+
+/**
+ * Initialize a rate limiter
+ *
+ * @param rl
+ *   Rate limiter
+ * @param rate
+ *   Max rate, in packets per second, 0 to not limit the rate
+ * @param burst
+ *   Size of the bucket, i.e. max number of packets accepted at once
+ */
+static inline void
+rate_limit_init(struct rate_limit *rl, uint64_t rate, uint32_t burst) {
+	rl->tat = 0;
+	rl->interval = rate == 0 ? 0 : RTE_MAX(rte_get_tsc_hz() / rate, 1ULL);
+	rl->tolerance = rl->interval * RTE_MAX(burst, 1U);
+}
+
+/**
+ * Take a token for a packet, if the rate allows it
+ *
+ * @param rl
+ *   Rate limiter
+ * @param tsc
+ *   Current TSC
+ *
+ * @return
+ *   1 if the packet conforms to the rate, 0 if it must be dropped
+ */
+static inline uint8_t
+rate_limit_conform(struct rate_limit *rl, uint64_t tsc) {
+	uint64_t tat = RTE_MAX(rl->tat, tsc);
+
+	if (unlikely(tat - tsc >= rl->tolerance)) {
+		return 0;
+	}
+	rl->tat = tat + rl->interval;
+	return 1;
+}
+
+#endif /* _RATE_LIMIT_H_ */
@@ -0,0 +1,39 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+
+#include "strategy.h"
+
+strategy_t *strategy_create(uint32_t nb_nexthops, int socket) {
+	strategy_t *s;
+
+	RTE_BUILD_BUG_ON((STRATEGY_PROBE_PERIOD & (STRATEGY_PROBE_PERIOD - 1)) != 0);
+	s = rte_zmalloc_socket("STRATEGY", sizeof(strategy_t), RTE_CACHE_LINE_SIZE,
+			socket);
+	if(s == NULL) {
+		return NULL;
+	}
+	s->nexthop = rte_zmalloc_socket("STRATEGY_NEXTHOPS",
+			nb_nexthops * sizeof(struct strategy_nexthop), RTE_CACHE_LINE_SIZE, socket);
+	if(s->nexthop == NULL) {
+		rte_free(s);
+		return NULL;
+	}
+	s->nb_nexthops = nb_nexthops;
+	return s;
+}
+
+
+void strategy_free(strategy_t *s) {
+	if(s == NULL) {
+		return;
+	}
+	rte_free(s->nexthop);
+	rte_free(s);
+}
@@ -0,0 +1,235 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _STRATEGY_H_
+#define _STRATEGY_H_
+
+/**
+ * @file
+ *
+ * RTT-based forwarding strategy
+ *
+ * Each lcore measures every next hop of every prefix of its FIB, i.e. every
+ * forwarding entry: its smoothed round-trip time (RTT), from the forwarding
+ * of an Interest to the arrival of its Data, and its satisfaction ratio, i.e.
+ * the share of the Interests forwarded to it which returned a Data, over a
+ * window of the last STRATEGY_SAT_WINDOW to 2 * STRATEGY_SAT_WINDOW Interests.
+ *
+ * Interests are forwarded to the next hop with the lowest expected delay,
+ * i.e. its RTT divided by its satisfaction ratio, so that a next hop losing
+ * Interests is penalized even if its Data come back fast. Next hops never
+ * measured rank last, and one Interest out of STRATEGY_PROBE_PERIOD goes to
+ * another next hop, in turn, so that all keep being measured. Until a next
+ * hop of a prefix is measured, Interests are spread over its next hops at
+ * random, as without strategy.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_random.h>
+
+#include <fib/fib_hash_table.h>
+
+#include "defaults.h"
+
+/**
+ * Min number of Interests over which the satisfaction ratio is measured. Once
+ * twice as many are forwarded, counts are halved
+ */
+#define STRATEGY_SAT_WINDOW 64
+
+/**
+ * Weight of a new sample in the smoothed RTT, as a right shift, i.e. 1/8
+ */
+#define STRATEGY_RTT_SHIFT 3
+
+/**
+ * Measurements of a next hop
+ */
+struct strategy_nexthop {
+	uint64_t srtt;			/**< smoothed RTT in TSC cycles, 0 if not measured yet */
+	uint16_t sent;			/**< Interests forwarded in the current window */
+	uint16_t satisfied;		/**< Interests of the window which returned a Data */
+};
+
+/**
+ * Forwarding strategy of an lcore
+ */
+typedef struct strategy {
+	uint32_t nb_nexthops;		/**< number of entries of the FIB measured */
+	uint32_t count;				/**< Interests forwarded with several next hops */
+	struct strategy_nexthop *nexthop;	/**< measurements, by index in the forwarding table of the FIB */
+} __rte_cache_aligned strategy_t;
+
+/*
+ * Return whether next hop a is expected to return Data faster than b, i.e.
+ * srtt(a) * sent(a) / satisfied(a) < srtt(b) * sent(b) / satisfied(b),
+ * compared without division. Next hops not measured are never better
+ */
+static inline uint8_t
+strategy_better(const struct strategy_nexthop *a, const struct strategy_nexthop *b) {
+	if (a->srtt == 0) {
+		return 0;
+	}
+	if (b->srtt == 0) {
+		return 1;
+	}
+	return a->srtt * (a->sent + 1U) * (b->satisfied + 1U) <
+			b->srtt * (b->sent + 1U) * (a->satisfied + 1U);
+}
+
+/**
+ * Select the next hop to which an Interest is forwarded
+ *
+ * @param s
+ *   Strategy of the lcore
+ * @param nexthops
+ *   Next hops of the longest prefix of the name, excluding the face the
+ *   Interest came from
+ * @param n
+ *   Number of next hops, at least 1
+ * @param probe
+ *   Set to 1 if the next hop selected is not the best one and is probed
+ *
+ * @return
+ *   Index of the next hop selected in nexthops
+ */
+static inline uint8_t
+strategy_select(strategy_t *s, const struct fib_nexthop *nexthops, uint8_t n,
+		uint8_t *probe) {
+	const struct strategy_nexthop *best_nh, *nh;
+	uint8_t best, i;
+
+	*probe = 0;
+	if (n == 1) {
+		return 0;
+	}
+	best = 0;
+	best_nh = nexthops[0].index < s->nb_nexthops ? &s->nexthop[nexthops[0].index] : NULL;
+	for (i = 1; i < n; i++) {
+		if (unlikely(nexthops[i].index >= s->nb_nexthops)) {
+			continue;
+		}
+		nh = &s->nexthop[nexthops[i].index];
+		if (best_nh == NULL || strategy_better(nh, best_nh)) {
+			best = i;
+			best_nh = nh;
+		}
+	}
+	if (best_nh == NULL || best_nh->srtt == 0) {
+		return (uint8_t) (rte_rand() % n);
+	}
+	if (unlikely((++s->count & (STRATEGY_PROBE_PERIOD - 1)) == 0)) {
+		*probe = 1;
+		return (uint8_t) ((best + 1 + (s->count / STRATEGY_PROBE_PERIOD) % (n - 1)) % n);
+	}
+	return best;
+}
+
+/**
+ * Account for an Interest forwarded to a next hop
+ *
+ * @param s
+ *   Strategy of the lcore
+ * @param nexthop
+ *   Index of the next hop in the forwarding table of the FIB
+ */
+static inline void
+strategy_sent(strategy_t *s, uint32_t nexthop) {
+	struct strategy_nexthop *nh;
+
+	if (unlikely(nexthop >= s->nb_nexthops)) {
+		return;
+	}
+	nh = &s->nexthop[nexthop];
+	if (unlikely(nh->sent >= 2 * STRATEGY_SAT_WINDOW)) {
+		nh->sent /= 2;
+		nh->satisfied /= 2;
+	}
+	nh->sent++;
+}
+
+/**
+ * Account for a Data returned by a next hop
+ *
+ * @param s
+ *   Strategy of the lcore
+ * @param nexthop
+ *   Index of the next hop in the forwarding table of the FIB
+ * @param rtt
+ *   Time from the forwarding of the Interest to the arrival of the Data, in
+ *   TSC cycles
+ */
+static inline void
+strategy_satisfied(strategy_t *s, uint32_t nexthop, uint64_t rtt) {
+	struct strategy_nexthop *nh;
+
+	if (unlikely(nexthop >= s->nb_nexthops)) {
+		return;
+	}
+	nh = &s->nexthop[nexthop];
+	/* 0 marks next hops not measured */
+	rtt = RTE_MAX(rtt, 1ULL);
+	if (unlikely(nh->srtt == 0)) {
+		nh->srtt = rtt;
+	} else {
+		nh->srtt = nh->srtt - (nh->srtt >> STRATEGY_RTT_SHIFT) + (rtt >> STRATEGY_RTT_SHIFT);
+	}
+	if (nh->satisfied < nh->sent) {
+		nh->satisfied++;
+	}
+}
+
+/**
+ * Forget the measurements of a next hop, when its FIB entry is added or
+ * deleted, so that they are not applied to another prefix or face
+ *
+ * This is called by the control plane while the lcore may be updating the
+ * same measurements, in which case one sample may be lost or kept
+ *
+ * @param s
+ *   Strategy of the lcore
+ * @param nexthop
+ *   Index of the next hop in the forwarding table of the FIB
+ */
+static inline void
+strategy_reset(strategy_t *s, uint32_t nexthop) {
+	struct strategy_nexthop *nh;
+
+	if (unlikely(nexthop >= s->nb_nexthops)) {
+		return;
+	}
+	nh = &s->nexthop[nexthop];
+	nh->srtt = 0;
+	nh->sent = 0;
+	nh->satisfied = 0;
+}
+
+/**
+ * Create the forwarding strategy of an lcore
+ *
+ * @param nb_nexthops
+ *   Size of the forwarding table of the FIB
+ * @param socket
+ *   NUMA socket on which memory is allocated
+ *
+ * @return
+ *   Pointer to the strategy, NULL if it cannot be allocated
+ */
+strategy_t *strategy_create(uint32_t nb_nexthops, int socket);
+
+/**
+ * Free the forwarding strategy of an lcore
+ *
+ * @param s
+ *   Strategy to free
+ */
+void strategy_free(strategy_t *s);
+
+#endif /* _STRATEGY_H_ */
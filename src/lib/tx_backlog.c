@@ -0,0 +1,46 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <rte_common.h>
+#include <rte_malloc.h>
+
+#include "tx_backlog.h"
+
+tx_backlog_t *tx_backlog_create(const uint32_t *weights, int socket) {
+	tx_backlog_t *b;
+	uint8_t cls;
+
+	RTE_BUILD_BUG_ON((TX_BACKLOG_SIZE & (TX_BACKLOG_SIZE - 1)) != 0);
+	b = rte_zmalloc_socket("TX_BACKLOG", sizeof(tx_backlog_t), RTE_CACHE_LINE_SIZE,
+			socket);
+	if(b == NULL || weights == NULL) {
+		return b;
+	}
+	b->drr = 1;
+	for (cls = 0; cls < TX_NB_CLASSES; cls++) {
+		b->quantum[cls] = RTE_MAX(weights[cls], 1U) * TX_DRR_QUANTUM;
+	}
+	return b;
+}
+
+
+void tx_backlog_free(tx_backlog_t *b) {
+	struct rte_mbuf **pkts;
+	uint16_t n, i;
+	uint8_t cls;
+
+	for (cls = 0; cls < TX_NB_CLASSES; cls++) {
+		while (b->fifo[cls].len > 0) {
+			pkts = tx_backlog_peek(b, cls, &n);
+			for (i = 0; i < n; i++) {
+				rte_pktmbuf_free(pkts[i]);
+			}
+			tx_backlog_consume(b, cls, n);
+		}
+	}
+	rte_free(b);
+}
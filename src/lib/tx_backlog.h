@@ -0,0 +1,258 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _TX_BACKLOG_H_
+#define _TX_BACKLOG_H_
+
+/**
+ * @file
+ *
+ * Software backlog of a TX queue
+ *
+ * Packets that a TX queue of a NIC cannot take because it is full are held in
+ * the backlog of the queue and retried later, instead of being dropped. The
+ * backlog keeps one FIFO per class of packets and is bounded: once it holds
+ * TX_BACKLOG_SIZE packets, Interests are shed first, since their consumers
+ * retransmit them, while a dropped Data wastes the path it came from.
+ *
+ * Classes are served either by strict priority, in the order of their IDs, or
+ * by Deficit Round Robin (DRR), each class receiving a share of the bytes
+ * transmitted proportional to its weight, so that Interests saturating a link
+ * cannot delay Data indefinitely and vice versa.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+#include <rte_mbuf.h>
+
+#include "defaults.h"
+
+/**
+ * Classes of packets transmitted
+ */
+#define TX_CLASS_DATA		0	/**< Data forwarded to downstream faces */
+#define TX_CLASS_CS_HIT		1	/**< Data served by the CS */
+#define TX_CLASS_INTEREST	2	/**< Interests forwarded to upstream faces */
+#define TX_NB_CLASSES		3
+
+/**
+ * FIFO of the packets of one class
+ */
+struct tx_fifo {
+	uint16_t head;		/**< index of the oldest packet */
+	uint16_t len;		/**< number of packets */
+	struct rte_mbuf *m[TX_BACKLOG_SIZE];
+};
+
+/**
+ * Backlog of a TX queue
+ */
+typedef struct tx_backlog {
+	uint16_t len;		/**< number of packets of all classes */
+	uint8_t drr;		/**< serve classes by DRR instead of by priority */
+	uint8_t next;		/**< class being served by DRR */
+	uint8_t in_turn;	/**< the class being served has received its quantum */
+	uint32_t quantum[TX_NB_CLASSES];	/**< bytes credited to each class at each DRR round */
+	uint32_t deficit[TX_NB_CLASSES];	/**< bytes each class may still send */
+	struct tx_fifo fifo[TX_NB_CLASSES];
+} __rte_cache_aligned tx_backlog_t;
+
+/**
+ * Append a packet to the backlog. If the backlog is full, the packet is
+ * dropped if it is an Interest or if there is no Interest to drop instead,
+ * otherwise the oldest Interest is dropped
+ *
+ * @param b
+ *   Backlog of the TX queue
+ * @param m
+ *   Packet to append
+ * @param cls
+ *   Class of the packet, TX_CLASS_*
+ *
+ * @return
+ *   The packet dropped, to be freed by the caller, or NULL if none
+ */
+static inline struct rte_mbuf *
+tx_backlog_push(tx_backlog_t *b, struct rte_mbuf *m, uint8_t cls) {
+	struct tx_fifo *f = &b->fifo[cls];
+	struct tx_fifo *shed = &b->fifo[TX_CLASS_INTEREST];
+	struct rte_mbuf *drop = NULL;
+
+	if (unlikely(b->len == TX_BACKLOG_SIZE)) {
+		if (cls == TX_CLASS_INTEREST || shed->len == 0) {
+			return m;
+		}
+		drop = shed->m[shed->head];
+		shed->head = (shed->head + 1) & (TX_BACKLOG_SIZE - 1);
+		shed->len--;
+		b->len--;
+	}
+	f->m[(f->head + f->len) & (TX_BACKLOG_SIZE - 1)] = m;
+	f->len++;
+	b->len++;
+	return drop;
+}
+
+/**
+ * Return the oldest packets of a class held in the backlog, contiguous in
+ * the FIFO of the class
+ *
+ * @param b
+ *   Backlog of the TX queue
+ * @param cls
+ *   Class of the packets, TX_CLASS_*
+ * @param n
+ *   Set to the number of packets returned, possibly fewer than those held
+ *
+ * @return
+ *   Array of the packets
+ */
+static inline struct rte_mbuf **
+tx_backlog_peek(tx_backlog_t *b, uint8_t cls, uint16_t *n) {
+	struct tx_fifo *f = &b->fifo[cls];
+
+	*n = RTE_MIN(f->len, (uint16_t) (TX_BACKLOG_SIZE - f->head));
+	return &f->m[f->head];
+}
+
+/**
+ * Remove the oldest packets of a class from the backlog, once transmitted
+ *
+ * @param b
+ *   Backlog of the TX queue
+ * @param cls
+ *   Class of the packets, TX_CLASS_*
+ * @param n
+ *   Number of packets to remove, at most the number returned by
+ *   tx_backlog_peek()
+ */
+static inline void
+tx_backlog_consume(tx_backlog_t *b, uint8_t cls, uint16_t n) {
+	struct tx_fifo *f = &b->fifo[cls];
+
+	f->head = (f->head + n) & (TX_BACKLOG_SIZE - 1);
+	f->len -= n;
+	b->len -= n;
+}
+
+/* Move DRR to the next class, the current one keeping its deficit if busy */
+static inline void
+tx_backlog_drr_skip(tx_backlog_t *b) {
+	if (b->fifo[b->next].len == 0) {
+		b->deficit[b->next] = 0;
+	}
+	b->in_turn = 0;
+	b->next = (uint8_t) ((b->next + 1) % TX_NB_CLASSES);
+}
+
+/**
+ * Return the packets to transmit next: the oldest packets of the first
+ * non-empty class with priority, or those the deficit of the class served by
+ * DRR allows. With DRR, their bytes are charged to the class, and refunded by
+ * tx_backlog_done() for those not transmitted
+ *
+ * @param b
+ *   Backlog of the TX queue, not empty
+ * @param cls
+ *   Set to the class of the packets returned, TX_CLASS_*
+ * @param n
+ *   Set to the number of packets returned, at least 1
+ *
+ * @return
+ *   Array of the packets, contiguous in the FIFO of their class
+ */
+static inline struct rte_mbuf **
+tx_backlog_next(tx_backlog_t *b, uint8_t *cls, uint16_t *n) {
+	struct rte_mbuf **pkts;
+	uint32_t bytes;
+	uint16_t avail, i;
+	uint8_t c;
+
+	if (!b->drr) {
+		for (c = 0; b->fifo[c].len == 0; c++);
+		*cls = c;
+		return tx_backlog_peek(b, c, n);
+	}
+	for (;;) {
+		c = b->next;
+		if (b->fifo[c].len == 0) {
+			tx_backlog_drr_skip(b);
+			continue;
+		}
+		if (!b->in_turn) {
+			b->deficit[c] += b->quantum[c];
+			b->in_turn = 1;
+		}
+		pkts = tx_backlog_peek(b, c, &avail);
+		for (i = 0, bytes = 0; i < avail && bytes + pkts[i]->pkt_len <= b->deficit[c]; i++) {
+			bytes += pkts[i]->pkt_len;
+		}
+		if (i == 0) {
+			tx_backlog_drr_skip(b);
+			continue;
+		}
+		b->deficit[c] -= bytes;
+		*cls = c;
+		*n = i;
+		return pkts;
+	}
+}
+
+/**
+ * Remove the packets returned by tx_backlog_next() which were transmitted
+ * from the backlog
+ *
+ * @param b
+ *   Backlog of the TX queue
+ * @param cls
+ *   Class of the packets, as returned by tx_backlog_next()
+ * @param n
+ *   Number of packets returned by tx_backlog_next()
+ * @param sent
+ *   Number of those packets transmitted, the oldest ones
+ */
+static inline void
+tx_backlog_done(tx_backlog_t *b, uint8_t cls, uint16_t n, uint16_t sent) {
+	struct tx_fifo *f = &b->fifo[cls];
+	uint16_t i;
+
+	if (b->drr) {
+		for (i = sent; i < n; i++) {
+			b->deficit[cls] += f->m[(f->head + i) & (TX_BACKLOG_SIZE - 1)]->pkt_len;
+		}
+	}
+	tx_backlog_consume(b, cls, sent);
+	if (b->drr && f->len == 0) {
+		tx_backlog_drr_skip(b);
+	}
+}
+
+/**
+ * Create the backlog of a TX queue
+ *
+ * @param weights
+ *   Weight of each class with DRR, each class being credited weight *
+ *   TX_DRR_QUANTUM bytes per round, or NULL to serve classes by priority
+ * @param socket
+ *   NUMA socket on which memory is allocated
+ *
+ * @return
+ *   Pointer to the backlog, NULL if it cannot be allocated
+ */
+tx_backlog_t *tx_backlog_create(const uint32_t *weights, int socket);
+
+/**
+ * Free the backlog of a TX queue and the packets it holds
+ *
+ * @param b
+ *   Backlog to free
+ */
+void tx_backlog_free(tx_backlog_t *b);
+
+#endif /* _TX_BACKLOG_H_ */
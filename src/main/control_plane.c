@@ -17,6 +17,8 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 
+#include <rte_branch_prediction.h>
+#include <rte_cycles.h>
 #include <rte_lcore.h>
 #include <rte_ethdev.h>
 #include <rte_ether.h>
@@ -26,8 +28,12 @@
 #include <packet.h>
 
 #include <fib/fib.h>
+#include <cs/cs.h>
+#include <cs/cs_shared.h>
 
 #include "control_plane.h"
+#include "elastic.h"
+#include "eventdev.h"
 
 #ifndef NULL
 #define NULL   ((void *) 0)
@@ -69,34 +75,114 @@ int ctrl_loop(__attribute__((unused)) void *arg) {
 
 	sockfd = app_conf.sockfd;
 
-	while (1) {
+	while (likely(!app_conf.force_quit)) {
 		uint8_t buffer[1500];
 		addr_len = sizeof(their_addr);
 
+		/* Commands are received with a timeout, so load is checked regularly */
+		if (app_conf.elastic) {
+			elastic_step(rte_rdtsc());
+		}
+
 		if ((numbytes = recvfrom(sockfd, buffer, 1500, 0, (struct sockaddr *)&their_addr, &addr_len)) == -1)
 		{
+		    /* Timeout, check whether the application is stopping */
+		    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+		        continue;
 		    perror("recvfrom");
 		    exit(1);
 		}
 		CONTROL_PLANE_LOG("[LCORE_%u] Received %d Bytes message\n", lcore_id, numbytes);
 
-		parse_packet(buffer, &packet);
+		/* The command, parsed as a name, must be within the bytes received */
+		if (parse_packet(buffer, (uint16_t) numbytes, &packet) != 0) {
+			CONTROL_PLANE_LOG("[LCORE_%u]: Error, malformed FIB update command.\n", lcore_id);
+			continue;
+		}
 
-		char command[3];
+		char command[4];
 		if (packet.name_len <3){
 			CONTROL_PLANE_LOG("[LCORE_%u]: Error, invalid FIB update command. Too short.\n", lcore_id);
 			continue;
 		}
 
 		memcpy(command, packet.name, 3);
+		command[3] = '\0';
 
 		uint8_t * prefix = packet.name + 4;
-		uint8_t* prefix_delim = strchr(packet.name + 4, ':');
+		if (packet.name_len <= 4) {
+			CONTROL_PLANE_LOG("[LCORE_%u]: Error, invalid FIB update command. No prefix\n", lcore_id);
+			continue;
+		}
+
+		if (strcmp(command, "PRG") == 0) {
+			// PRG has no last field: purge all content under prefix in all cores
+			uint16_t purge_len = packet.name_len - 4;
+			if (purge_len > MAX_NAME_LEN) {
+				CONTROL_PLANE_LOG("[LCORE_%u]: Error, invalid FIB update command. Prefix too long\n", lcore_id);
+				continue;
+			}
+			for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+				/* Workers of the event device only borrow the CS of shards */
+				if (lcore_conf[lcore_id].cs == NULL || eventdev_conf.nb_shards > 0) {
+					continue;
+				}
+				int ret, tries = 0;
+				/* The queue of requests may be full while the lcore is busy */
+				while ((ret = cs_purge_request(lcore_conf[lcore_id].cs, prefix, purge_len)) == -ENOSPC
+						&& ++tries < CS_PURGE_QUEUE_SIZE) {
+					usleep(BURST_TX_DRAIN_US);
+				}
+				if (ret >= 0)
+					CONTROL_PLANE_LOG("[LCORE_%u] PURGE '%.*s' REQUESTED\n", lcore_id, (int)purge_len, (char *)prefix);
+				else
+					CONTROL_PLANE_LOG("[LCORE_%u] PURGE '%.*s' UNSUCCESFUL \n", lcore_id, (int)purge_len, (char *)prefix);
+			}
+			// Shards are purged by the workers processing them
+			uint16_t shard_id;
+			uint32_t nb_requested = 0;
+			for (shard_id = 0; shard_id < eventdev_conf.nb_shards; shard_id++) {
+				int ret, tries = 0;
+				while ((ret = cs_purge_request(eventdev_conf.shards[shard_id].cs, prefix, purge_len)) == -ENOSPC
+						&& ++tries < CS_PURGE_QUEUE_SIZE) {
+					usleep(BURST_TX_DRAIN_US);
+				}
+				nb_requested += ret >= 0;
+			}
+			if (eventdev_conf.nb_shards > 0)
+				CONTROL_PLANE_LOG("PURGE '%.*s' REQUESTED in %u/%u shards\n", (int)purge_len,
+						(char *)prefix, nb_requested, eventdev_conf.nb_shards);
+			// Shared CSs are purged here, once per socket
+			cs_shared_t *purged_cs[APP_MAX_SOCKETS] = { NULL };
+			for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+				cs_shared_t *cs_shared = lcore_conf[lcore_id].cs_shared;
+				if (cs_shared == NULL) {
+					continue;
+				}
+				for (socket_id = 0; socket_id < APP_MAX_SOCKETS && purged_cs[socket_id] != NULL
+						&& purged_cs[socket_id] != cs_shared; socket_id++);
+				if (socket_id == APP_MAX_SOCKETS || purged_cs[socket_id] != NULL) {
+					continue;
+				}
+				purged_cs[socket_id] = cs_shared;
+				uint32_t purged = cs_shared_purge(cs_shared, prefix, purge_len);
+				CONTROL_PLANE_LOG("[LCORE_%u] PURGE '%.*s' %u entries removed from shared CS\n",
+						lcore_id, (int)purge_len, (char *)prefix, purged);
+			}
+			continue;
+		}
+
+		uint8_t* prefix_delim = memchr(prefix, ':', packet.name_len - 4);
 		if (prefix_delim == NULL) {
 			printf("Error, invalid FIB update command\n");
 			continue;
 		}
 		uint16_t prefix_len = prefix_delim - prefix;
+		/* Prefixes are copied in FIB and CS entries of MAX_NAME_LEN bytes */
+		if (prefix_len > MAX_NAME_LEN) {
+			CONTROL_PLANE_LOG("[LCORE_%u]: Error, invalid FIB update command. Prefix too long\n", lcore_id);
+			continue;
+		}
 
 		uint8_t* face_delim = packet.name + packet.name_len;
 		if (face_delim ==NULL){
@@ -105,7 +191,12 @@ int ctrl_loop(__attribute__((unused)) void *arg) {
 		}
 		uint16_t face_len = packet.name_len - prefix_len - 3 /* Command len */ - 2 /* Separators len */;
 
-		char sface[5];
+		/* The last field is either a port ID or a freshness period (FRS) */
+		char sface[11];
+		if (face_len >= sizeof(sface)) {
+			CONTROL_PLANE_LOG("[LCORE_%u]: Error, invalid FIB update command. Last field too long\n", lcore_id);
+			continue;
+		}
 		memcpy(sface, prefix_delim + 1, face_len);
 		sface[face_len] = '\0';
 		uint16_t face = atoi(sface);
@@ -123,7 +214,10 @@ int ctrl_loop(__attribute__((unused)) void *arg) {
 					CONTROL_PLANE_LOG("Error, invalid interface\n");
 					continue;
 				}
-				int ret = fib_add(lcore_conf[lcore_id].fib, prefix, prefix_len, face);
+				uint32_t fib_index;
+				int ret = fib_add(lcore_conf[lcore_id].fib, prefix, prefix_len, face, &fib_index);
+				if (ret >= 0 && lcore_conf[lcore_id].strategy != NULL)
+					strategy_reset(lcore_conf[lcore_id].strategy, fib_index);
 				if (ret >= 0)
 					CONTROL_PLANE_LOG("[LCORE_%u] FIB ENTRY '%.*s' interface %d ADDED\n", lcore_id, (int)prefix_len, (char *)prefix, face);
 				else 
@@ -140,13 +234,30 @@ int ctrl_loop(__attribute__((unused)) void *arg) {
 					CONTROL_PLANE_LOG("Error, invalid interface\n");
 					continue;
 				}
-				int ret = fib_del(lcore_conf[lcore_id].fib, prefix, prefix_len, face);
+				uint32_t fib_index;
+				int ret = fib_del(lcore_conf[lcore_id].fib, prefix, prefix_len, face, &fib_index);
+				if (ret >= 0 && lcore_conf[lcore_id].strategy != NULL)
+					strategy_reset(lcore_conf[lcore_id].strategy, fib_index);
 				if (ret >= 0)
 					CONTROL_PLANE_LOG("[LCORE_%u] FIB ENTRY '%.*s' interface %d DELETED\n", lcore_id, (int)prefix_len, (char *)prefix, face);
 				else 
 					CONTROL_PLANE_LOG("[LCORE_%u] FIB ENTRY DELETE '%.*s' interface %d UNSUCCESFUL \n", lcore_id, (int)prefix_len, (char *)prefix, face);
 			  }
 		}
+		else if (strcmp(command, "FRS") == 0){
+			// Set default freshness period of Data under prefix in all cores
+			uint32_t freshness_ms = RTE_MIN(strtoul(sface, NULL, 10), (unsigned long) CS_MAX_FRESHNESS_MS);
+			for(lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++){
+				if(lcore_conf[lcore_id].fib == NULL){
+					    continue;
+				}
+				int ret = cs_freshness_set(&lcore_conf[lcore_id].freshness, prefix, prefix_len, freshness_ms);
+				if (ret >= 0)
+					CONTROL_PLANE_LOG("[LCORE_%u] FRESHNESS '%.*s' %u ms SET\n", lcore_id, (int)prefix_len, (char *)prefix, freshness_ms);
+				else
+					CONTROL_PLANE_LOG("[LCORE_%u] FRESHNESS SET '%.*s' %u ms UNSUCCESFUL \n", lcore_id, (int)prefix_len, (char *)prefix, freshness_ms);
+			}
+		}
 	}
 	return 0;
 }
@@ -13,6 +13,7 @@
 #include <stdarg.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <unistd.h>
 
 #include <rte_common.h>
 #include <rte_log.h>
@@ -30,20 +31,39 @@
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
 #include <rte_hash_crc.h>
+#include <rte_random.h>
+#ifdef RTE_LIBRTE_EVENTDEV
+#include <rte_eventdev.h>
+#endif
 
 #include <config.h>
 #include <packet.h>
+#include <name_hash.h>
 #include <fib/fib.h>
 #include <pit/pit.h>
 #include <cs/cs.h>
+#include <cs/cs_disk.h>
+#include <cs/cs_snapshot.h>
 
 #include "data_plane.h"
+#include "eventdev.h"
+#include "idle.h"
 #include "init.h"
+#include "steering.h"
 #include "util.h"
 
 
 #define DATA_PLANE_LOG(...) printf("[DATA PLANE]: " __VA_ARGS__)
 
+/*
+ * Port of the mbufs of CS entries migrated to another lcore, which never
+ * receives packets
+ */
+#define ICN_MIGRATED_PORT 0xFF
+
+/* Flag of the descriptor of an Interest already admitted by the rate limit of its face */
+#define ICN_DESC_ADMITTED 0x01
+
 /* 
  * LOGS suppression. Remove if need to debug.
  */
@@ -55,16 +75,121 @@
 #endif
 
 
+/* Packets buffered for transmission on a port */
 struct mbuf_table {
 	uint16_t len;
-	struct rte_mbuf *m_table[MAX_PKT_BURST];
-	uint8_t keep[MAX_PKT_BURST];
+	uint16_t burst;			/* number of packets sent as soon as buffered */
+	uint32_t enqueued;		/* packets buffered since the rate was last measured */
+	uint32_t rate;			/* EWMA of packets buffered per TX_RATE_PERIOD_US, times 16 */
+	uint64_t first_tsc;		/* TSC at which the oldest buffered packet was buffered */
+	uint64_t drain_tsc;		/* max time packets stay buffered, in TSC cycles */
+	uint64_t rate_tsc;		/* TSC at which the rate was last measured */
+	uint64_t period_tsc;	/* TX_RATE_PERIOD_US in TSC cycles, 0 without adaptive batching */
+	uint64_t slo_tsc;		/* max TX batching delay in TSC cycles */
+	struct rte_mbuf *m_table[TX_BURST_MAX];
+	uint8_t cls[TX_BURST_MAX];	/* class of each packet, TX_CLASS_* */
 } __rte_cache_aligned;
 
+/* Received packets to free at the end of the processing of a burst */
+struct mbuf_free_list {
+	uint16_t len;
+	struct rte_mbuf *m_table[MAX_PKT_BURST];
+};
+
+/* State of a packet of a burst processed in stages */
+struct icn_burst_pkt {
+	struct rte_mbuf *m;
+	struct icn_packet icn_pkt;
+	uint32_t crc;
+	uint8_t port;	/* RX port */
+};
+
+
+/*
+ * Packet rate of an lcore, in millions of packets per second, over the time
+ * spent processing received packets, i.e. excluding idle polling
+ */
+static double
+icn_busy_mpps(const struct stats *stats) {
+	if (stats->busy_cycles == 0) {
+		return 0;
+	}
+	return (double) stats->rx_pkts * rte_get_tsc_hz() / stats->busy_cycles / 1e6;
+}
+
+
+/* TSC at which statistics were last reset */
+static uint64_t stats_start_tsc;
+
+
+/* Convert a number of TSC cycles to microseconds */
+static double
+icn_cycles_us(uint64_t cycles) {
+	return (double) cycles * US_PER_S / rte_get_tsc_hz();
+}
+
+
+/*
+ * Share of the time since statistics were reset that lcores spent sleeping
+ * or waiting for RX interrupts, in percent
+ */
+static double
+icn_idle_pct(const struct stats *stats, unsigned nb_lcores) {
+	uint64_t elapsed = rte_rdtsc() - stats_start_tsc;
+	if (elapsed == 0 || nb_lcores == 0) {
+		return 0;
+	}
+	return (double) stats->idle_cycles * 100 / elapsed / nb_lcores;
+}
+
+
+/*
+ * Print the histogram of TX batching delay of each port which sent packets,
+ * i.e. the number of batches by the time their oldest packet was buffered
+ */
+static void
+icn_print_tx_delay_hist(const struct stats *stats) {
+	uint8_t port_id;
+	unsigned b, sent;
+
+	for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		sent = 0;
+		for (b = 0; b < TX_DELAY_HIST_BUCKETS; b++) {
+			sent += stats->tx_delay_hist[port_id][b];
+		}
+		if (sent == 0) {
+			continue;
+		}
+		printf("    TX batching delay on port %u (us):", port_id);
+		printf(" <1: %u", stats->tx_delay_hist[port_id][0]);
+		for (b = 1; b < TX_DELAY_HIST_BUCKETS - 1; b++) {
+			printf(", %u-%u: %u", 1U << (b - 1), 1U << b, stats->tx_delay_hist[port_id][b]);
+		}
+		printf(", >=%u: %u\n", 1U << (b - 1), stats->tx_delay_hist[port_id][b]);
+	}
+}
+
+
+/* Name of the role of an lcore, as printed in stats */
+static const char *
+icn_role_name(uint8_t role) {
+	switch (role) {
+	case LCORE_ROLE_RX:
+		return "RX";
+	case LCORE_ROLE_WORKER:
+		return "worker";
+	case LCORE_ROLE_TX:
+		return "TX";
+	default:
+		return "forwarding";
+	}
+}
+
 
 void reset_stats() {
 	uint8_t lcore_id, nb_lcores;
 	nb_lcores = get_nb_lcores_available();
+	stats_start_tsc = rte_rdtsc();
 	for(lcore_id = 0; lcore_id < nb_lcores; lcore_id++) {
 		lcore_conf[lcore_id].stats.int_recv = 0;
 		lcore_conf[lcore_id].stats.int_cs_hit = 0;
@@ -78,12 +203,64 @@ void reset_stats() {
 		lcore_conf[lcore_id].stats.nic_pkt_drop = 0;
 		lcore_conf[lcore_id].stats.sw_pkt_drop = 0;
 		lcore_conf[lcore_id].stats.malformed = 0;
+		lcore_conf[lcore_id].stats.int_cs_disk_hit = 0;
+		lcore_conf[lcore_id].stats.int_cs_bf_skip = 0;
+		lcore_conf[lcore_id].stats.int_cs_bf_fp = 0;
+		lcore_conf[lcore_id].stats.name_hash_mismatch = 0;
+		lcore_conf[lcore_id].stats.ring_drop = 0;
+		lcore_conf[lcore_id].stats.handoff = 0;
+		lcore_conf[lcore_id].stats.data_handoff_out = 0;
+		lcore_conf[lcore_id].stats.data_handoff_in = 0;
+		lcore_conf[lcore_id].stats.hot_replica_out = 0;
+		lcore_conf[lcore_id].stats.hot_replica_in = 0;
+		lcore_conf[lcore_id].stats.int_hot_hit = 0;
+		lcore_conf[lcore_id].stats.cs_migrated_out = 0;
+		lcore_conf[lcore_id].stats.cs_migrated_in = 0;
+		lcore_conf[lcore_id].stats.int_probe = 0;
+		lcore_conf[lcore_id].stats.rtt_samples = 0;
+		lcore_conf[lcore_id].stats.rtt_cycles = 0;
+		lcore_conf[lcore_id].stats.idle_sleeps = 0;
+		lcore_conf[lcore_id].stats.idle_intr_waits = 0;
+		lcore_conf[lcore_id].stats.idle_intr_wakeups = 0;
+		lcore_conf[lcore_id].stats.idle_wakeups = 0;
+		lcore_conf[lcore_id].stats.idle_cycles = 0;
+		lcore_conf[lcore_id].stats.wakeup_cycles = 0;
+		lcore_conf[lcore_id].stats.max_wakeup_cycles = 0;
+		lcore_conf[lcore_id].stats.tx_backlogged = 0;
+		lcore_conf[lcore_id].stats.tx_backlog_max = 0;
+		lcore_conf[lcore_id].stats.tx_backlog_int_drop = 0;
+		lcore_conf[lcore_id].stats.tx_backlog_data_drop = 0;
+		memset(lcore_conf[lcore_id].stats.tx_backlog_sent, 0,
+				sizeof(lcore_conf[lcore_id].stats.tx_backlog_sent));
+		lcore_conf[lcore_id].stats.rx_pkts = 0;
+		lcore_conf[lcore_id].stats.busy_cycles = 0;
+		memset(lcore_conf[lcore_id].stats.tx_delay_hist, 0,
+				sizeof(lcore_conf[lcore_id].stats.tx_delay_hist));
+		memset(lcore_conf[lcore_id].stats.int_rate_drop, 0,
+				sizeof(lcore_conf[lcore_id].stats.int_rate_drop));
+		memset(lcore_conf[lcore_id].stats.int_quota_drop, 0,
+				sizeof(lcore_conf[lcore_id].stats.int_quota_drop));
+		if(lcore_conf[lcore_id].cs != NULL) {
+			lcore_conf[lcore_id].cs->expired = 0;
+			lcore_conf[lcore_id].cs->purged = 0;
+		}
+		if(lcore_conf[lcore_id].cs != NULL && lcore_conf[lcore_id].cs->disk != NULL) {
+			lcore_conf[lcore_id].cs->disk->writes = 0;
+			lcore_conf[lcore_id].cs->disk->write_drops = 0;
+			lcore_conf[lcore_id].cs->disk->reads = 0;
+			lcore_conf[lcore_id].cs->disk->read_errors = 0;
+		}
+		if(lcore_conf[lcore_id].cs_shared != NULL) {
+			lcore_conf[lcore_id].cs_shared->lcore[lcore_id].read_retries = 0;
+			lcore_conf[lcore_id].cs_shared->lcore[lcore_id].lock_waits = 0;
+		}
 	}
 }
 
 
 void print_stats() {
-	uint8_t lcore_id, nb_lcores;
+	uint8_t lcore_id, nb_lcores, port_id;
+	unsigned nb_fwd_lcores = 0, b;
 	nb_lcores = get_nb_lcores_available();
 	struct stats global_stats;
 	/* Init global stats */
@@ -99,12 +276,48 @@ void print_stats() {
 	global_stats.nic_pkt_drop = 0;
 	global_stats.sw_pkt_drop = 0;
 	global_stats.malformed = 0;
+	global_stats.int_cs_disk_hit = 0;
+	global_stats.int_cs_bf_skip = 0;
+	global_stats.int_cs_bf_fp = 0;
+	global_stats.name_hash_mismatch = 0;
+	global_stats.ring_drop = 0;
+	global_stats.handoff = 0;
+	global_stats.data_handoff_out = 0;
+	global_stats.data_handoff_in = 0;
+	global_stats.hot_replica_out = 0;
+	global_stats.hot_replica_in = 0;
+	global_stats.int_hot_hit = 0;
+	global_stats.cs_migrated_out = 0;
+	global_stats.cs_migrated_in = 0;
+	global_stats.int_probe = 0;
+	global_stats.rtt_samples = 0;
+	global_stats.rtt_cycles = 0;
+	global_stats.idle_sleeps = 0;
+	global_stats.idle_intr_waits = 0;
+	global_stats.idle_intr_wakeups = 0;
+	global_stats.idle_wakeups = 0;
+	global_stats.idle_cycles = 0;
+	global_stats.wakeup_cycles = 0;
+	global_stats.max_wakeup_cycles = 0;
+	global_stats.tx_backlogged = 0;
+	global_stats.tx_backlog_max = 0;
+	global_stats.tx_backlog_int_drop = 0;
+	global_stats.tx_backlog_data_drop = 0;
+	memset(global_stats.tx_backlog_sent, 0, sizeof(global_stats.tx_backlog_sent));
+	global_stats.rx_pkts = 0;
+	global_stats.busy_cycles = 0;
+	memset(global_stats.tx_delay_hist, 0, sizeof(global_stats.tx_delay_hist));
+	memset(global_stats.int_rate_drop, 0, sizeof(global_stats.int_rate_drop));
+	memset(global_stats.int_quota_drop, 0, sizeof(global_stats.int_quota_drop));
 	printf("Statistics:\n");
 	for(lcore_id = 0; lcore_id < nb_lcores; lcore_id++) {
 		if(!rte_lcore_is_enabled(lcore_id)) {
 			continue;
 		}
 		printf("  [LCORE %u]:\n", lcore_id);
+		if(app_conf.pipeline) {
+			printf("    Role: %s\n", icn_role_name(lcore_conf[lcore_id].role));
+		}
 		printf("    Interest recv: %u\n", lcore_conf[lcore_id].stats.int_recv);
 		printf("    CS hits: %u\n", lcore_conf[lcore_id].stats.int_cs_hit);
 		printf("    PIT hits: %u\n", lcore_conf[lcore_id].stats.int_pit_hit);
@@ -117,6 +330,83 @@ void print_stats() {
 		printf("    Packet drops (NIC): %u\n", lcore_conf[lcore_id].stats.nic_pkt_drop);
 		printf("    Packet drops (SW): %u\n", lcore_conf[lcore_id].stats.sw_pkt_drop);
 		printf("    Malformed: %u\n", lcore_conf[lcore_id].stats.malformed);
+		printf("    CS Bloom filter skips: %u\n", lcore_conf[lcore_id].stats.int_cs_bf_skip);
+		printf("    CS Bloom filter false positives: %u\n", lcore_conf[lcore_id].stats.int_cs_bf_fp);
+		if(app_conf.trust_name_hash) {
+			printf("    Name hash mismatches: %u\n", lcore_conf[lcore_id].stats.name_hash_mismatch);
+		}
+		printf("    Packet drops (handoff rings): %u\n", lcore_conf[lcore_id].stats.ring_drop);
+		if(!app_conf.pipeline && !app_conf.sw_steering) {
+			printf("    Data handed over to owner lcore: %u\n", lcore_conf[lcore_id].stats.data_handoff_out);
+			printf("    Data received from other lcores: %u\n", lcore_conf[lcore_id].stats.data_handoff_in);
+		}
+		if(app_conf.sw_steering) {
+			printf("    Packets steered to other lcores: %u\n", lcore_conf[lcore_id].stats.handoff);
+		}
+		if(app_conf.hot_names) {
+			printf("    Hot Data replicas sent: %u\n", lcore_conf[lcore_id].stats.hot_replica_out);
+			printf("    Hot Data replicas received: %u\n", lcore_conf[lcore_id].stats.hot_replica_in);
+			printf("    Interests served by hot replicas: %u\n", lcore_conf[lcore_id].stats.int_hot_hit);
+		}
+		if(app_conf.elastic) {
+			printf("    State: %s\n", lcore_conf[lcore_id].state == LCORE_ACTIVE ? "active" :
+					lcore_conf[lcore_id].state == LCORE_DRAINING ? "draining" : "parked");
+			printf("    CS entries migrated to other lcores: %u\n", lcore_conf[lcore_id].stats.cs_migrated_out);
+			printf("    CS entries migrated from other lcores: %u\n", lcore_conf[lcore_id].stats.cs_migrated_in);
+		}
+		if(app_conf.rtt_strategy) {
+			printf("    Interests probing next hops: %u\n", lcore_conf[lcore_id].stats.int_probe);
+			printf("    Mean RTT (us): %.1f\n", lcore_conf[lcore_id].stats.rtt_samples == 0 ? 0.0 :
+					icn_cycles_us(lcore_conf[lcore_id].stats.rtt_cycles) /
+					lcore_conf[lcore_id].stats.rtt_samples);
+		}
+		if(app_conf.idle_policy != IDLE_POLICY_POLL && lcore_id != CONTROL_PLANE_LCORE) {
+			printf("    Time asleep: %.1f%%\n", icn_idle_pct(&lcore_conf[lcore_id].stats, 1));
+			printf("    Sleeps: %u\n", lcore_conf[lcore_id].stats.idle_sleeps);
+			printf("    RX interrupt waits: %u\n", lcore_conf[lcore_id].stats.idle_intr_waits);
+			printf("    Wake-ups by RX interrupts: %u\n", lcore_conf[lcore_id].stats.idle_intr_wakeups);
+			printf("    Sleeps ended with packets waiting: %u\n", lcore_conf[lcore_id].stats.idle_wakeups);
+			if(lcore_conf[lcore_id].stats.idle_wakeups > 0) {
+				printf("    Wake-up latency bound (us): mean %.1f, max %.1f\n",
+						icn_cycles_us(lcore_conf[lcore_id].stats.wakeup_cycles) /
+						lcore_conf[lcore_id].stats.idle_wakeups,
+						icn_cycles_us(lcore_conf[lcore_id].stats.max_wakeup_cycles));
+			}
+			nb_fwd_lcores++;
+		}
+		if(lcore_conf[lcore_id].stats.tx_backlogged > 0) {
+			printf("    Packets held in TX backlogs: %u\n", lcore_conf[lcore_id].stats.tx_backlogged);
+			printf("    TX backlog max depth: %u\n", lcore_conf[lcore_id].stats.tx_backlog_max);
+			printf("    TX backlog drops (Interest/Data): %u/%u\n",
+					lcore_conf[lcore_id].stats.tx_backlog_int_drop,
+					lcore_conf[lcore_id].stats.tx_backlog_data_drop);
+			printf("    TX backlog sent (Data/CS hits/Interests): %u/%u/%u\n",
+					lcore_conf[lcore_id].stats.tx_backlog_sent[TX_CLASS_DATA],
+					lcore_conf[lcore_id].stats.tx_backlog_sent[TX_CLASS_CS_HIT],
+					lcore_conf[lcore_id].stats.tx_backlog_sent[TX_CLASS_INTEREST]);
+		}
+		printf("    Packets received: %" PRIu64 "\n", lcore_conf[lcore_id].stats.rx_pkts);
+		printf("    Mpps while busy: %.3f\n", icn_busy_mpps(&lcore_conf[lcore_id].stats));
+		if(lcore_conf[lcore_id].cs != NULL) {
+			printf("    CS expired: %u\n", lcore_conf[lcore_id].cs->expired);
+			printf("    CS purged: %u\n", lcore_conf[lcore_id].cs->purged);
+			if(lcore_conf[lcore_id].cs->seg.table != NULL) {
+				printf("    CS segments stored: %u\n", lcore_conf[lcore_id].cs->seg.segments);
+			}
+		}
+		if(lcore_conf[lcore_id].cs != NULL && lcore_conf[lcore_id].cs->disk != NULL) {
+			printf("    CS disk hits: %u\n", lcore_conf[lcore_id].stats.int_cs_disk_hit);
+			printf("    CS disk writes: %u\n", lcore_conf[lcore_id].cs->disk->writes);
+			printf("    CS disk write drops: %u\n", lcore_conf[lcore_id].cs->disk->write_drops);
+			printf("    CS disk reads: %u\n", lcore_conf[lcore_id].cs->disk->reads);
+			printf("    CS disk read errors: %u\n", lcore_conf[lcore_id].cs->disk->read_errors);
+		}
+		if(lcore_conf[lcore_id].cs_shared != NULL) {
+			printf("    Shared CS read retries: %u\n",
+					lcore_conf[lcore_id].cs_shared->lcore[lcore_id].read_retries);
+			printf("    Shared CS lock waits: %u\n",
+					lcore_conf[lcore_id].cs_shared->lcore[lcore_id].lock_waits);
+		}
 		global_stats.int_recv += lcore_conf[lcore_id].stats.int_recv;
 		global_stats.int_cs_hit += lcore_conf[lcore_id].stats.int_cs_hit;
 		global_stats.int_pit_hit += lcore_conf[lcore_id].stats.int_pit_hit;
@@ -129,6 +419,51 @@ void print_stats() {
 		global_stats.nic_pkt_drop += lcore_conf[lcore_id].stats.nic_pkt_drop;
 		global_stats.sw_pkt_drop += lcore_conf[lcore_id].stats.sw_pkt_drop;
 		global_stats.malformed += lcore_conf[lcore_id].stats.malformed;
+		global_stats.int_cs_disk_hit += lcore_conf[lcore_id].stats.int_cs_disk_hit;
+		global_stats.int_cs_bf_skip += lcore_conf[lcore_id].stats.int_cs_bf_skip;
+		global_stats.int_cs_bf_fp += lcore_conf[lcore_id].stats.int_cs_bf_fp;
+		global_stats.name_hash_mismatch += lcore_conf[lcore_id].stats.name_hash_mismatch;
+		global_stats.ring_drop += lcore_conf[lcore_id].stats.ring_drop;
+		global_stats.handoff += lcore_conf[lcore_id].stats.handoff;
+		global_stats.data_handoff_out += lcore_conf[lcore_id].stats.data_handoff_out;
+		global_stats.data_handoff_in += lcore_conf[lcore_id].stats.data_handoff_in;
+		global_stats.hot_replica_out += lcore_conf[lcore_id].stats.hot_replica_out;
+		global_stats.hot_replica_in += lcore_conf[lcore_id].stats.hot_replica_in;
+		global_stats.int_hot_hit += lcore_conf[lcore_id].stats.int_hot_hit;
+		global_stats.cs_migrated_out += lcore_conf[lcore_id].stats.cs_migrated_out;
+		global_stats.cs_migrated_in += lcore_conf[lcore_id].stats.cs_migrated_in;
+		global_stats.int_probe += lcore_conf[lcore_id].stats.int_probe;
+		global_stats.rtt_samples += lcore_conf[lcore_id].stats.rtt_samples;
+		global_stats.rtt_cycles += lcore_conf[lcore_id].stats.rtt_cycles;
+		global_stats.idle_sleeps += lcore_conf[lcore_id].stats.idle_sleeps;
+		global_stats.idle_intr_waits += lcore_conf[lcore_id].stats.idle_intr_waits;
+		global_stats.idle_intr_wakeups += lcore_conf[lcore_id].stats.idle_intr_wakeups;
+		global_stats.idle_wakeups += lcore_conf[lcore_id].stats.idle_wakeups;
+		global_stats.idle_cycles += lcore_conf[lcore_id].stats.idle_cycles;
+		global_stats.wakeup_cycles += lcore_conf[lcore_id].stats.wakeup_cycles;
+		global_stats.max_wakeup_cycles = RTE_MAX(global_stats.max_wakeup_cycles,
+				lcore_conf[lcore_id].stats.max_wakeup_cycles);
+		global_stats.tx_backlogged += lcore_conf[lcore_id].stats.tx_backlogged;
+		global_stats.tx_backlog_max = RTE_MAX(global_stats.tx_backlog_max,
+				lcore_conf[lcore_id].stats.tx_backlog_max);
+		global_stats.tx_backlog_int_drop += lcore_conf[lcore_id].stats.tx_backlog_int_drop;
+		global_stats.tx_backlog_data_drop += lcore_conf[lcore_id].stats.tx_backlog_data_drop;
+		for(b = 0; b < TX_NB_CLASSES; b++) {
+			global_stats.tx_backlog_sent[b] += lcore_conf[lcore_id].stats.tx_backlog_sent[b];
+		}
+		/* Packets handed over to workers have been counted by RX lcores */
+		if(lcore_conf[lcore_id].role != LCORE_ROLE_WORKER) {
+			global_stats.rx_pkts += lcore_conf[lcore_id].stats.rx_pkts;
+		}
+		global_stats.busy_cycles += lcore_conf[lcore_id].stats.busy_cycles;
+		for(port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+			for(b = 0; b < TX_DELAY_HIST_BUCKETS; b++) {
+				global_stats.tx_delay_hist[port_id][b] +=
+						lcore_conf[lcore_id].stats.tx_delay_hist[port_id][b];
+			}
+			global_stats.int_rate_drop[port_id] += lcore_conf[lcore_id].stats.int_rate_drop[port_id];
+			global_stats.int_quota_drop[port_id] += lcore_conf[lcore_id].stats.int_quota_drop[port_id];
+		}
 	}
 	printf("  [GLOBAL]:\n");
 	printf("    Interest recv: %u\n", global_stats.int_recv);
@@ -143,22 +478,182 @@ void print_stats() {
 	printf("    Packet drops (NIC): %u\n", global_stats.nic_pkt_drop);
 	printf("    Packet drops (SW): %u\n", global_stats.sw_pkt_drop);
 	printf("    Malformed: %u\n", global_stats.malformed);
+	printf("    CS disk hits: %u\n", global_stats.int_cs_disk_hit);
+	printf("    CS Bloom filter skips: %u\n", global_stats.int_cs_bf_skip);
+	printf("    CS Bloom filter false positives: %u\n", global_stats.int_cs_bf_fp);
+	if(app_conf.trust_name_hash) {
+		printf("    Name hash mismatches: %u\n", global_stats.name_hash_mismatch);
+	}
+	printf("    Packet drops (handoff rings): %u\n", global_stats.ring_drop);
+	if(!app_conf.pipeline && !app_conf.sw_steering) {
+		printf("    Data handed over to owner lcore: %u\n", global_stats.data_handoff_out);
+	}
+	if(app_conf.sw_steering) {
+		printf("    Packets steered to other lcores: %u\n", global_stats.handoff);
+	}
+	if(app_conf.hot_names) {
+		printf("    Hot Data replicas sent: %u\n", global_stats.hot_replica_out);
+		printf("    Interests served by hot replicas: %u\n", global_stats.int_hot_hit);
+	}
+	if(app_conf.elastic) {
+		printf("    CS entries migrated: %u\n", global_stats.cs_migrated_out);
+	}
+	if(app_conf.rtt_strategy) {
+		printf("    Interests probing next hops: %u\n", global_stats.int_probe);
+		printf("    Mean RTT (us): %.1f\n", global_stats.rtt_samples == 0 ? 0.0 :
+				icn_cycles_us(global_stats.rtt_cycles) / global_stats.rtt_samples);
+	}
+	if(app_conf.idle_policy != IDLE_POLICY_POLL) {
+		printf("    Time asleep per lcore: %.1f%%\n", icn_idle_pct(&global_stats, nb_fwd_lcores));
+		printf("    Sleeps: %u\n", global_stats.idle_sleeps);
+		printf("    RX interrupt waits: %u\n", global_stats.idle_intr_waits);
+		printf("    Wake-ups by RX interrupts: %u\n", global_stats.idle_intr_wakeups);
+		if(global_stats.idle_wakeups > 0) {
+			printf("    Wake-up latency bound (us): mean %.1f, max %.1f\n",
+					icn_cycles_us(global_stats.wakeup_cycles) / global_stats.idle_wakeups,
+					icn_cycles_us(global_stats.max_wakeup_cycles));
+		}
+	}
+	printf("    Packets held in TX backlogs: %u\n", global_stats.tx_backlogged);
+	printf("    TX backlog max depth: %u\n", global_stats.tx_backlog_max);
+	printf("    TX backlog drops (Interest/Data): %u/%u\n",
+			global_stats.tx_backlog_int_drop, global_stats.tx_backlog_data_drop);
+	printf("    TX backlog sent (Data/CS hits/Interests): %u/%u/%u\n",
+			global_stats.tx_backlog_sent[TX_CLASS_DATA],
+			global_stats.tx_backlog_sent[TX_CLASS_CS_HIT],
+			global_stats.tx_backlog_sent[TX_CLASS_INTEREST]);
+	printf("    Packets received: %" PRIu64 "\n", global_stats.rx_pkts);
+	printf("    Mpps per busy lcore: %.3f\n", icn_busy_mpps(&global_stats));
+	for(port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		if(global_stats.int_rate_drop[port_id] != 0) {
+			printf("    Interests over rate limit on port %u: %u\n", port_id,
+					global_stats.int_rate_drop[port_id]);
+		}
+		if(global_stats.int_quota_drop[port_id] != 0) {
+			printf("    Interests over PIT quota on port %u: %u\n", port_id,
+					global_stats.int_quota_drop[port_id]);
+		}
+	}
+	icn_print_tx_delay_hist(&global_stats);
 	printf("=== END ===\n");
 }
 
 
-/* Send the burst of packets on an output interface */
+/*
+ * Count a batch sent on a port in the histogram of TX batching delay, by the
+ * time its oldest packet was buffered
+ */
+static inline void
+icn_tx_delay_record(struct app_lcore_config *conf, uint8_t tx_port, uint64_t delay) {
+	uint64_t delay_us = delay * US_PER_S / rte_get_tsc_hz();
+	unsigned bucket = 0;
+
+	if (delay_us != 0) {
+		bucket = RTE_MIN(64 - __builtin_clzll(delay_us), TX_DELAY_HIST_BUCKETS - 1);
+	}
+	conf->stats.tx_delay_hist[tx_port][bucket]++;
+}
+
+
+/*
+ * Retry the transmission of the packets held in the backlog of a TX queue,
+ * Data first or scheduled by DRR, until the queue of the NIC is full again.
+ * Returns the number of packets left in the backlog
+ */
+static uint16_t
+icn_tx_backlog_send(tx_backlog_t *backlog, uint8_t tx_port, uint16_t tx_queue,
+		struct app_lcore_config *conf) {
+	struct rte_mbuf **pkts;
+	uint16_t n, ret;
+	uint8_t cls;
+
+	while (backlog->len > 0) {
+		pkts = tx_backlog_next(backlog, &cls, &n);
+		ret = rte_eth_tx_burst(tx_port, tx_queue, pkts, n);
+		tx_backlog_done(backlog, cls, n, ret);
+		conf->stats.tx_backlog_sent[cls] += ret;
+		if (ret < n) {
+			break;
+		}
+	}
+	return backlog->len;
+}
+
+
+/*
+ * Hold a packet the queue of the NIC could not take in the backlog of the TX
+ * queue, shedding an Interest if the backlog is full
+ */
+static inline void
+icn_tx_backlog_push(tx_backlog_t *backlog, struct rte_mbuf *m, uint8_t cls,
+		struct app_lcore_config *conf) {
+	struct rte_mbuf *drop;
+
+	drop = tx_backlog_push(backlog, m, cls);
+	if (likely(drop == NULL)) {
+		conf->stats.tx_backlogged++;
+		conf->stats.tx_backlog_max = RTE_MAX(conf->stats.tx_backlog_max,
+				(uint32_t) backlog->len);
+		return;
+	}
+	if (drop != m) {
+		/* The packet took the place of an Interest */
+		conf->stats.tx_backlogged++;
+		cls = TX_CLASS_INTEREST;
+	}
+	if (cls == TX_CLASS_INTEREST) {
+		conf->stats.tx_backlog_int_drop++;
+	} else {
+		conf->stats.tx_backlog_data_drop++;
+	}
+	conf->stats.nic_pkt_drop++;
+	rte_pktmbuf_free(drop);
+}
+
+
+/*
+ * Send the burst of packets on an output interface. Workers of a pipeline
+ * with a TX lcore hand the burst over to it instead, recording the output
+ * port and the class of each packet in its mbuf. Packets the queue of the NIC
+ * cannot take are held in the backlog of the queue
+ */
 static int
 send_burst(struct mbuf_table *tx_mbuf, uint32_t n,
-		uint8_t tx_port, uint8_t tx_queue, struct stats *stats) {
+		uint8_t tx_port, uint8_t tx_queue, struct app_lcore_config *conf) {
 	struct rte_mbuf **m_table;
-	uint32_t ret;
+	tx_backlog_t *backlog;
+	uint32_t ret, i;
 	m_table = tx_mbuf->m_table;
-	ret = rte_eth_tx_burst(tx_port, (uint16_t) tx_queue, m_table, (uint16_t) n);
+	icn_tx_delay_record(conf, tx_port, rte_rdtsc() - tx_mbuf->first_tsc);
+	if (conf->tx_ring != NULL) {
+		for (i = 0; i < n; i++) {
+			m_table[i]->port = tx_port;
+			m_table[i]->udata64 = tx_mbuf->cls[i];
+		}
+		ret = rte_ring_sp_enqueue_burst(conf->tx_ring, (void **) m_table, n);
+		if (unlikely(ret < n)) {
+			conf->stats.ring_drop += (n - ret);
+			do {
+				rte_pktmbuf_free(m_table[ret]);
+			} while (++ret < n);
+		}
+		return 0;
+	}
+	/* Packets waiting in the backlog go first */
+	backlog = conf->tx_backlog[tx_port];
+	ret = 0;
+	if (likely(backlog == NULL || backlog->len == 0 ||
+			icn_tx_backlog_send(backlog, tx_port, tx_queue, conf) == 0)) {
+		ret = rte_eth_tx_burst(tx_port, (uint16_t) tx_queue, m_table, (uint16_t) n);
+	}
 	RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Sent burst of %u packets to (port=%u, queue=%u)\n",
-			rte_lcore_id(), n, tx_port, tx_queue);
-	if (unlikely(ret < n)) {
-		stats->nic_pkt_drop += (n - ret);
+			rte_lcore_id(), ret, tx_port, tx_queue);
+	if (unlikely(ret < n && backlog != NULL)) {
+		do {
+			icn_tx_backlog_push(backlog, m_table[ret], tx_mbuf->cls[ret], conf);
+		} while (++ret < n);
+	} else if (unlikely(ret < n)) {
+		conf->stats.nic_pkt_drop += (n - ret);
 		do {
 			/* Here we free the buffer of the packets that have not been sent
 			 * due to queue overflow in the NIC
@@ -172,23 +667,28 @@ send_burst(struct mbuf_table *tx_mbuf, uint32_t n,
 
 /*
  * Enqueue a packet for TX and if the number of packets currently enqueued on
- * the given destination port is equal to a MAX_PKT_BURST constant, then it
- * sends the entire burst, otherwise it just enqueues the packet
+ * the given destination port reaches its burst size, then it sends the entire
+ * burst, otherwise it just enqueues the packet
  */
 static int
-send_single_packet(struct rte_mbuf *m, struct mbuf_table *tx_mbuf,
-		uint8_t tx_port, uint8_t tx_queue, struct stats *stats)
+send_single_packet(struct rte_mbuf *m, uint8_t cls, struct mbuf_table *tx_mbuf,
+		uint8_t tx_port, uint8_t tx_queue, struct app_lcore_config *conf)
 {
 	uint16_t len;
 	len = tx_mbuf->len;
+	if (len == 0) {
+		tx_mbuf->first_tsc = rte_rdtsc();
+	}
 	tx_mbuf->m_table[len] = m;
+	tx_mbuf->cls[len] = cls;
+	tx_mbuf->enqueued++;
 	len++;
 
 	RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Enqueued pkt %u for tx on port %u\n",
 			rte_lcore_id(), len, tx_port);
 	/* Enough pkts to be sent, send burst */
-	if (unlikely(len == MAX_PKT_BURST)) {
-		send_burst(tx_mbuf, MAX_PKT_BURST, tx_port, tx_queue, stats);
+	if (unlikely(len >= tx_mbuf->burst)) {
+		send_burst(tx_mbuf, len, tx_port, tx_queue, conf);
 		len = 0;
 	}
 	tx_mbuf->len = len;
@@ -196,247 +696,1679 @@ send_single_packet(struct rte_mbuf *m, struct mbuf_table *tx_mbuf,
 }
 
 
-static void
-icn_fwd(struct rte_mbuf *m, uint8_t rx_port_id,  struct app_lcore_config *conf,
-		struct mbuf_table tx_mbufs[]) {
+/* Convert a duration in microseconds to TSC cycles */
+static inline uint64_t
+icn_us_to_tsc(uint64_t us) {
+	return (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * us;
+}
 
-	/* Pointers to headers of the processed packet */
-	struct ether_hdr 	*eth_hdr;
-	struct ipv4_hdr  	*ipv4_hdr;
-	uint8_t          	*pkt;           /*points to the beginning of the icn packet*/
-	struct icn_packet	icn_pkt;
 
-	int8_t ret;
-	uint32_t crc, portmask;
-	struct rte_mbuf *data; // pointer to the data packet in cache (if hit)
+/*
+ * Initialize the TX buffers of an lcore. Without adaptive batching, packets
+ * are sent by MAX_PKT_BURST or after BURST_TX_DRAIN_US
+ */
+static void
+icn_tx_init(struct mbuf_table tx_mbufs[]) {
+	uint64_t tsc = rte_rdtsc();
+	uint8_t port_id;
 
-	/* ID of destination port, which will be resolved after FIB lookup */
-	uint8_t tx_port_id, tx_queue_id;
+	for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		memset(&tx_mbufs[port_id], 0, offsetof(struct mbuf_table, m_table));
+		tx_mbufs[port_id].burst = MAX_PKT_BURST;
+		tx_mbufs[port_id].slo_tsc = icn_us_to_tsc(app_conf.tx_slo_us != 0 ?
+				app_conf.tx_slo_us : BURST_TX_DRAIN_US);
+		tx_mbufs[port_id].drain_tsc = tx_mbufs[port_id].slo_tsc;
+		tx_mbufs[port_id].rate_tsc = tsc;
+		if (app_conf.tx_slo_us != 0) {
+			tx_mbufs[port_id].period_tsc = icn_us_to_tsc(TX_RATE_PERIOD_US);
+		}
+	}
+}
 
-	/* Cast the head of the packet buffer to an Ethernet header */
-	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
 
-	/*
-	 * If the received packet is not an IPv4 one (e.g. ARP and ICMP), drop it
-	 * without processing to save resources. In performance testing scenarios
-	 * packet routing will be done with VLANs statically configured in an
-	 * Ethernet switch
-	 *
-	 */
-	if(unlikely(eth_hdr->ether_type != ETHER_TYPE_IPv4_BE)) {
-		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received non-IPv4 packet "
-				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
-		rte_pktmbuf_free(m);
-		conf->stats.malformed++;
-		return;
-	}
+/*
+ * Adapt the batching of a TX port to the rate at which packets are buffered
+ * for it. Packets expected to be too few within the latency SLO to make a
+ * batch are sent at each poll. Otherwise the batch size follows the rate and
+ * packets wait for at most twice the expected time to fill it, within the SLO
+ */
+static void
+icn_tx_adapt(struct mbuf_table *tx_mbuf, uint64_t cur_tsc) {
+	uint64_t expected;
 
-	ipv4_hdr = (struct ipv4_hdr *)RTE_PTR_ADD(eth_hdr, sizeof(struct ether_hdr));
+	/* Rate of the last period, scaled to TX_RATE_PERIOD_US, weighted 1/4 */
+	tx_mbuf->rate = (uint32_t) ((3 * (uint64_t) tx_mbuf->rate +
+			((uint64_t) tx_mbuf->enqueued << 4) * tx_mbuf->period_tsc /
+			(cur_tsc - tx_mbuf->rate_tsc)) >> 2);
+	tx_mbuf->enqueued = 0;
+	tx_mbuf->rate_tsc = cur_tsc;
 
-	if(unlikely(ipv4_hdr->next_proto_id != IPPROTO_ICN)) {
-		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received IPv4 packet w/o ICN "
-				"payload from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
-		rte_pktmbuf_free(m);
-		conf->stats.malformed++;
+	/* Packets expected within the SLO */
+	expected = ((uint64_t) tx_mbuf->rate * tx_mbuf->slo_tsc / tx_mbuf->period_tsc) >> 4;
+	if (expected < TX_BURST_MIN) {
+		tx_mbuf->burst = MAX_PKT_BURST;
+		tx_mbuf->drain_tsc = 0;
 		return;
 	}
-	
-	pkt = (uint8_t*) RTE_PTR_ADD(ipv4_hdr, sizeof(struct ipv4_hdr));
-	parse_packet(pkt, &icn_pkt);
+	tx_mbuf->burst = (uint16_t) RTE_MAX(RTE_MIN(expected, (uint64_t) TX_BURST_MAX),
+			(uint64_t) MAX_PKT_BURST);
+	tx_mbuf->drain_tsc = RTE_MIN(tx_mbuf->slo_tsc,
+			2 * ((uint64_t) tx_mbuf->burst << 4) * tx_mbuf->period_tsc / tx_mbuf->rate);
+}
 
-	/*
-	 * Calculate CRC32 hash 
-	 */
-	crc = rte_hash_crc(icn_pkt.name, icn_pkt.name_len, MASTER_CRC_SEED);
-	
-	icn_pkt.crc[icn_pkt.component_nr] = crc;
 
-	if (icn_pkt.hdr->type == TYPE_INTEREST_BE) {
-		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received Interest for '%.*s' from port %u. "
-				"Processing\n", rte_lcore_id(), icn_pkt.name_len, icn_pkt.name, rx_port_id);
-		conf->stats.int_recv++;
-		/* Lookup in CS */
-		data = cs_lookup_with_hash(conf->cs, icn_pkt.name, icn_pkt.name_len, crc);
-		if(data != NULL) {
- 			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS hit for '%.*s'\n",
- 					rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
-			/* CS hit: Reply and delete interest */
-			conf->stats.int_cs_hit++;
-			/* Increase reference counter by 1 otherwise sending the Data
-			 * packet will also delete it
-			 */
-			rte_pktmbuf_refcnt_update(data, 1);
-			/* Only edit src and dst MAC address and assume that all other
-			 * fields have been verified at CS insertion
-			 */
-			eth_hdr = rte_pktmbuf_mtod(data, struct ether_hdr *);
-			ether_addr_copy(&conf->port_addr[rx_port_id].local_addr, &eth_hdr->s_addr);
-			ether_addr_copy(&conf->port_addr[rx_port_id].remote_addr, &eth_hdr->d_addr);
+/*
+ * Send the packets buffered for each port for longer than its drain period,
+ * after retrying those held in its backlog, and adapt the batching of ports
+ * to their load with adaptive batching. Called
+ * at each iteration of the loops of lcores transmitting packets
+ */
+static inline void
+icn_tx_drain(struct app_lcore_config *conf, struct mbuf_table tx_mbufs[],
+		uint64_t cur_tsc) {
+	struct mbuf_table *tx_mbuf;
+	uint8_t port_id;
 
-			send_single_packet(data, &(tx_mbufs[rx_port_id]), rx_port_id,
-					conf->tx_queue_id[rx_port_id], &(conf->stats));
-			conf->stats.data_sent++;
-			/* Drop received interest*/
-			rte_pktmbuf_free(m);
-			return;
-		} else { /* CS miss */
-			/* check PIT */
- 			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS miss for '%.*s'\n",
- 					rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
- 			ret = pit_lookup_and_update_with_hash(conf->pit, icn_pkt.name, icn_pkt.name_len, rx_port_id, NULL, crc);
-			if(unlikely(ret != 1)) {	/* PIT aggregation or PIT bucket overflow */
-				/*
-				 * Reach this in case the entry was already in the PIT and
-				 * got aggregated or could not insert it due to lack of space
-				 * In any case, I don't forward the Interest. However in the
-				 * case of no space I print a debug message.
-				 *
-				 */
-				if(unlikely(ret == -ENOSPC)) {	/* PIT bucket overflow */
-					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Could not insert "
-							"Interest in PIT because full or bucket overflow. "
-							"Dropping\n", rte_lcore_id());
-					conf->stats.sw_pkt_drop++;
-				} else {	/* PIT aggregation */
-					conf->stats.int_pit_hit++;
- 					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: PIT aggregation for '%.*s'\n",
- 							rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
-				}
-				rte_pktmbuf_free(m);
-			} else {	/* CS and PIT miss */
-				/* query FIB and forward */
-				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: PIT miss for '%.*s'\n",
-											rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
-				
-				ret = fib_lookup(conf->fib, &icn_pkt);
-				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: FIB forwarding for '%.*s' to face %d\n",
-						rte_lcore_id(), icn_pkt.name_len, icn_pkt.name, ret);
-				if(unlikely(ret < 0)) {
-					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: No FIB entry for name "
-							"'(%.*s)'. Dropping packet\n",
-							rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
-					conf->stats.int_no_route++;
-					pit_lookup_and_remove_with_hash(conf->pit, icn_pkt.name, icn_pkt.name_len, crc);
-					rte_pktmbuf_free(m);
-					return;
-				} else if(unlikely(ret == rx_port_id)) {
-					/* Packet come from direction is supposed to go to: loop */
-					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: FIB entry for name "
-							"'(%.*s)' points to RX port. Dropping packet\n",
-							rte_lcore_id(), icn_pkt.name_len, icn_pkt.name);
-					conf->stats.int_fib_loop += 1;
-					pit_lookup_and_remove_with_hash(conf->pit, icn_pkt.name, icn_pkt.name_len, crc);
-					rte_pktmbuf_free(m);
-					return;
-				}
-				conf->stats.int_fib_hit++;
-				ether_addr_copy(&conf->port_addr[ret].local_addr, &eth_hdr->s_addr);
-				ether_addr_copy(&conf->port_addr[ret].remote_addr, &eth_hdr->d_addr);
-				send_single_packet(m, &(tx_mbufs[ret]), ret,
-						conf->tx_queue_id[ret], &(conf->stats));
-			}
+	for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		tx_mbuf = &tx_mbufs[port_id];
+		if (unlikely(tx_mbuf->period_tsc != 0 &&
+				cur_tsc - tx_mbuf->rate_tsc > tx_mbuf->period_tsc)) {
+			icn_tx_adapt(tx_mbuf, cur_tsc);
 		}
-	} else if (icn_pkt.hdr->type == TYPE_DATA_BE) {
-		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received Data for '%.*s' from port %u.\n",
-				rte_lcore_id(), icn_pkt.name_len, icn_pkt.name, rx_port_id);
-		/* First insert it in CS. Note: for performance reasons, the CS
-		 * implementation assumes that the content is not the CS when an insert
-		 * operation is attempted and it therefore does not check if it actually
-		 * is not in the CS. If there is already a copy in the cache, a
-		 * duplicated will be stored
-		 */
-		conf->stats.data_recv += 1;
-		ret = cs_insert_with_hash(conf->cs, icn_pkt.name, icn_pkt.name_len, m, crc);
-		portmask = pit_lookup_and_remove_with_hash(conf->pit, icn_pkt.name, icn_pkt.name_len,crc);
-		if(unlikely(portmask == 0)) {
-			/* Probably it expired in the PIT. Quit without freeing the mbuf
-			 * because the packet is in the CS */
-			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: No PIT entry for Data '%.*s' from port %u. Dropping\n",
-							rte_lcore_id(), icn_pkt.name_len, icn_pkt.name, rx_port_id);
-			conf->stats.data_pit_miss++;
-			return;
+		if (unlikely(conf->tx_backlog[port_id] != NULL &&
+				conf->tx_backlog[port_id]->len > 0)) {
+			icn_tx_backlog_send(conf->tx_backlog[port_id], port_id,
+					conf->tx_queue_id[port_id], conf);
 		}
-		/*
-		 * If the packet is also sent back (which is the normal case when
-		 * there is a valid PIT entry) increase its reference count for each
-		 * port in the portmask otherwise the mbuf is freed and the CS will
-		 * have a dangling pointer
-		 *
-		 * Iterate over the portmask to find ports to which Data is to be sent
-		 */
-		for(tx_port_id = 0; tx_port_id < APP_MAX_ETH_PORTS; tx_port_id++) {
-			if((portmask & 1) == 1) {
-				rte_pktmbuf_refcnt_update(m, 1);
-
-				ether_addr_copy(&conf->port_addr[tx_port_id].local_addr, &eth_hdr->s_addr);
-				ether_addr_copy(&conf->port_addr[tx_port_id].remote_addr, &eth_hdr->d_addr);
-				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Forwarding Data for '%.*s' to port %u\n",
-											rte_lcore_id(), icn_pkt.name_len, icn_pkt.name, tx_port_id);
-				send_single_packet(m, &(tx_mbufs[tx_port_id]), tx_port_id,
-						conf->tx_queue_id[tx_port_id], &(conf->stats));
-				conf->stats.data_sent++;
-			}
-			portmask >>= 1;
+		if (tx_mbuf->len == 0 || cur_tsc - tx_mbuf->first_tsc < tx_mbuf->drain_tsc) {
+			continue;
 		}
-		return;
-	} else {
-		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received malformed ICN packet "
-				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
-		conf->stats.malformed++;
-		rte_pktmbuf_free(m);
-		return;
+		send_burst(tx_mbuf, tx_mbuf->len, port_id, conf->tx_queue_id[port_id], conf);
+		tx_mbuf->len = 0;
 	}
-	/* This block of code should never be reached*/
-	return;
 }
 
 
-/* Main data plane processing loop */
-int pkt_fwd_loop(__attribute__((unused)) void *arg) {
-	struct app_lcore_config *conf;
-	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
-	struct rte_mbuf *m;
-	unsigned lcore_id, socket_id;
-	uint64_t prev_drain_tsc, prev_pit_purge_tsc, cur_tsc;
-	int i, j, nb_rx;
-	uint8_t port_id, queue_id;
-
-	/* Max number of cycle allowed between subsequent packet transmission
-	 * Since packets are batched for transmission, if load is low a packet
-	 * may wait for too long to be transmitted. This variable is the maximum
-	 * delay a packet can wait in the batching queue. If a batch is not
-	 * complete within this period, the packets are sent out anyway.
-	 */
-	const uint64_t drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
-			US_PER_S * (uint64_t) BURST_TX_DRAIN_US;
-	const uint64_t pit_purge_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
-			US_PER_S * (uint64_t) PIT_PURGE_US;
+/*
+ * Build a packet to transmit a (possibly shared) Data packet to a port.
+ *
+ * The returned packet is a small header mbuf holding the Ethernet header of
+ * the given port, chained to an indirect mbuf attached to the original packet.
+ * The original packet is therefore never written, which makes it safe to
+ * transmit it to several faces at once while it is also stored in the CS.
+ *
+ * Returns NULL if no header or indirect mbuf could be allocated.
+ */
+static inline struct rte_mbuf *
+icn_out_pkt(struct rte_mbuf *m, uint8_t tx_port_id,
+		struct app_lcore_config *conf) {
+	struct rte_mbuf *hdr;
+	struct rte_mbuf *payload;
+	struct ether_hdr *eth_hdr;
 
-	/* Used to pass pointers to packets to send. Init it */
-	struct mbuf_table tx_mbufs[APP_MAX_ETH_PORTS];
-	for(port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
-		tx_mbufs[port_id].len = 0;
+	hdr = rte_pktmbuf_alloc(conf->hdr_pool);
+	if (unlikely(hdr == NULL)) {
+		return NULL;
+	}
+	/* This also increases the reference counter of the original packet */
+	payload = rte_pktmbuf_clone(m, conf->clone_pool);
+	if (unlikely(payload == NULL)) {
+		rte_pktmbuf_free(hdr);
+		return NULL;
 	}
+	/* The Ethernet header of the original packet is not sent */
+	rte_pktmbuf_adj(payload, (uint16_t) sizeof(struct ether_hdr));
 
-	/*
-	 * Reset TSC counters before entering the main loop
-	 */
-	prev_drain_tsc = 0;
-	prev_pit_purge_tsc = 0;
-	cur_tsc = 0;
+	eth_hdr = (struct ether_hdr *) rte_pktmbuf_prepend(hdr,
+			(uint16_t) sizeof(struct ether_hdr));
+	ether_addr_copy(&conf->port_addr[tx_port_id].local_addr, &eth_hdr->s_addr);
+	ether_addr_copy(&conf->port_addr[tx_port_id].remote_addr, &eth_hdr->d_addr);
+	eth_hdr->ether_type = ETHER_TYPE_IPv4_BE;
 
-	/* get ID of the lcore on which it is running */
-	lcore_id = rte_lcore_id();
-	socket_id = rte_socket_id();
+	/* Chain the payload to the header */
+	hdr->next = payload;
+	hdr->nb_segs = (uint8_t) (payload->nb_segs + 1);
+	hdr->pkt_len = hdr->data_len + payload->pkt_len;
+	return hdr;
+}
 
-	/* Get core configuration */
-	conf = &lcore_conf[lcore_id];
+
+/*
+ * Look up a name in the CS of the lcore, either its own or the one shared by
+ * the lcores of its socket. A hit returned by the shared CS holds a reference
+ * to the mbuf, which the caller releases with icn_cs_release
+ */
+static inline struct rte_mbuf *
+icn_cs_lookup(struct app_lcore_config *conf, struct icn_packet *icn_pkt,
+		uint32_t crc) {
+	struct rte_mbuf *data;
+	int8_t miss;
+
+	if (conf->cs_shared != NULL) {
+		return cs_shared_lookup_with_hash(conf->cs_shared, icn_pkt->name,
+				icn_pkt->name_len, crc);
+	}
+	/* Names certainly not in the CS go straight to the PIT */
+	if (!cs_bf_may_contain(conf->cs, crc)) {
+		conf->stats.int_cs_bf_skip++;
+		return NULL;
+	}
+	data = cs_lookup_with_hash(conf->cs, icn_pkt->name, icn_pkt->name_len, crc, &miss);
+	/* Entries found expired or purged were in the CS when the filter was checked */
+	if (data == NULL && miss == -ENOENT && conf->cs->bf != NULL) {
+		conf->stats.int_cs_bf_fp++;
+	}
+	return data;
+}
+
+
+/* Release a packet returned by icn_cs_lookup */
+static inline void
+icn_cs_release(struct app_lcore_config *conf, struct rte_mbuf *m) {
+	if (conf->cs_shared != NULL) {
+		rte_pktmbuf_free(m);
+	}
+}
+
+
+/*
+ * Insert a Data packet in the CS of the lcore. Its freshness period is the
+ * one carried by the packet or, if none, the default one of its prefix
+ */
+static inline int8_t
+icn_cs_insert(struct app_lcore_config *conf, struct rte_mbuf *m,
+		struct icn_packet *icn_pkt, uint32_t crc) {
+	uint32_t freshness_ms;
+
+	freshness_ms = icn_pkt->freshness;
+	if (freshness_ms == 0) {
+		freshness_ms = cs_freshness_lookup(&conf->freshness, icn_pkt->name,
+				icn_pkt->name_len);
+	}
+	if (conf->cs_shared != NULL) {
+		return cs_shared_insert_with_hash(conf->cs_shared, icn_pkt->name,
+				icn_pkt->name_len, m, crc, freshness_ms);
+	}
+	return cs_insert_with_hash(conf->cs, icn_pkt->name, icn_pkt->name_len, m,
+			crc, freshness_ms);
+}
+
+
+/*
+ * Return the descriptor of a received packet, stored in the private area of
+ * its mbuf once the packet is parsed and hashed
+ */
+static inline struct icn_desc *
+icn_mbuf_desc(struct rte_mbuf *m) {
+	return (struct icn_desc *) RTE_PTR_ADD(m, sizeof(struct rte_mbuf));
+}
+
+
+/*
+ * Return the index of the worker owning a name in pipeline mode or with
+ * software steering. The high bits of its hash are used, since the low ones
+ * select the buckets of the tables
+ */
+static inline uint8_t
+icn_worker_of(uint32_t crc) {
+	return (uint8_t) (((uint64_t) crc * app_conf.nb_workers) >> 32);
+}
+
+
+/*
+ * Parse the ICN header of a packet to forward. Its name must also fit in the
+ * entries of the FIB, PIT and CS, which copy it without checking.
+ *
+ * Return 0 on success, 1 if the packet is malformed
+ */
+static inline uint8_t
+icn_parse_packet(uint8_t *pkt, uint16_t len, struct icn_packet *icn_pkt) {
+	return parse_packet(pkt, len, icn_pkt) | (icn_pkt->name_len > MAX_NAME_LEN);
+}
+
+
+/*
+ * Parse the ICN header of a packet whose Ethernet and IPv4 headers have
+ * already been validated, i.e. a Data read from the CS disk tier.
+ *
+ * Return 0 on success, a negative value if the packet is malformed
+ */
+static inline int
+icn_reparse(struct rte_mbuf *m, struct icn_packet *icn_pkt, uint32_t crc) {
+	uint8_t *pkt;
+	pkt = rte_pktmbuf_mtod_offset(m, uint8_t *,
+			sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr));
+	if (unlikely(icn_parse_packet(pkt, rte_pktmbuf_data_len(m) - sizeof(struct ether_hdr) -
+			sizeof(struct ipv4_hdr), icn_pkt) != 0)) {
+		return -EINVAL;
+	}
+	if (app_conf.tokenize_names) {
+		parse_name_components(icn_pkt);
+	}
+	if (likely(icn_pkt->component_nr < MAX_NAME_COMPONENTS)) {
+		icn_pkt->crc[icn_pkt->component_nr] = crc;
+	}
+	/* The packet may be handed over to another lcore */
+	icn_desc_store(icn_pkt, sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr), crc,
+			icn_mbuf_desc(m));
+	return 0;
+}
+
+
+/*
+ * Select the next hop of an Interest with the RTT strategy, among those of the
+ * longest prefix of its name other than the face it came from, and record it
+ * with the send time in the PIT entry of the Interest, so that its Data is
+ * measured. The entry is looked up if not given, e.g. after a CS disk read.
+ *
+ * Return the face selected, the RX port if it is the only next hop, or
+ * -ENOENT if there is no route
+ */
+static int8_t
+icn_strategy_fwd(uint8_t rx_port_id, struct app_lcore_config *conf,
+		struct icn_packet *icn_pkt, uint32_t crc, uint8_t hashed,
+		struct pit_entry *entry) {
+	struct fib_nexthop nexthops[FIB_MAX_NEXTHOPS];
+	int8_t n;
+	uint8_t i, nb, sel, probe;
+
+	n = fib_lookup_nexthops(conf->fib, icn_pkt, hashed, nexthops);
+	if (unlikely(n < 0)) {
+		return n;
+	}
+	for (i = 0, nb = 0; i < n; i++) {
+		if (likely(nexthops[i].face != rx_port_id)) {
+			nexthops[nb++] = nexthops[i];
+		}
+	}
+	if (unlikely(nb == 0)) {
+		return rx_port_id;
+	}
+	sel = strategy_select(conf->strategy, nexthops, nb, &probe);
+	conf->stats.int_probe += probe;
+	if (unlikely(nexthops[sel].index >= conf->strategy->nb_nexthops)) {
+		return nexthops[sel].face;
+	}
+	strategy_sent(conf->strategy, nexthops[sel].index);
+	if (likely(entry != NULL)) {
+		pit_set_upstream(conf->pit, entry, nexthops[sel].face,
+				(uint16_t) nexthops[sel].index);
+	} else {
+		pit_set_upstream_with_hash(conf->pit, icn_pkt->name, icn_pkt->name_len, crc,
+				nexthops[sel].face, (uint16_t) nexthops[sel].index);
+	}
+	return nexthops[sel].face;
+}
+
+
+/*
+ * Forward an Interest which missed both CS and PIT according to the FIB. If
+ * hashed is set, the hashes of the prefixes of its name have already been
+ * computed by name_hash_burst. entry is the PIT entry just inserted for the
+ * Interest, if known
+ */
+static void
+icn_fwd_interest_fib(struct rte_mbuf *m, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[],
+		struct icn_packet *icn_pkt, uint32_t crc, uint8_t hashed,
+		struct pit_entry *entry) {
+	struct ether_hdr *eth_hdr;
+	int8_t ret;
+
+	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+
+	if (conf->strategy != NULL) {
+		ret = icn_strategy_fwd(rx_port_id, conf, icn_pkt, crc, hashed, entry);
+	} else {
+		ret = hashed ? fib_lookup_with_hashes(conf->fib, icn_pkt) :
+				fib_lookup(conf->fib, icn_pkt);
+	}
+	RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: FIB forwarding for '%.*s' to face %d\n",
+			rte_lcore_id(), icn_pkt->name_len, icn_pkt->name, ret);
+	if(unlikely(ret < 0)) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: No FIB entry for name "
+				"'(%.*s)'. Dropping packet\n",
+				rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+		conf->stats.int_no_route++;
+		pit_lookup_and_remove_with_hash(conf->pit, icn_pkt->name, icn_pkt->name_len, crc);
+		rte_pktmbuf_free(m);
+		return;
+	} else if(unlikely(ret == rx_port_id)) {
+		/* Packet come from direction is supposed to go to: loop */
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: FIB entry for name "
+				"'(%.*s)' points to RX port. Dropping packet\n",
+				rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+		conf->stats.int_fib_loop += 1;
+		pit_lookup_and_remove_with_hash(conf->pit, icn_pkt->name, icn_pkt->name_len, crc);
+		rte_pktmbuf_free(m);
+		return;
+	}
+	conf->stats.int_fib_hit++;
+	ether_addr_copy(&conf->port_addr[ret].local_addr, &eth_hdr->s_addr);
+	ether_addr_copy(&conf->port_addr[ret].remote_addr, &eth_hdr->d_addr);
+	send_single_packet(m, TX_CLASS_INTEREST, &(tx_mbufs[ret]), ret,
+			conf->tx_queue_id[ret], conf);
+}
+
+
+/*
+ * Hand a Data without PIT entry over to the lcore to which RSS steers its
+ * name, i.e. the one which received its Interests, if it is not this one. This
+ * happens if the Data is not sent from the address carrying the name hash,
+ * or, with elastic scaling, if the name moved from another lcore which still
+ * holds its PIT entries. The CS of this lcore may hold another reference to
+ * the packet.
+ *
+ * Return 0 if the packet has been handed over (or dropped because the ring
+ * is full), a negative value if it must be processed by this lcore
+ */
+static inline int
+icn_data_handoff(struct rte_mbuf *m, struct app_lcore_config *conf,
+		uint32_t crc, uint8_t cached) {
+	struct ipv4_hdr *ipv4_hdr;
+	struct rte_ring *ring;
+	unsigned owner;
+
+	/*
+	 * Other modes always steer names to their owner. Packets already handed
+	 * over are not handed over again, so that they cannot loop
+	 */
+	if (app_conf.pipeline || app_conf.sw_steering || conf->in_handoff) {
+		return -EINVAL;
+	}
+	/* RSS only hashes source addresses, so these reached the owner */
+	ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+			sizeof(struct ether_hdr));
+	owner = rte_lcore_id();
+	if (unlikely(rte_be_to_cpu_32(ipv4_hdr->src_addr) != crc)) {
+		owner = steering_lcore(crc);
+	}
+	/* After a RETA update, the previous owner holds the PIT entries for a while */
+	if (owner == rte_lcore_id()) {
+		owner = steering_prev_lcore(crc);
+	}
+	if (owner == rte_lcore_id() || owner >= APP_MAX_LCORES) {
+		return -EINVAL;
+	}
+	ring = conf->out_ring[lcore_conf[owner].worker_id];
+	if (unlikely(ring == NULL)) {
+		return -EINVAL;
+	}
+	if (cached) {
+		rte_pktmbuf_refcnt_update(m, 1);
+	}
+	if (unlikely(rte_ring_sp_enqueue(ring, m) != 0)) {
+		conf->stats.ring_drop++;
+		rte_pktmbuf_free(m);
+		return 0;
+	}
+	RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Handing Data without PIT entry over to lcore %u\n",
+			rte_lcore_id(), owner);
+	conf->stats.data_handoff_out++;
+	return 0;
+}
+
+
+/*
+ * Replicate a hot Data of the CS of this lcore in the CS of all other lcores,
+ * over the rings of software steering. Replicas share the same read-only mbuf,
+ * each holding a reference to it. Only the hash of the name is written in its
+ * descriptor, which is not stored for entries reloaded from a CS snapshot
+ */
+static void
+icn_hot_replicate(struct rte_mbuf *data, struct app_lcore_config *conf,
+		uint32_t crc) {
+	uint8_t w;
+
+	icn_mbuf_desc(data)->crc = crc;
+	for (w = 0; w < app_conf.nb_workers; w++) {
+		if (w == conf->worker_id) {
+			continue;
+		}
+		rte_pktmbuf_refcnt_update(data, 1);
+		if (unlikely(rte_ring_sp_enqueue(conf->out_ring[w], data) != 0)) {
+			conf->stats.ring_drop++;
+			rte_pktmbuf_free(data);
+			continue;
+		}
+		conf->stats.hot_replica_out++;
+	}
+}
+
+
+/*
+ * Account for a CS hit with hot names enabled: the owner of the name counts
+ * it and replicates the Data if the name is hot, other lcores served it from
+ * a replica
+ */
+static inline void
+icn_hot_hit(struct rte_mbuf *data, struct app_lcore_config *conf, uint32_t crc) {
+	if (icn_worker_of(crc) != conf->worker_id) {
+		conf->stats.int_hot_hit++;
+		return;
+	}
+	if (unlikely(hot_names_count(conf->hot, crc, rte_rdtsc()))) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Replicating hot Data\n", rte_lcore_id());
+		icn_hot_replicate(data, conf, crc);
+	}
+}
+
+
+/*
+ * Hand an Interest for a hot name which missed the CS of this lcore over to
+ * the owner of the name, where its PIT entry must be, e.g. because the
+ * replica has been evicted.
+ *
+ * Return 0 if the Interest has been handed over (or dropped because the ring
+ * is full), a negative value if this lcore owns the name
+ */
+static inline int
+icn_hot_miss(struct rte_mbuf *m, struct app_lcore_config *conf, uint32_t crc) {
+	uint8_t w = icn_worker_of(crc);
+
+	if (likely(w == conf->worker_id)) {
+		return -EINVAL;
+	}
+	/* Its face has been charged for it here */
+	icn_mbuf_desc(m)->flags |= ICN_DESC_ADMITTED;
+	if (unlikely(rte_ring_sp_enqueue(conf->out_ring[w], m) != 0)) {
+		conf->stats.ring_drop++;
+		rte_pktmbuf_free(m);
+		return 0;
+	}
+	conf->stats.handoff++;
+	return 0;
+}
+
+
+/* Store a Data packet in the CS and send it to all faces of its PIT entry */
+static void
+icn_fwd_data(struct rte_mbuf *m, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[],
+		struct icn_packet *icn_pkt, uint32_t crc) {
+	struct rte_mbuf *out;  // header mbuf of a packet to transmit
+	struct pit_upstream upstream;
+	uint64_t rtt;
+	uint32_t portmask;
+	uint8_t tx_port_id;
+	int8_t ret;
+
+	/* First insert it in CS. Note: for performance reasons, the CS
+	 * implementation assumes that the content is not the CS when an insert
+	 * operation is attempted and it therefore does not check if it actually
+	 * is not in the CS. If there is already a copy in the cache, a
+	 * duplicated will be stored
+	 */
+	ret = icn_cs_insert(conf, m, icn_pkt, crc);
+	if (conf->strategy != NULL) {
+		portmask = pit_lookup_and_remove_upstream_with_hash(conf->pit, icn_pkt->name,
+				icn_pkt->name_len, crc, &upstream);
+		/* Only Data from the face the Interest was forwarded to are measured */
+		if (portmask != 0 && upstream.face == rx_port_id) {
+			rtt = rte_rdtsc() - upstream.send_time;
+			strategy_satisfied(conf->strategy, upstream.nexthop, rtt);
+			conf->stats.rtt_samples++;
+			conf->stats.rtt_cycles += rtt;
+		}
+	} else {
+		portmask = pit_lookup_and_remove_with_hash(conf->pit, icn_pkt->name, icn_pkt->name_len, crc);
+	}
+	if(unlikely(portmask == 0)) {
+		/* The PIT entry may be on another lcore */
+		if(icn_data_handoff(m, conf, crc, ret >= 0) == 0) {
+			return;
+		}
+		/* Probably it expired in the PIT. Quit without freeing the mbuf
+		 * if the packet is in the CS */
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: No PIT entry for Data '%.*s' from port %u. Dropping\n",
+						rte_lcore_id(), icn_pkt->name_len, icn_pkt->name, rx_port_id);
+		conf->stats.data_pit_miss++;
+		if(unlikely(ret < 0)) {
+			rte_pktmbuf_free(m);
+		}
+		return;
+	}
+	/*
+	 * Iterate over the portmask to find ports to which Data is to be sent
+	 *
+	 * Each port gets its own header mbuf chained to an indirect mbuf
+	 * attached to the received packet, which increases its reference
+	 * counter. The received packet is never written, so that all
+	 * transmissions and the CS share the same read-only copy.
+	 */
+	for(tx_port_id = 0; tx_port_id < APP_MAX_ETH_PORTS; tx_port_id++) {
+		if((portmask & 1) == 1) {
+			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Forwarding Data for '%.*s' to port %u\n",
+										rte_lcore_id(), icn_pkt->name_len, icn_pkt->name, tx_port_id);
+			out = icn_out_pkt(m, tx_port_id, conf);
+			if (unlikely(out == NULL)) {
+				conf->stats.sw_pkt_drop++;
+			} else {
+				send_single_packet(out, TX_CLASS_DATA, &(tx_mbufs[tx_port_id]), tx_port_id,
+						conf->tx_queue_id[tx_port_id], conf);
+				conf->stats.data_sent++;
+			}
+		}
+		portmask >>= 1;
+	}
+	/*
+	 * If the packet could not be stored in the CS, release the reference
+	 * held since reception: the packet is freed once transmitted
+	 */
+	if(unlikely(ret < 0)) {
+		rte_pktmbuf_free(m);
+	}
+}
+
+
+/*
+ * Post the read of a Data packet from the CS disk tier, parking the Interest
+ * which requested it until the read completes.
+ *
+ * Return 0 if the read has been posted, a negative value if the Interest must
+ * be forwarded according to the FIB
+ */
+static inline int
+icn_cs_disk_fetch(struct rte_mbuf *m, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct icn_packet *icn_pkt, uint32_t crc) {
+	struct rte_mbuf *buf;
+	int32_t slot;
+
+	slot = cs_disk_lookup(conf->cs->disk, crc, conf->cs->now);
+	if(likely(slot < 0)) {
+		return -ENOENT;
+	}
+	if(unlikely(cs_purge_check_disk(conf->cs, icn_pkt->name, icn_pkt->name_len, slot))) {
+		return -ENOENT;
+	}
+	buf = rte_pktmbuf_alloc(conf->pktmbuf_pool);
+	if(unlikely(buf == NULL)) {
+		return -ENOMEM;
+	}
+	if(unlikely(cs_disk_read(conf->cs->disk, slot, crc, buf, m, rx_port_id) < 0)) {
+		rte_pktmbuf_free(buf);
+		return -ENOSPC;
+	}
+	return 0;
+}
+
+
+/*
+ * Verify that a packet read from the CS disk tier is the Data requested by a
+ * parked Interest. The disk tier index only stores hashes of names, so a slot
+ * may store another Data with the same hash or may have been overwritten
+ * after the read was posted
+ */
+static inline int
+icn_cs_disk_verify(struct rte_mbuf *m, struct icn_packet *data_pkt,
+		struct icn_packet *int_pkt, uint32_t crc) {
+	struct ether_hdr *eth_hdr;
+	struct ipv4_hdr  *ipv4_hdr;
+
+	if(unlikely(rte_pktmbuf_data_len(m) < sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr)
+			+ sizeof(struct icn_hdr))) {
+		return 0;
+	}
+	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+	ipv4_hdr = (struct ipv4_hdr *)RTE_PTR_ADD(eth_hdr, sizeof(struct ether_hdr));
+	if(unlikely(eth_hdr->ether_type != ETHER_TYPE_IPv4_BE ||
+			ipv4_hdr->next_proto_id != IPPROTO_ICN)) {
+		return 0;
+	}
+	if(unlikely(icn_reparse(m, data_pkt, crc) < 0)) {
+		return 0;
+	}
+	return data_pkt->hdr->type == TYPE_DATA_BE &&
+			data_pkt->name_len == int_pkt->name_len &&
+			memcmp(data_pkt->name, int_pkt->name, int_pkt->name_len) == 0;
+}
+
+
+/*
+ * Handle reads completed by the CS disk tier: reply to the parked Interests
+ * with the Data read or, if the read failed, forward them according to the FIB
+ */
+static void
+icn_cs_disk_complete(struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	struct cs_disk_req *reqs[MAX_PKT_BURST];
+	struct icn_packet data_pkt, int_pkt;
+	struct rte_mbuf *data, *interest;
+	unsigned i, nb_cpl;
+	uint32_t crc;
+	uint8_t port;
+	int8_t status;
+
+	nb_cpl = cs_disk_poll(conf->cs->disk, reqs, MAX_PKT_BURST);
+	for (i = 0; i < nb_cpl; i++) {
+		data = reqs[i]->mbuf;
+		interest = reqs[i]->interest;
+		port = reqs[i]->port;
+		crc = reqs[i]->crc;
+		status = reqs[i]->status;
+		cs_disk_req_free(conf->cs->disk, reqs[i]);
+
+		/* The parked Interest is not parsed again */
+		icn_desc_load(icn_mbuf_desc(interest), rte_pktmbuf_mtod(interest, uint8_t *),
+				&int_pkt);
+		if(likely(status == 0 && icn_cs_disk_verify(data, &data_pkt, &int_pkt, crc))) {
+			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS disk hit for '%.*s'\n",
+					rte_lcore_id(), int_pkt.name_len, int_pkt.name);
+			conf->stats.int_cs_disk_hit++;
+			rte_pktmbuf_free(interest);
+			/* Serve the Data as if received now, which also brings it back
+			 * to the in-memory CS and answers Interests aggregated meanwhile */
+			icn_fwd_data(data, port, conf, tx_mbufs, &data_pkt, crc);
+		} else {
+			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS disk read failed for '%.*s'\n",
+					rte_lcore_id(), int_pkt.name_len, int_pkt.name);
+			conf->cs->disk->read_errors++;
+			rte_pktmbuf_free(data);
+			icn_fwd_interest_fib(interest, port, conf, tx_mbufs, &int_pkt, crc, 0, NULL);
+		}
+	}
+}
+
+
+/*
+ * Free a received packet, either now or, if a free list is given, at the end
+ * of the processing of its burst
+ */
+static inline void
+icn_pkt_free(struct rte_mbuf *m, struct mbuf_free_list *to_free) {
+	if (to_free == NULL) {
+		rte_pktmbuf_free(m);
+		return;
+	}
+	to_free->m_table[to_free->len++] = m;
+}
+
+
+/*
+ * Free the packets of a free list, returning consecutive packets of the same
+ * pool with a single bulk operation
+ */
+static void
+icn_free_burst(struct mbuf_free_list *to_free) {
+	struct rte_mbuf *bulk[MAX_PKT_BURST];
+	struct rte_mbuf *m;
+	uint16_t i, n = 0;
+
+	for (i = 0; i < to_free->len; i++) {
+		m = to_free->m_table[i];
+		if (unlikely(m->nb_segs != 1)) {
+			rte_pktmbuf_free(m);
+			continue;
+		}
+		/* NULL if the packet is still referenced, e.g. by the CS */
+		m = __rte_pktmbuf_prefree_seg(m);
+		if (m == NULL) {
+			continue;
+		}
+		m->next = NULL;
+		if (n > 0 && bulk[0]->pool != m->pool) {
+			rte_mempool_put_bulk(bulk[0]->pool, (void **) bulk, n);
+			n = 0;
+		}
+		bulk[n++] = m;
+	}
+	if (n > 0) {
+		rte_mempool_put_bulk(bulk[0]->pool, (void **) bulk, n);
+	}
+	to_free->len = 0;
+}
+
+
+/*
+ * Validate the headers of a received packet and parse its ICN header.
+ *
+ * Return 0 if the packet is an ICN one, a negative value if it is not, in
+ * which case it has been dropped
+ */
+static inline int
+icn_parse(struct rte_mbuf *m, uint8_t rx_port_id, struct app_lcore_config *conf,
+		struct icn_packet *icn_pkt) {
+
+	/* Pointers to headers of the processed packet */
+	struct ether_hdr 	*eth_hdr;
+	struct ipv4_hdr  	*ipv4_hdr;
+	uint8_t          	*pkt;           /*points to the beginning of the icn packet*/
+
+	/* Cast the head of the packet buffer to an Ethernet header */
+	eth_hdr = rte_pktmbuf_mtod(m, struct ether_hdr *);
+
+	/* Packets too short to hold the Ethernet and IPv4 headers are dropped */
+	if(unlikely(rte_pktmbuf_data_len(m) < sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr))) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received runt packet "
+				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
+		rte_pktmbuf_free(m);
+		conf->stats.malformed++;
+		return -EINVAL;
+	}
+
+	/*
+	 * If the received packet is not an IPv4 one (e.g. ARP and ICMP), drop it
+	 * without processing to save resources. In performance testing scenarios
+	 * packet routing will be done with VLANs statically configured in an
+	 * Ethernet switch
+	 *
+	 */
+	if(unlikely(eth_hdr->ether_type != ETHER_TYPE_IPv4_BE)) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received non-IPv4 packet "
+				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
+		rte_pktmbuf_free(m);
+		conf->stats.malformed++;
+		return -EINVAL;
+	}
+
+	ipv4_hdr = (struct ipv4_hdr *)RTE_PTR_ADD(eth_hdr, sizeof(struct ether_hdr));
+
+	if(unlikely(ipv4_hdr->next_proto_id != IPPROTO_ICN)) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received IPv4 packet w/o ICN "
+				"payload from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
+		rte_pktmbuf_free(m);
+		conf->stats.malformed++;
+		return -EINVAL;
+	}
+	
+	pkt = (uint8_t*) RTE_PTR_ADD(ipv4_hdr, sizeof(struct ipv4_hdr));
+	if(unlikely(icn_parse_packet(pkt, rte_pktmbuf_data_len(m) - sizeof(struct ether_hdr) -
+			sizeof(struct ipv4_hdr), icn_pkt) != 0)) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received truncated ICN packet "
+				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
+		rte_pktmbuf_free(m);
+		conf->stats.malformed++;
+		return -EINVAL;
+	}
+	/* Component offsets sent by untrusted hosts are ignored */
+	if (app_conf.tokenize_names) {
+		parse_name_components(icn_pkt);
+	}
+	return 0;
+}
+
+
+/*
+ * Hash the name of a parsed packet.
+ *
+ * Return 0 on success, a negative value if the packet carries a wrong hash,
+ * in which case it has been dropped
+ */
+static inline int
+icn_hash(struct rte_mbuf *m, uint8_t rx_port_id, struct app_lcore_config *conf,
+		struct icn_packet *icn_pkt, uint32_t *crc) {
+	struct ipv4_hdr *ipv4_hdr;
+
+	/*
+	 * Calculate CRC32 hash, unless producers embedded it in the source
+	 * address. Names are still compared on lookup, so a wrong hash cannot
+	 * return a wrong entry, but it could be used to target a bucket or to
+	 * break the match of Interests and Data: a random sample of packets is
+	 * verified and those carrying a wrong hash are dropped
+	 */
+	if (app_conf.trust_name_hash) {
+		ipv4_hdr = rte_pktmbuf_mtod_offset(m, struct ipv4_hdr *,
+				sizeof(struct ether_hdr));
+		*crc = rte_be_to_cpu_32(ipv4_hdr->src_addr);
+		if (unlikely((rte_rand() & (NAME_HASH_VERIFY_PERIOD - 1)) == 0) &&
+				unlikely(*crc != rte_hash_crc(icn_pkt->name, icn_pkt->name_len, MASTER_CRC_SEED))) {
+			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Wrong name hash for '%.*s' "
+					"from port %u. Dropping\n", rte_lcore_id(),
+					icn_pkt->name_len, icn_pkt->name, rx_port_id);
+			rte_pktmbuf_free(m);
+			conf->stats.name_hash_mismatch++;
+			return -EINVAL;
+		}
+	} else {
+		*crc = rte_hash_crc(icn_pkt->name, icn_pkt->name_len, MASTER_CRC_SEED);
+	}
+
+	if (likely(icn_pkt->component_nr < MAX_NAME_COMPONENTS)) {
+		icn_pkt->crc[icn_pkt->component_nr] = *crc;
+	}
+	icn_desc_store(icn_pkt, sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr), *crc,
+			icn_mbuf_desc(m));
+	return 0;
+}
+
+
+/*
+ * Process a parsed ICN packet. Received packets which are consumed are freed
+ * through the given free list, if not NULL. If hashed is set, the hashes of
+ * all prefixes of the name have been computed, not only the one of the name
+ */
+static void
+icn_fwd_parsed(struct rte_mbuf *m, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[],
+		struct icn_packet *icn_pkt, uint32_t crc, struct mbuf_free_list *to_free,
+		uint8_t hashed) {
+
+	int8_t ret;
+	struct pit_entry *pit_entry = NULL; // PIT entry inserted for the Interest (if any)
+	struct rte_mbuf *data; // pointer to the data packet in cache (if hit)
+	struct rte_mbuf *out;  // header mbuf of a packet to transmit
+
+	if (icn_pkt->hdr->type == TYPE_INTEREST_BE) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received Interest for '%.*s' from port %u. "
+				"Processing\n", rte_lcore_id(), icn_pkt->name_len, icn_pkt->name, rx_port_id);
+		conf->stats.int_recv++;
+		/*
+		 * Interests a face sends above its rate are dropped before any
+		 * lookup, by the first lcore they reach
+		 */
+		if (unlikely(conf->face_rate[rx_port_id].interval != 0 &&
+				!(conf->in_handoff && (icn_mbuf_desc(m)->flags & ICN_DESC_ADMITTED)) &&
+				!rate_limit_conform(&conf->face_rate[rx_port_id], rte_rdtsc()))) {
+			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Interest rate of port %u exceeded. "
+					"Dropping\n", rte_lcore_id(), rx_port_id);
+			conf->stats.int_rate_drop[rx_port_id]++;
+			icn_pkt_free(m, to_free);
+			return;
+		}
+		/* Lookup in CS */
+		data = icn_cs_lookup(conf, icn_pkt, crc);
+		if(data != NULL) {
+ 			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS hit for '%.*s'\n",
+ 					rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+			/* CS hit: Reply and delete interest */
+			conf->stats.int_cs_hit++;
+			if (conf->hot != NULL) {
+				icn_hot_hit(data, conf, crc);
+			}
+			/* The cached packet may still be queued for transmission on
+			 * other ports, so it is not edited. Only a new Ethernet header
+			 * is written and we assume that all other fields have been
+			 * verified at CS insertion
+			 */
+			out = icn_out_pkt(data, rx_port_id, conf);
+			if (unlikely(out == NULL)) {
+				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Could not allocate "
+						"header mbuf for CS hit. Dropping\n", rte_lcore_id());
+				conf->stats.sw_pkt_drop++;
+			} else {
+				send_single_packet(out, TX_CLASS_CS_HIT, &(tx_mbufs[rx_port_id]), rx_port_id,
+						conf->tx_queue_id[rx_port_id], conf);
+				conf->stats.data_sent++;
+			}
+			icn_cs_release(conf, data);
+			/* Drop received interest*/
+			icn_pkt_free(m, to_free);
+			return;
+		} else { /* CS miss */
+			/* The PIT entries of hot names served here are on their owner */
+			if (conf->hot != NULL && icn_hot_miss(m, conf, crc) == 0) {
+				return;
+			}
+			/* check PIT */
+ 			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: CS miss for '%.*s'\n",
+ 					rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+ 			ret = pit_lookup_and_update_entry_with_hash(conf->pit, icn_pkt->name, icn_pkt->name_len,
+ 					rx_port_id, NULL, crc, &pit_entry);
+			if(unlikely(ret != 1)) {	/* PIT aggregation or PIT bucket overflow */
+				/*
+				 * Reach this in case the entry was already in the PIT and
+				 * got aggregated or could not insert it due to lack of space
+				 * In any case, I don't forward the Interest. However in the
+				 * case of no space I print a debug message.
+				 *
+				 */
+				if(unlikely(ret == -ENOSPC)) {	/* PIT bucket overflow */
+					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Could not insert "
+							"Interest in PIT because full or bucket overflow. "
+							"Dropping\n", rte_lcore_id());
+					conf->stats.sw_pkt_drop++;
+				} else if(ret == -EDQUOT) {	/* PIT quota of the face exhausted */
+					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: PIT quota of port %u "
+							"exhausted. Dropping\n", rte_lcore_id(), rx_port_id);
+					conf->stats.int_quota_drop[rx_port_id]++;
+				} else {	/* PIT aggregation */
+					conf->stats.int_pit_hit++;
+ 					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: PIT aggregation for '%.*s'\n",
+ 							rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+				}
+				icn_pkt_free(m, to_free);
+			} else {	/* CS and PIT miss */
+				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: PIT miss for '%.*s'\n",
+											rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+				/*
+				 * If the Data is in the CS disk tier, the Interest waits
+				 * for the read to complete. Interests for the same name
+				 * received meanwhile are aggregated in the PIT entry
+				 */
+				if(conf->cs != NULL && conf->cs->disk != NULL &&
+						icn_cs_disk_fetch(m, rx_port_id, conf, icn_pkt, crc) == 0) {
+					RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Reading '%.*s' from CS disk tier\n",
+							rte_lcore_id(), icn_pkt->name_len, icn_pkt->name);
+					return;
+				}
+				/* query FIB and forward */
+				icn_fwd_interest_fib(m, rx_port_id, conf, tx_mbufs, icn_pkt, crc, hashed, pit_entry);
+			}
+		}
+	} else if (icn_pkt->hdr->type == TYPE_DATA_BE) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received Data for '%.*s' from port %u.\n",
+				rte_lcore_id(), icn_pkt->name_len, icn_pkt->name, rx_port_id);
+		conf->stats.data_recv += 1;
+		icn_fwd_data(m, rx_port_id, conf, tx_mbufs, icn_pkt, crc);
+		return;
+	} else {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received malformed ICN packet "
+				"from port %u. Dropping\n", rte_lcore_id(), rx_port_id);
+		conf->stats.malformed++;
+		rte_pktmbuf_free(m);
+		return;
+	}
+	/* This block of code should never be reached*/
+	return;
+}
+
+
+/* Process a received packet to completion */
+static void
+icn_fwd(struct rte_mbuf *m, uint8_t rx_port_id,  struct app_lcore_config *conf,
+		struct mbuf_table tx_mbufs[]) {
+	struct icn_packet icn_pkt;
+	uint32_t crc;
+
+	if (unlikely(icn_parse(m, rx_port_id, conf, &icn_pkt) < 0 ||
+			icn_hash(m, rx_port_id, conf, &icn_pkt, &crc) < 0)) {
+		return;
+	}
+	icn_fwd_parsed(m, rx_port_id, conf, tx_mbufs, &icn_pkt, crc, NULL, 0);
+}
+
+
+/*
+ * Move the state of a packet of a burst to another slot. Component offsets
+ * found by tokenizing the name are stored in the parsed packet itself
+ */
+static inline void
+icn_burst_move(struct icn_burst_pkt *dst, const struct icn_burst_pkt *src) {
+	*dst = *src;
+	if (src->icn_pkt.component_offsets == (const uint8_t *) src->icn_pkt.name_offsets) {
+		dst->icn_pkt.component_offsets = (uint8_t *) dst->icn_pkt.name_offsets;
+	}
+}
+
+
+/*
+ * Parse a burst of received packets and hash their names, in parallel lanes
+ * unless hashes are read from packets. Packets which are dropped are removed
+ * from the burst.
+ *
+ * Return the number of packets left, whose state is stored in burst. hashed
+ * is set if the hashes of the prefixes of their names have been computed too
+ */
+static uint16_t
+icn_parse_burst(struct rte_mbuf **pkts, uint16_t nb_pkts, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct icn_burst_pkt burst[],
+		uint8_t *hashed) {
+	struct icn_packet *icn_pkts[MAX_PKT_BURST];
+	uint32_t crcs[MAX_PKT_BURST];
+	uint16_t i, j, nb = 0;
+
+	*hashed = 0;
+	for (i = 0; i < PREFETCH_OFFSET && i < nb_pkts; i++) {
+		rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+	}
+	for (i = 0; i < nb_pkts; i++) {
+		if (i + PREFETCH_OFFSET < nb_pkts) {
+			rte_prefetch0(rte_pktmbuf_mtod(pkts[i + PREFETCH_OFFSET], void *));
+		}
+		if (likely(icn_parse(pkts[i], rx_port_id, conf, &burst[nb].icn_pkt) == 0)) {
+			burst[nb].port = rx_port_id;
+			burst[nb++].m = pkts[i];
+		}
+	}
+	if (app_conf.trust_name_hash) {
+		/* Hashes are read from packets, some of which may be dropped */
+		for (i = 0, j = 0; i < nb; i++) {
+			if (likely(icn_hash(burst[i].m, rx_port_id, conf, &burst[i].icn_pkt,
+					&burst[i].crc) == 0)) {
+				if (j != i) {
+					icn_burst_move(&burst[j], &burst[i]);
+				}
+				j++;
+			}
+		}
+		return j;
+	}
+	for (i = 0; i < nb; i++) {
+		icn_pkts[i] = &burst[i].icn_pkt;
+	}
+	name_hash_burst(icn_pkts, nb, MASTER_CRC_SEED, crcs);
+	for (i = 0; i < nb; i++) {
+		burst[i].crc = crcs[i];
+		if (likely(burst[i].icn_pkt.component_nr < MAX_NAME_COMPONENTS)) {
+			burst[i].icn_pkt.crc[burst[i].icn_pkt.component_nr] = crcs[i];
+		}
+		icn_desc_store(&burst[i].icn_pkt, sizeof(struct ether_hdr) +
+				sizeof(struct ipv4_hdr), crcs[i], icn_mbuf_desc(burst[i].m));
+	}
+	*hashed = 1;
+	return nb;
+}
+
+
+/*
+ * Process a burst of parsed and hashed packets, prefetching the entries of
+ * the tables they look up in stages:
+ *
+ *  1. prefetch the CS and PIT buckets of their names
+ *  2. prefetch the CS and PIT ring entries matching their hashes
+ *  3. process them, batching the frees of consumed packets
+ */
+static void
+icn_fwd_burst_parsed(struct icn_burst_pkt burst[], uint16_t nb,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[],
+		uint8_t hashed) {
+	struct mbuf_free_list to_free;
+	uint16_t i;
+
+	for (i = 0; i < nb; i++) {
+		if (conf->cs != NULL) {
+			cs_prefetch_bucket(conf->cs, burst[i].crc);
+		}
+		pit_prefetch_bucket(conf->pit, burst[i].crc);
+	}
+	for (i = 0; i < nb; i++) {
+		if (conf->cs != NULL && burst[i].icn_pkt.hdr->type == TYPE_INTEREST_BE) {
+			cs_prefetch_entry(conf->cs, burst[i].crc);
+		}
+		pit_prefetch_entry(conf->pit, burst[i].crc);
+	}
+	to_free.len = 0;
+	for (i = 0; i < nb; i++) {
+		icn_fwd_parsed(burst[i].m, burst[i].port, conf, tx_mbufs,
+				&burst[i].icn_pkt, burst[i].crc, &to_free, hashed);
+	}
+	icn_free_burst(&to_free);
+}
+
+
+/*
+ * Process a burst of received packets in stages, so that the cache misses of
+ * the lookups of all packets overlap instead of being serialized: all packets
+ * are parsed and their names hashed in parallel lanes, then their CS and PIT
+ * buckets and ring entries are prefetched, and only then they are processed.
+ *
+ * Packet data are prefetched PREFETCH_OFFSET packets ahead while parsing, as
+ * in the per-packet path. Prefetch stages do not change the result of
+ * processing the burst, which is the same as processing its packets one by one.
+ */
+static void
+icn_fwd_burst(struct rte_mbuf **pkts, uint16_t nb_pkts, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	struct icn_burst_pkt burst[MAX_PKT_BURST];
+	uint16_t nb;
+	uint8_t hashed;
+
+	nb = icn_parse_burst(pkts, nb_pkts, rx_port_id, conf, burst, &hashed);
+	icn_fwd_burst_parsed(burst, nb, conf, tx_mbufs, hashed);
+}
+
+
+/*
+ * Store the replica of a hot Data sent by the owner of its name. If a copy is
+ * already in the CS, its freshness is extended instead. Replicas live at most
+ * HOT_REPLICA_TTL_MS unless refreshed, so that they are retired once their
+ * name cools.
+ *
+ * The Data may have been reloaded from a CS snapshot without descriptor, so it
+ * is parsed again and its name checked against the hash set by the owner
+ */
+static void
+icn_hot_replica_insert(struct rte_mbuf *m, const struct icn_desc *desc,
+		struct app_lcore_config *conf) {
+	struct icn_packet icn_pkt;
+	uint32_t crc = desc->crc;
+	uint32_t ttl_ms = HOT_REPLICA_TTL_MS;
+
+	conf->stats.hot_replica_in++;
+	if (unlikely(icn_reparse(m, &icn_pkt, crc) < 0 ||
+			rte_hash_crc(icn_pkt.name, icn_pkt.name_len, MASTER_CRC_SEED) != crc)) {
+		RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Invalid hot Data replica. Dropping\n",
+				rte_lcore_id());
+		conf->stats.malformed++;
+		rte_pktmbuf_free(m);
+		return;
+	}
+	if (icn_pkt.freshness != 0) {
+		ttl_ms = RTE_MIN(ttl_ms, icn_pkt.freshness);
+	}
+	hot_names_replica_add(conf->hot, crc,
+			rte_rdtsc() + rte_get_tsc_hz() / MS_PER_S * ttl_ms);
+	if (cs_refresh_with_hash(conf->cs, icn_pkt.name, icn_pkt.name_len, crc,
+			ttl_ms) == 0 || cs_insert_with_hash(conf->cs, icn_pkt.name,
+			icn_pkt.name_len, m, crc, ttl_ms) < 0) {
+		rte_pktmbuf_free(m);
+	}
+}
+
+
+/*
+ * Hand a CS entry over to the lcore its name is now steered to, if it is not
+ * this one, after an update of the RETA. The mbuf is marked with
+ * ICN_MIGRATED_PORT and its descriptor carries the hash of the name and the
+ * remaining freshness period of the entry.
+ *
+ * Return 0 if the mbuf has been handed over, 1 if the entry stays in the CS
+ * of this lcore, a negative value if the ring to the owner is full
+ */
+static int
+icn_cs_migrate(struct rte_mbuf *m, uint32_t crc, uint32_t freshness_ms,
+		void *arg) {
+	struct app_lcore_config *conf = (struct app_lcore_config *) arg;
+	struct icn_desc *desc;
+	struct rte_ring *ring;
+	unsigned owner;
+
+	owner = steering_lcore(crc);
+	if (owner == rte_lcore_id() || owner >= APP_MAX_LCORES) {
+		return 1;
+	}
+	ring = conf->out_ring[lcore_conf[owner].worker_id];
+	if (unlikely(ring == NULL)) {
+		return 1;
+	}
+	desc = icn_mbuf_desc(m);
+	desc->crc = crc;
+	desc->freshness = freshness_ms;
+	m->port = ICN_MIGRATED_PORT;
+	if (rte_ring_sp_enqueue(ring, m) != 0) {
+		return -ENOBUFS;
+	}
+	conf->stats.cs_migrated_out++;
+	return 0;
+}
+
+
+/*
+ * Insert a CS entry migrated from another lcore in the CS of this lcore
+ */
+static void
+icn_cs_migrated_insert(struct rte_mbuf *m, const struct icn_desc *desc,
+		struct app_lcore_config *conf) {
+	struct icn_packet icn_pkt;
+	uint32_t crc = desc->crc, freshness_ms = desc->freshness;
+
+	conf->stats.cs_migrated_in++;
+	if (conf->cs == NULL || icn_reparse(m, &icn_pkt, crc) < 0 ||
+			cs_insert_with_hash(conf->cs, icn_pkt.name, icn_pkt.name_len, m,
+					crc, freshness_ms) < 0) {
+		rte_pktmbuf_free(m);
+	}
+}
+
+
+/*
+ * Process a burst of packets handed over by RX lcores to a worker. Their
+ * parsed form is rebuilt from the descriptors stored by the RX lcores and
+ * their lookups are prefetched in stages as in icn_fwd_burst. With hot names,
+ * packets of names owned by other lcores are replicas of hot Data. With
+ * elastic scaling, packets may be CS entries migrated from other lcores
+ */
+static void
+icn_fwd_handoff(struct rte_mbuf **pkts, uint16_t nb_pkts,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	struct icn_burst_pkt burst[MAX_PKT_BURST];
+	struct icn_desc *desc;
+	uint16_t i, nb = 0;
+
+	for (i = 0; i < nb_pkts; i++) {
+		desc = icn_mbuf_desc(pkts[i]);
+		if (conf->hot != NULL && icn_worker_of(desc->crc) != conf->worker_id) {
+			icn_hot_replica_insert(pkts[i], desc, conf);
+			continue;
+		}
+		if (unlikely(pkts[i]->port == ICN_MIGRATED_PORT)) {
+			icn_cs_migrated_insert(pkts[i], desc, conf);
+			continue;
+		}
+		icn_desc_load(desc, rte_pktmbuf_mtod(pkts[i], uint8_t *), &burst[nb].icn_pkt);
+		burst[nb].m = pkts[i];
+		burst[nb].crc = desc->crc;
+		burst[nb++].port = pkts[i]->port;
+	}
+	conf->in_handoff = 1;
+	icn_fwd_burst_parsed(burst, nb, conf, tx_mbufs, 0);
+	conf->in_handoff = 0;
+}
+
+
+/*
+ * Enqueue packets in a ring of the pipeline, dropping those which do not fit
+ */
+static inline void
+icn_ring_send(struct rte_ring *ring, struct rte_mbuf **pkts, uint16_t n,
+		struct app_lcore_config *conf) {
+	unsigned ret;
+
+	ret = rte_ring_sp_enqueue_burst(ring, (void **) pkts, n);
+	if (unlikely(ret < n)) {
+		conf->stats.ring_drop += n - ret;
+		do {
+			rte_pktmbuf_free(pkts[ret]);
+		} while (++ret < n);
+	}
+}
+
+
+#ifdef RTE_LIBRTE_EVENTDEV
+/*
+ * Inject a burst of parsed packets in the event device, as new events whose
+ * flow is the shard of their name. Packets the device does not accept for
+ * lack of credits are dropped
+ */
+static inline void
+icn_event_send(struct icn_burst_pkt *burst, uint16_t n,
+		struct app_lcore_config *conf) {
+	struct rte_event ev[MAX_PKT_BURST];
+	uint16_t i, ret;
+
+	for (i = 0; i < n; i++) {
+		ev[i].event = 0;
+		ev[i].flow_id = eventdev_shard_of(burst[i].crc);
+		ev[i].op = RTE_EVENT_OP_NEW;
+		ev[i].sched_type = RTE_SCHED_TYPE_ATOMIC;
+		ev[i].queue_id = 0;
+		ev[i].event_type = RTE_EVENT_TYPE_CPU;
+		ev[i].priority = RTE_EVENT_DEV_PRIORITY_NORMAL;
+		ev[i].mbuf = burst[i].m;
+	}
+	ret = rte_event_enqueue_burst(eventdev_conf.dev_id, conf->event_port, ev, n);
+	if (unlikely(ret < n)) {
+		conf->stats.ring_drop += n - ret;
+		do {
+			rte_pktmbuf_free(ev[ret].mbuf);
+		} while (++ret < n);
+	}
+}
+
+
+/*
+ * Loop of a worker in eventdev mode: process the packets scheduled to it by
+ * the event device. Each shard is processed by one worker at a time, which
+ * uses its PIT and CS as its own until its next dequeue
+ */
+static int
+icn_event_worker_loop(struct app_lcore_config *conf, unsigned lcore_id) {
+	struct rte_event ev[MAX_PKT_BURST];
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	struct mbuf_table tx_mbufs[APP_MAX_ETH_PORTS];
+	struct eventdev_shard *shard;
+	uint64_t cur_tsc;
+	uint16_t i, j, nb;
+	const uint64_t drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
+			US_PER_S * (uint64_t) BURST_TX_DRAIN_US;
+	const uint64_t cs_purge_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
+			US_PER_S * (uint64_t) CS_PURGE_BUDGET_US;
+
+	icn_tx_init(tx_mbufs);
+	DATA_PLANE_LOG("[LCORE_%u] Worker %u listening on event port %u\n",
+			lcore_id, conf->worker_id, conf->event_port);
+	while (likely(!app_conf.force_quit)) {
+		cur_tsc = rte_rdtsc();
+		icn_tx_drain(conf, tx_mbufs, cur_tsc);
+		nb = rte_event_dequeue_burst(eventdev_conf.dev_id, conf->event_port, ev,
+				MAX_PKT_BURST, 0);
+		if (nb == 0) {
+			continue;
+		}
+		conf->stats.rx_pkts += nb;
+
+		/* Consecutive events of the same shard are processed together */
+		for (i = 0; i < nb; i = j) {
+			shard = &eventdev_conf.shards[ev[i].flow_id];
+			for (j = i; j < nb && ev[j].flow_id == ev[i].flow_id; j++) {
+				pkts[j - i] = ev[j].mbuf;
+			}
+			conf->pit = shard->pit;
+			conf->cs = shard->cs;
+			cs_set_time(conf->cs, cur_tsc);
+			/* Shards are small: purge them whenever they are visited after a while */
+			if (unlikely((cur_tsc - shard->prev_purge_tsc) > drain_tsc)) {
+				pit_purge_expired_with_time(shard->pit, &cur_tsc);
+				cs_purge_expired(shard->cs, CS_SWEEP_BUDGET);
+				shard->prev_purge_tsc = cur_tsc;
+			}
+			cs_purge_step(shard->cs, cs_purge_tsc);
+			icn_fwd_handoff(pkts, j - i, conf, tx_mbufs);
+		}
+		conf->pit = NULL;
+		conf->cs = NULL;
+		conf->stats.busy_cycles += rte_rdtsc() - cur_tsc;
+	}
+	DATA_PLANE_LOG("[LCORE_%u] Stopped\n", lcore_id);
+	return 0;
+}
+#endif /* RTE_LIBRTE_EVENTDEV */
+
+
+/*
+ * Process a burst of received packets with software steering: packets whose
+ * names are owned by this lcore, and Interests for hot names replicated here,
+ * are processed in stages as in icn_fwd_burst, all others are handed over to
+ * their owner
+ */
+static void
+icn_fwd_burst_steer(struct rte_mbuf **pkts, uint16_t nb_pkts, uint8_t rx_port_id,
+		struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	struct icn_burst_pkt burst[MAX_PKT_BURST];
+	struct mbuf_table out[APP_MAX_LCORES];
+	uint64_t now = conf->hot != NULL ? rte_rdtsc() : 0;
+	uint16_t i, nb, nb_local = 0;
+	uint8_t w, hashed;
+
+	for (w = 0; w < app_conf.nb_workers; w++) {
+		out[w].len = 0;
+	}
+	nb = icn_parse_burst(pkts, nb_pkts, rx_port_id, conf, burst, &hashed);
+	for (i = 0; i < nb; i++) {
+		w = icn_worker_of(burst[i].crc);
+		if (w == conf->worker_id || (conf->hot != NULL &&
+				burst[i].icn_pkt.hdr->type == TYPE_INTEREST_BE &&
+				hot_names_is_replica(conf->hot, burst[i].crc, now))) {
+			if (nb_local != i) {
+				icn_burst_move(&burst[nb_local], &burst[i]);
+			}
+			nb_local++;
+			continue;
+		}
+		out[w].m_table[out[w].len++] = burst[i].m;
+	}
+	conf->stats.handoff += nb - nb_local;
+	for (w = 0; w < app_conf.nb_workers; w++) {
+		if (out[w].len > 0) {
+			icn_ring_send(conf->out_ring[w], out[w].m_table, out[w].len, conf);
+		}
+	}
+	icn_fwd_burst_parsed(burst, nb_local, conf, tx_mbufs, hashed);
+}
+
+
+/*
+ * Loop of an RX lcore of the pipeline: receive packets, parse them, hash
+ * their names and steer each of them to the worker owning its name, which
+ * finds its descriptor in the mbuf. In eventdev mode, packets are injected
+ * in the event device instead, whose scheduler RX lcores run
+ */
+static int
+icn_rx_loop(struct app_lcore_config *conf, unsigned lcore_id) {
+	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct icn_burst_pkt burst[MAX_PKT_BURST];
+	struct mbuf_table out[APP_MAX_LCORES];
+	uint64_t busy_start_tsc;
+	uint16_t i, j, nb;
+	uint8_t port_id, queue_id, w, hashed;
+	int nb_rx;
+
+	for (w = 0; w < app_conf.nb_workers; w++) {
+		out[w].len = 0;
+	}
+	while (likely(!app_conf.force_quit)) {
+		if (app_conf.eventdev) {
+			eventdev_schedule();
+		}
+		for (i = 0; i < conf->nb_rx_ports; i++) {
+			port_id = conf->rx_queue[i].port_id;
+			queue_id = conf->rx_queue[i].queue_id;
+
+			nb_rx = rte_eth_rx_burst(port_id, queue_id, pkts_burst, MAX_PKT_BURST);
+			if (nb_rx == 0) {
+				continue;
+			}
+			busy_start_tsc = rte_rdtsc();
+			conf->stats.rx_pkts += nb_rx;
+
+			nb = icn_parse_burst(pkts_burst, (uint16_t) nb_rx, port_id, conf,
+					burst, &hashed);
+#ifdef RTE_LIBRTE_EVENTDEV
+			if (app_conf.eventdev) {
+				icn_event_send(burst, nb, conf);
+				conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+				continue;
+			}
+#endif
+			for (j = 0; j < nb; j++) {
+				w = icn_worker_of(burst[j].crc);
+				out[w].m_table[out[w].len++] = burst[j].m;
+			}
+			for (w = 0; w < app_conf.nb_workers; w++) {
+				if (out[w].len > 0) {
+					icn_ring_send(conf->out_ring[w], out[w].m_table, out[w].len, conf);
+					out[w].len = 0;
+				}
+			}
+			conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+		}
+	}
+	DATA_PLANE_LOG("[LCORE_%u] Stopped\n", lcore_id);
+	return 0;
+}
+
+
+/*
+ * Loop of a TX lcore of the pipeline: transmit the packets processed by its
+ * workers on the port recorded in their mbuf, in bursts per port
+ */
+static int
+icn_tx_loop(struct app_lcore_config *conf, unsigned lcore_id) {
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+	struct mbuf_table tx_mbufs[APP_MAX_ETH_PORTS];
+	unsigned i, j, nb;
+	uint8_t port_id;
+
+	icn_tx_init(tx_mbufs);
+	while (likely(!app_conf.force_quit)) {
+		icn_tx_drain(conf, tx_mbufs, rte_rdtsc());
+		for (i = 0; i < conf->nb_in_rings; i++) {
+			nb = rte_ring_sc_dequeue_burst(conf->in_ring[i], (void **) pkts, MAX_PKT_BURST);
+			for (j = 0; j < nb; j++) {
+				port_id = pkts[j]->port;
+				send_single_packet(pkts[j], (uint8_t) pkts[j]->udata64,
+						&tx_mbufs[port_id], port_id,
+						conf->tx_queue_id[port_id], conf);
+			}
+		}
+	}
+	DATA_PLANE_LOG("[LCORE_%u] Stopped\n", lcore_id);
+	return 0;
+}
+
+
+/*
+ * Tell whether a packet of a CS snapshot would be received by an lcore, i.e.
+ * whether that lcore would cache it. In pipeline mode or with software
+ * steering, the lcore is the one owning its name
+ */
+static int
+icn_cs_snapshot_owner(const uint8_t *pkt, uint16_t len, uint32_t crc, void *arg) {
+	const struct ipv4_hdr *ipv4_hdr;
+	unsigned lcore_id = *(unsigned *) arg;
+
+	if (app_conf.pipeline || app_conf.sw_steering) {
+		return app_conf.worker_lcore[icn_worker_of(crc)] == lcore_id;
+	}
+	if (unlikely(len < sizeof(struct ether_hdr) + sizeof(struct ipv4_hdr))) {
+		return 0;
+	}
+	ipv4_hdr = (const struct ipv4_hdr *) (pkt + sizeof(struct ether_hdr));
+	return steering_lcore(rte_be_to_cpu_32(ipv4_hdr->src_addr)) == lcore_id;
+}
+
+
+/* Transmit all packets buffered by the lcore */
+static void
+icn_flush_tx(struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	uint8_t port_id;
+
+	for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		if (tx_mbufs[port_id].len == 0) {
+			continue;
+		}
+		send_burst(&tx_mbufs[port_id], tx_mbufs[port_id].len,
+				port_id, conf->tx_queue_id[port_id], conf);
+		tx_mbufs[port_id].len = 0;
+	}
+}
+
+
+/*
+ * Give the lcore an equal share of the rate of Interests of each face among
+ * the lcores RSS steers packets to, once elastic scaling activated or parked
+ * one of them
+ */
+static void
+icn_face_rate_update(struct app_lcore_config *conf) {
+	uint8_t port_id, nb_active = RTE_MAX(steering_nb_active(), (uint8_t) 1);
+
+	if (app_conf.face_rate == 0) {
+		return;
+	}
+	for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+		rate_limit_init(&conf->face_rate[port_id],
+				RTE_MAX(app_conf.face_rate / nb_active, 1U), FACE_RATE_BURST);
+	}
+}
+
+
+/*
+ * Sleep while the lcore is parked by elastic scaling, once the packets it
+ * buffered are transmitted
+ */
+static void
+icn_park(struct app_lcore_config *conf, struct mbuf_table tx_mbufs[]) {
+	icn_flush_tx(conf, tx_mbufs);
+	DATA_PLANE_LOG("[LCORE_%u] Parked\n", rte_lcore_id());
+	while (conf->state == LCORE_PARKED && likely(!app_conf.force_quit)) {
+		usleep(ELASTIC_PARK_SLEEP_US);
+		/* Packets held in TX backlogs are still retried */
+		icn_tx_drain(conf, tx_mbufs, rte_rdtsc());
+	}
+	DATA_PLANE_LOG("[LCORE_%u] Activated\n", rte_lcore_id());
+}
+
+
+/*
+ * Apply the idle policy after an iteration of the main loop which received
+ * nb_pkts packets: back off if none were received, restore busy polling
+ * otherwise. Buffered packets are transmitted before sleeping
+ */
+static inline void
+icn_idle(struct app_lcore_config *conf, struct idle_state *idle, uint32_t nb_pkts,
+		struct mbuf_table tx_mbufs[]) {
+	int i;
+
+	if (likely(nb_pkts > 0)) {
+		/* A packet may have waited for the whole sleep */
+		if (unlikely(idle->woken == IDLE_POLICY_SLEEP)) {
+			conf->stats.idle_wakeups++;
+			conf->stats.wakeup_cycles += idle->last_sleep;
+			conf->stats.max_wakeup_cycles = RTE_MAX(conf->stats.max_wakeup_cycles,
+					idle->last_sleep);
+		} else if (unlikely(idle->woken == IDLE_POLICY_INTR)) {
+			conf->stats.idle_intr_wakeups++;
+		}
+		if (unlikely(idle->empty_polls != 0)) {
+			idle_reset(idle);
+		}
+		return;
+	}
+	switch (idle_empty_poll(idle)) {
+	case IDLE_POLICY_PAUSE:
+		for (i = 0; i < IDLE_PAUSES; i++) {
+			rte_pause();
+		}
+		break;
+	case IDLE_POLICY_SLEEP:
+		icn_flush_tx(conf, tx_mbufs);
+		conf->stats.idle_cycles += idle_sleep(idle);
+		conf->stats.idle_sleeps++;
+		break;
+	case IDLE_POLICY_INTR:
+		icn_flush_tx(conf, tx_mbufs);
+		conf->stats.idle_cycles += idle_intr_wait(idle, conf);
+		conf->stats.idle_intr_waits++;
+		break;
+	default:
+		break;
+	}
+}
+
+
+/* Main data plane processing loop */
+int pkt_fwd_loop(__attribute__((unused)) void *arg) {
+	struct app_lcore_config *conf;
+	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct rte_mbuf *m;
+	unsigned lcore_id, socket_id;
+	uint64_t prev_drain_tsc, prev_pit_purge_tsc, cur_tsc;
+	int i, j, nb_rx;
+	uint64_t busy_start_tsc;
+	uint32_t nb_loaded;
+	uint8_t port_id, queue_id;
+	const uint8_t staged = app_conf.staged_burst;
+	const uint8_t elastic = app_conf.elastic;
+	const uint8_t idle_policy = app_conf.idle_policy;
+	struct cs_migration migration;
+	struct idle_state idle;
+	uint32_t steering_gen, nb_polled;
+
+	/* Period at which expired PIT and CS entries are purged. Packets
+	 * batched for transmission are sent out after the drain period of
+	 * their port instead, see icn_tx_drain()
+	 */
+	const uint64_t drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
+			US_PER_S * (uint64_t) BURST_TX_DRAIN_US;
+	const uint64_t pit_purge_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
+			US_PER_S * (uint64_t) PIT_PURGE_US;
+	const uint64_t cs_purge_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
+			US_PER_S * (uint64_t) CS_PURGE_BUDGET_US;
+
+	/* Used to pass pointers to packets to send. Init it */
+	struct mbuf_table tx_mbufs[APP_MAX_ETH_PORTS];
+	icn_tx_init(tx_mbufs);
+
+	/*
+	 * Reset TSC counters before entering the main loop
+	 */
+	prev_drain_tsc = 0;
+	prev_pit_purge_tsc = 0;
+	cur_tsc = 0;
+
+	/* get ID of the lcore on which it is running */
+	lcore_id = rte_lcore_id();
+	socket_id = rte_socket_id();
+
+	/* Get core configuration */
+	conf = &lcore_conf[lcore_id];
+	memset(&migration, 0, sizeof(migration));
+	steering_gen = elastic ? steering_generation() : 0;
 
 	DATA_PLANE_LOG("[LCORE_%u] Started\n", lcore_id);
 
-	/* The core has no RX queues to listen from */
-	if (conf->nb_rx_ports == 0) {
+	switch (conf->role) {
+	case LCORE_ROLE_RX:
+		return icn_rx_loop(conf, lcore_id);
+	case LCORE_ROLE_TX:
+		return icn_tx_loop(conf, lcore_id);
+#ifdef RTE_LIBRTE_EVENTDEV
+	case LCORE_ROLE_WORKER:
+		if (app_conf.eventdev) {
+			return icn_event_worker_loop(conf, lcore_id);
+		}
+		break;
+#endif
+	default:
+		break;
+	}
+
+	/* The core has no RX queues nor rings to listen from */
+	if (conf->nb_rx_ports == 0 && conf->nb_in_rings == 0) {
 		DATA_PLANE_LOG("[LCORE_%u] I have no RX queues to read from. I quit\n", lcore_id);
+		if (conf->cs_shared != NULL) {
+			cs_shared_unregister(conf->cs_shared, lcore_id);
+		}
 		return -1;
 	}
 
@@ -446,36 +2378,71 @@ int pkt_fwd_loop(__attribute__((unused)) void *arg) {
 		DATA_PLANE_LOG("[LCORE_%u] Listening on (port_id=%u, queue_id=%u)\n",
 				lcore_id, port_id, queue_id);
 	}
+	if (conf->nb_in_rings > 0) {
+		DATA_PLANE_LOG("[LCORE_%u] Worker %u listening on %u RX lcore rings\n",
+				lcore_id, conf->worker_id, conf->nb_in_rings);
+	}
+
+	/* RX interrupts are registered by the thread waiting for them */
+	idle_init(&idle, idle_policy, conf);
+
+	/* Reload the entries of the CS snapshot received by this lcore */
+	if (conf->cs != NULL && app_conf.cs_snapshot.addr != NULL) {
+		cs_set_time(conf->cs, rte_rdtsc());
+		nb_loaded = cs_snapshot_load(&app_conf.cs_snapshot, conf->cs,
+				conf->pktmbuf_pool, CS_SNAPSHOT_MBUF_RESERVE,
+				icn_cs_snapshot_owner, &lcore_id);
+		DATA_PLANE_LOG("[LCORE_%u] Reloaded %u CS entries\n", lcore_id, nb_loaded);
+	}
 
-	while (1) {
+	while (likely(!app_conf.force_quit)) {
 		/* Get current CPU cycle number */
 		cur_tsc = rte_rdtsc();
+		nb_polled = 0;
+		if (conf->cs != NULL) {
+			cs_set_time(conf->cs, cur_tsc);
+		}
+
+		if (unlikely(elastic)) {
+			if (unlikely(conf->state == LCORE_PARKED)) {
+				icn_park(conf, tx_mbufs);
+				continue;
+			}
+			/* Hand CS entries over to the lcores their names moved to */
+			if (unlikely(steering_gen != steering_generation())) {
+				steering_gen = steering_generation();
+				icn_face_rate_update(conf);
+				if (conf->cs != NULL) {
+					cs_migration_start(conf->cs, &migration);
+				}
+			}
+			if (unlikely(!cs_migration_done(&migration))) {
+				cs_migrate_step(conf->cs, &migration, ELASTIC_MIGRATE_BUDGET,
+						icn_cs_migrate, conf);
+			}
+		}
 
-		/* TX burst queue drain */
+		/*
+		 * TX burst queue drain: transmit the packets that waited for their
+		 * batch longer than the drain period of their port (this is to upper
+		 * bound tx batching latency)
+		 */
+		icn_tx_drain(conf, tx_mbufs, cur_tsc);
 		if (unlikely((cur_tsc - prev_drain_tsc) > drain_tsc)) {
 			/*
 			 * If the previous polling cycle took longer than a certain time,
-			 * this block of code transmits all packets enqueued right now
-			 * (this is to upper bound tx batching latency).
-			 * After this isfile done, continue and receive packets. This iteration
-			 * occurs over all TX queues allocated to this lcore.
-			 *
-			 * This is also a good time to purge the PIT because if I reach
+			 * this is a good time to purge the PIT because if I reach
 			 * this block, that means that the router is not loaded
 			 */
 			prev_drain_tsc = cur_tsc;
-			for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
-
-				if (tx_mbufs[port_id].len == 0) {
-					continue;
-				}
-				send_burst(&tx_mbufs[port_id], tx_mbufs[port_id].len,
-						 port_id, conf->tx_queue_id[port_id], &(conf->stats));
-				tx_mbufs[port_id].len = 0;
-			}
 			/* purge PIT because in period of low load */
 			pit_purge_expired_with_time(conf->pit, &cur_tsc);
 			prev_pit_purge_tsc = cur_tsc;
+			/* remove some expired CS entries and serve purge requests */
+			if (conf->cs != NULL) {
+				cs_purge_expired(conf->cs, CS_SWEEP_BUDGET);
+				cs_purge_step(conf->cs, cs_purge_tsc);
+			}
 		}
 		/* purge PIT because max inter-purge period reached */
 		if(unlikely((cur_tsc - prev_pit_purge_tsc) > pit_purge_tsc)) {
@@ -483,6 +2450,38 @@ int pkt_fwd_loop(__attribute__((unused)) void *arg) {
 			prev_pit_purge_tsc = cur_tsc;
 		}
 
+		/* Handle reads completed by the CS disk tier */
+		if (conf->cs != NULL && conf->cs->disk != NULL) {
+			icn_cs_disk_complete(conf, tx_mbufs);
+		}
+
+		/*
+		 * No pointer read from the shared CS is held across iterations
+		 * without a reference: evicted mbufs can now be freed
+		 */
+		if (conf->cs_shared != NULL) {
+			cs_shared_quiescent(conf->cs_shared, lcore_id, cur_tsc);
+		}
+
+		/* Read packets handed over by RX lcores or by other lcores */
+		for (i = 0; i < conf->nb_in_rings; i++) {
+			nb_rx = (int) rte_ring_sc_dequeue_burst(conf->in_ring[i],
+					(void **) pkts_burst, MAX_PKT_BURST);
+			if (nb_rx == 0) {
+				continue;
+			}
+			nb_polled += nb_rx;
+			busy_start_tsc = rte_rdtsc();
+			/* Packets from other forwarding lcores have been counted there */
+			if (conf->role == LCORE_ROLE_WORKER) {
+				conf->stats.rx_pkts += nb_rx;
+			} else if (!app_conf.sw_steering) {
+				conf->stats.data_handoff_in += nb_rx;
+			}
+			icn_fwd_handoff(pkts_burst, (uint16_t) nb_rx, conf, tx_mbufs);
+			conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+		}
+
 		/* Read packet from RX queues */
 		for (i = 0; i < conf->nb_rx_ports; i++) {
 			port_id = conf->rx_queue[i].port_id;
@@ -498,6 +2497,20 @@ int pkt_fwd_loop(__attribute__((unused)) void *arg) {
 			RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Received burst of %u packets "
 					"from (port=%u, queue=%u)\n",
 					lcore_id, nb_rx, port_id, queue_id);
+			nb_polled += nb_rx;
+			busy_start_tsc = rte_rdtsc();
+			conf->stats.rx_pkts += nb_rx;
+
+			if (app_conf.sw_steering) {
+				icn_fwd_burst_steer(pkts_burst, (uint16_t) nb_rx, port_id, conf, tx_mbufs);
+				conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+				continue;
+			}
+			if (staged) {
+				icn_fwd_burst(pkts_burst, (uint16_t) nb_rx, port_id, conf, tx_mbufs);
+				conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+				continue;
+			}
 
 			/* Prefetch the first PREFETCH_OFFSET packets */
 			for (j = 0; j < PREFETCH_OFFSET && j < nb_rx; j++) {
@@ -534,7 +2547,16 @@ int pkt_fwd_loop(__attribute__((unused)) void *arg) {
 				RTE_LOG(DEBUG, AUGUSTUS, "LCORE_%u: Handle pkt #%d\n", lcore_id, j);
 				icn_fwd(pkts_burst[j], port_id, conf, tx_mbufs);
 			}
+			conf->stats.busy_cycles += rte_rdtsc() - busy_start_tsc;
+		}
+
+		if (unlikely(idle_policy != IDLE_POLICY_POLL)) {
+			icn_idle(conf, &idle, nb_polled, tx_mbufs);
 		}
 	}
+	DATA_PLANE_LOG("[LCORE_%u] Stopped\n", lcore_id);
+	if (conf->cs_shared != NULL) {
+		cs_shared_unregister(conf->cs_shared, lcore_id);
+	}
 	return 0;
 }
@@ -0,0 +1,165 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+
+#include <config.h>
+
+#include "elastic.h"
+#include "steering.h"
+
+#define ELASTIC_LOG(...) printf("[ELASTIC]: " __VA_ARGS__)
+
+/**
+ * State of the elastic scaling, kept by the control plane
+ */
+struct elastic {
+	struct app_lcore_config *lcore;
+	uint64_t period_tsc;		/**< period of load checks */
+	uint64_t drain_tsc;			/**< time for which lcores drain after a RETA update */
+	uint64_t prev_tsc;			/**< last load check */
+	uint64_t drain_end;			/**< TSC at which lcores stop draining, 0 if none does */
+	uint64_t prev_busy[APP_MAX_LCORES];	/**< busy cycles of each lcore at the last check */
+	uint8_t fwd[APP_MAX_LCORES];		/**< lcores with RX queues */
+	uint8_t active[APP_MAX_LCORES];		/**< lcores RSS steers packets to */
+	unsigned first_lcore;		/**< lcore of RX queue 0, never parked */
+};
+
+static struct elastic elastic;
+
+
+int elastic_init(struct app_global_config *app, struct app_lcore_config lcore[]) {
+	unsigned lcore_id;
+
+	if (!steering_reta_known()) {
+		return -ENOTSUP;
+	}
+	memset(&elastic, 0, sizeof(elastic));
+	elastic.lcore = lcore;
+	elastic.period_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * ELASTIC_PERIOD_US;
+	/* PIT entries of names which moved expire within the PIT TTL */
+	elastic.drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * app->pit_ttl_us;
+	elastic.prev_tsc = rte_rdtsc();
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE) ||
+				lcore[lcore_id].nb_rx_ports == 0) {
+			continue;
+		}
+		elastic.fwd[lcore_id] = 1;
+		elastic.active[lcore_id] = 1;
+		lcore[lcore_id].state = LCORE_ACTIVE;
+		if (lcore[lcore_id].rx_queue[0].queue_id == 0) {
+			elastic.first_lcore = lcore_id;
+		}
+	}
+	return 0;
+}
+
+
+/* Steer packets to one more or one less lcore */
+static int
+elastic_set(unsigned lcore_id, uint8_t active) {
+	int ret;
+
+	elastic.active[lcore_id] = active;
+	ret = steering_update(elastic.active);
+	if (ret < 0) {
+		elastic.active[lcore_id] = !active;
+		ELASTIC_LOG("Cannot update RETA: %s\n", strerror(-ret));
+	}
+	return ret;
+}
+
+
+void elastic_step(uint64_t tsc) {
+	struct app_lcore_config *lcore = elastic.lcore;
+	uint64_t busy, load = 0, elapsed;
+	unsigned lcore_id, nb_active = 0, load_pct, target;
+
+	elapsed = tsc - elastic.prev_tsc;
+	if (elapsed < elastic.period_tsc) {
+		return;
+	}
+	elastic.prev_tsc = tsc;
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if (!elastic.fwd[lcore_id]) {
+			continue;
+		}
+		busy = lcore[lcore_id].stats.busy_cycles;
+		if (lcore[lcore_id].state == LCORE_ACTIVE) {
+			/* Statistics may have been reset meanwhile */
+			load += busy >= elastic.prev_busy[lcore_id] ?
+					busy - elastic.prev_busy[lcore_id] : busy;
+			nb_active++;
+		}
+		elastic.prev_busy[lcore_id] = busy;
+	}
+
+	/* One transition at a time: lcores drain until their PIT entries expire */
+	if (elastic.drain_end != 0) {
+		if (tsc < elastic.drain_end) {
+			return;
+		}
+		steering_end_drain();
+		elastic.drain_end = 0;
+		for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+			if (elastic.fwd[lcore_id] && lcore[lcore_id].state == LCORE_DRAINING) {
+				lcore[lcore_id].state = LCORE_PARKED;
+				ELASTIC_LOG("Parked lcore %u\n", lcore_id);
+			}
+		}
+		return;
+	}
+	if (nb_active == 0) {
+		return;
+	}
+	load_pct = (unsigned) (load * 100 / (elapsed * nb_active));
+
+	target = APP_MAX_LCORES;
+	if (load_pct >= ELASTIC_LOAD_HIGH) {
+		/* Activate the first parked lcore */
+		for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+			if (elastic.fwd[lcore_id] && lcore[lcore_id].state == LCORE_PARKED) {
+				target = lcore_id;
+				break;
+			}
+		}
+		if (target == APP_MAX_LCORES) {
+			return;
+		}
+		/* It must poll its RX queues as soon as packets are steered to them */
+		lcore[target].state = LCORE_ACTIVE;
+		if (elastic_set(target, 1) < 0) {
+			lcore[target].state = LCORE_PARKED;
+			return;
+		}
+		ELASTIC_LOG("Activated lcore %u, load %u%% on %u lcores\n", target,
+				load_pct, nb_active);
+	} else if (load_pct < ELASTIC_LOAD_LOW && nb_active > ELASTIC_MIN_LCORES) {
+		/* Park the last active lcore */
+		for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+			if (elastic.fwd[lcore_id] && lcore[lcore_id].state == LCORE_ACTIVE &&
+					lcore_id != elastic.first_lcore) {
+				target = lcore_id;
+			}
+		}
+		if (target == APP_MAX_LCORES || elastic_set(target, 0) < 0) {
+			return;
+		}
+		lcore[target].state = LCORE_DRAINING;
+		ELASTIC_LOG("Draining lcore %u, load %u%% on %u lcores\n", target,
+				load_pct, nb_active);
+	} else {
+		return;
+	}
+	elastic.drain_end = tsc + RTE_MAX(elastic.drain_tsc, 1ULL);
+}
@@ -0,0 +1,65 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _ELASTIC_H_
+#define _ELASTIC_H_
+
+/**
+ * @file
+ *
+ * Elastic scaling of forwarding lcores
+ *
+ * All forwarding lcores are enabled in the EAL coremask and have their RX
+ * queues, PIT and CS, but the control plane activates and parks them at
+ * runtime according to their load, i.e. the share of their cycles spent
+ * processing packets. Lcores are parked off-peak, leaving their cores to
+ * co-located services, and activated again at peak.
+ *
+ * Lcores are activated or parked one at a time, by updating the RETA of the
+ * NICs (see steering_update):
+ *  - names move to other lcores, which hand Data missing their PIT over to
+ *    the previous owner of the name until its PIT entries expire, i.e. for
+ *    the PIT TTL. The lcore being parked drains meanwhile, then sleeps
+ *  - each lcore migrates the entries of its CS whose names moved to the
+ *    lcores now owning them
+ *
+ * The lcore of RX queue 0, which receives packets RSS does not hash, is never
+ * parked.
+ */
+
+#include <stdint.h>
+
+#include <config.h>
+
+#include "init.h"
+
+/**
+ * Start elastic scaling, with all forwarding lcores active. Must be called
+ * once ports are started and the steering model is initialized
+ *
+ * @param app
+ *   Global configuration
+ * @param lcore
+ *   Configuration of all lcores
+ *
+ * @return
+ *  - 0 on success
+ *  - -ENOTSUP if the RETA of the NICs cannot be read, nor therefore updated
+ */
+int elastic_init(struct app_global_config *app, struct app_lcore_config lcore[]);
+
+/**
+ * Activate or park an lcore if load requires it, at most every
+ * ELASTIC_PERIOD_US, and park lcores which finished draining. Called
+ * periodically by the control plane
+ *
+ * @param tsc
+ *   Current TSC
+ */
+void elastic_step(uint64_t tsc);
+
+#endif /* _ELASTIC_H_ */
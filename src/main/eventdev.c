@@ -0,0 +1,376 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_debug.h>
+#include <rte_hash_crc.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+#ifdef RTE_LIBRTE_EVENTDEV
+#include <rte_eventdev.h>
+#include <rte_service.h>
+#include <rte_vdev.h>
+#endif
+
+#include <config.h>
+
+#include "eventdev.h"
+
+#define EVENTDEV_LOG(...) printf("[EVENTDEV]: " __VA_ARGS__)
+
+struct eventdev_conf eventdev_conf;
+
+#ifdef RTE_LIBRTE_EVENTDEV
+
+/* Length of the names of the scaling benchmark */
+#define EVENTDEV_BENCH_NAME_LEN 32
+
+/* State of a worker of the scaling benchmark */
+struct eventdev_bench_worker {
+	uint8_t port_id;
+	const uint8_t *names;
+	const uint32_t *crc;
+	volatile uint64_t processed;	/**< number of events processed */
+} __rte_cache_aligned;
+
+/* Set to stop the workers of the scaling benchmark */
+static volatile uint8_t eventdev_bench_stop;
+
+
+/*
+ * Create the shards of the PIT and CS. Tables are sized so that all shards
+ * together are as large as the tables of nb_workers lcores. The CS is not
+ * created if cs_max_elements is 0
+ */
+static int
+eventdev_shards_create(uint16_t nb_shards, uint32_t nb_workers,
+		uint32_t pit_num_buckets, uint32_t pit_max_elements, uint32_t pit_ttl_us,
+		uint32_t cs_num_buckets, uint32_t cs_max_elements, uint32_t cs_bf_size,
+		int socket) {
+	struct eventdev_shard *shard;
+	uint16_t i;
+
+	eventdev_conf.shards = rte_zmalloc_socket("EVENTDEV_SHARDS",
+			nb_shards * sizeof(struct eventdev_shard), RTE_CACHE_LINE_SIZE, socket);
+	if (eventdev_conf.shards == NULL) {
+		return -ENOMEM;
+	}
+	eventdev_conf.nb_shards = nb_shards;
+	for (i = 0; i < nb_shards; i++) {
+		shard = &eventdev_conf.shards[i];
+		shard->pit = pit_create(RTE_MAX(pit_num_buckets * nb_workers / nb_shards, 1U),
+				RTE_MAX(pit_max_elements * nb_workers / nb_shards, 1U), socket,
+				pit_ttl_us);
+		if (shard->pit == NULL) {
+			return -ENOMEM;
+		}
+		if (cs_max_elements == 0) {
+			continue;
+		}
+		shard->cs = cs_create(RTE_MAX(cs_num_buckets * nb_workers / nb_shards, 1U),
+				RTE_MAX(cs_max_elements * nb_workers / nb_shards, 1U),
+				cs_bf_size * nb_workers / nb_shards, socket);
+		if (shard->cs == NULL) {
+			return -ENOMEM;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Configure and start the event device, creating it if needed, with a single
+ * ATOMIC queue and nb_producers + nb_workers ports. Producer ports only
+ * inject new events, worker ports are linked to the queue
+ */
+static int
+eventdev_setup(uint8_t nb_producers, uint8_t nb_workers) {
+	struct rte_event_dev_info info;
+	struct rte_event_dev_config dev_conf;
+	struct rte_event_queue_conf queue_conf;
+	struct rte_event_port_conf port_conf;
+	uint8_t queue_id = 0, port_id;
+	int dev_id, ret;
+
+	dev_id = rte_event_dev_get_dev_id(EVENTDEV_NAME);
+	if (dev_id < 0) {
+		ret = rte_vdev_init(EVENTDEV_NAME, NULL);
+		if (ret < 0) {
+			return ret;
+		}
+		dev_id = rte_event_dev_get_dev_id(EVENTDEV_NAME);
+		if (dev_id < 0) {
+			return dev_id;
+		}
+	} else {
+		rte_event_dev_stop(dev_id);
+	}
+	eventdev_conf.dev_id = (uint8_t) dev_id;
+
+	rte_event_dev_info_get(dev_id, &info);
+	memset(&dev_conf, 0, sizeof(dev_conf));
+	dev_conf.nb_event_queues = 1;
+	dev_conf.nb_event_ports = nb_producers + nb_workers;
+	dev_conf.nb_events_limit = info.max_num_events;
+	dev_conf.nb_event_queue_flows = RTE_MIN((uint32_t) eventdev_conf.nb_shards,
+			info.max_event_queue_flows);
+	dev_conf.nb_event_port_dequeue_depth = info.max_event_port_dequeue_depth;
+	dev_conf.nb_event_port_enqueue_depth = info.max_event_port_enqueue_depth;
+	dev_conf.dequeue_timeout_ns = info.min_dequeue_timeout_ns;
+	ret = rte_event_dev_configure(dev_id, &dev_conf);
+	if (ret < 0) {
+		return ret;
+	}
+
+	/* Flows are shards, each processed by one worker at a time */
+	ret = rte_event_queue_default_conf_get(dev_id, queue_id, &queue_conf);
+	if (ret < 0) {
+		return ret;
+	}
+	queue_conf.schedule_type = RTE_SCHED_TYPE_ATOMIC;
+	queue_conf.nb_atomic_flows = dev_conf.nb_event_queue_flows;
+	ret = rte_event_queue_setup(dev_id, queue_id, &queue_conf);
+	if (ret < 0) {
+		return ret;
+	}
+
+	for (port_id = 0; port_id < dev_conf.nb_event_ports; port_id++) {
+		ret = rte_event_port_default_conf_get(dev_id, port_id, &port_conf);
+		if (ret < 0) {
+			return ret;
+		}
+		ret = rte_event_port_setup(dev_id, port_id, &port_conf);
+		if (ret < 0) {
+			return ret;
+		}
+		if (port_id >= nb_producers &&
+				rte_event_port_link(dev_id, port_id, &queue_id, NULL, 1) != 1) {
+			return -EIO;
+		}
+	}
+
+	/* The scheduler of the software device is run by producers */
+	if (rte_event_dev_service_id_get(dev_id, &eventdev_conf.service_id) == 0) {
+		rte_service_runstate_set(eventdev_conf.service_id, 1);
+	}
+	return rte_event_dev_start(dev_id);
+}
+
+
+int eventdev_init(struct app_global_config *app, struct app_lcore_config lcore[]) {
+	uint16_t lcore_id;
+	uint8_t port_id = 0;
+	int ret;
+
+	ret = eventdev_shards_create(EVENTDEV_NB_SHARDS, app->nb_workers,
+			app->pit_num_buckets, app->pit_max_elements, app->pit_ttl_us,
+			app->cs_num_buckets, app->cs_max_elements, app->cs_bf_size,
+			rte_socket_id());
+	if (ret < 0) {
+		return ret;
+	}
+	for (lcore_id = 0; lcore_id < eventdev_conf.nb_shards; lcore_id++) {
+		pit_set_face_quota(eventdev_conf.shards[lcore_id].pit,
+				RTE_MAX((uint32_t) ((uint64_t) (eventdev_conf.shards[lcore_id].pit->max_elements - 1) *
+				app->pit_face_quota / 100), 1U));
+	}
+	for (lcore_id = 0; app->cs_seg && lcore_id < eventdev_conf.nb_shards; lcore_id++) {
+		ret = cs_seg_enable(eventdev_conf.shards[lcore_id].cs,
+				RTE_MAX(app->cs_seg_num_buckets * app->nb_workers / EVENTDEV_NB_SHARDS, 1U),
+				RTE_MAX(app->cs_seg_max_blocks * app->nb_workers / EVENTDEV_NB_SHARDS, 1U),
+				rte_socket_id());
+		if (ret < 0) {
+			return ret;
+		}
+	}
+	/* RX lcores get the first ports */
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if (rte_lcore_is_enabled(lcore_id) && lcore_id != CONTROL_PLANE_LCORE &&
+				lcore[lcore_id].role == LCORE_ROLE_RX) {
+			lcore[lcore_id].event_port = port_id++;
+		}
+	}
+	for (lcore_id = 0; lcore_id < app->nb_workers; lcore_id++) {
+		lcore[app->worker_lcore[lcore_id]].event_port = port_id + lcore_id;
+	}
+	ret = eventdev_setup(port_id, app->nb_workers);
+	if (ret < 0) {
+		return ret;
+	}
+	EVENTDEV_LOG("Started %s with %u shards, %u RX lcores and %u workers\n",
+			EVENTDEV_NAME, eventdev_conf.nb_shards, port_id, app->nb_workers);
+	return 0;
+}
+
+
+void eventdev_schedule(void) {
+	rte_service_run_iter_on_app_lcore(eventdev_conf.service_id, 1);
+}
+
+
+/*
+ * Worker of the scaling benchmark: for each event, insert the name in the PIT
+ * of its shard and remove it, as an Interest and its Data would
+ */
+static int
+eventdev_bench_worker(void *arg) {
+	struct eventdev_bench_worker *w = arg;
+	struct rte_event ev[MAX_PKT_BURST];
+	struct eventdev_shard *shard;
+	uint8_t *name;
+	uint16_t i, nb;
+	uint32_t idx;
+
+	while (!eventdev_bench_stop) {
+		nb = rte_event_dequeue_burst(eventdev_conf.dev_id, w->port_id, ev,
+				MAX_PKT_BURST, 0);
+		for (i = 0; i < nb; i++) {
+			idx = (uint32_t) ev[i].u64;
+			shard = &eventdev_conf.shards[ev[i].flow_id];
+			name = (uint8_t *) w->names + idx * EVENTDEV_BENCH_NAME_LEN;
+			pit_lookup_and_update_with_hash(shard->pit, name, EVENTDEV_BENCH_NAME_LEN,
+					0, NULL, w->crc[idx]);
+			pit_lookup_and_remove_with_hash(shard->pit, name, EVENTDEV_BENCH_NAME_LEN,
+					w->crc[idx]);
+		}
+		w->processed += nb;
+	}
+	return 0;
+}
+
+
+/* Return the millions of events processed per second by nb_workers workers */
+static double
+eventdev_bench_run(struct eventdev_bench_worker *workers, uint8_t nb_workers,
+		const uint32_t *crc) {
+	struct rte_event ev[MAX_PKT_BURST];
+	uint64_t start_tsc, cycles, processed;
+	uint32_t sent = 0, idx;
+	uint16_t i, nb, done;
+	unsigned lcore_id;
+	uint8_t w = 0;
+
+	if (eventdev_setup(1, nb_workers) < 0) {
+		rte_exit(EXIT_FAILURE, "Cannot set up %s\n", EVENTDEV_NAME);
+	}
+	eventdev_bench_stop = 0;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (w == nb_workers) {
+			break;
+		}
+		workers[w].port_id = 1 + w;
+		workers[w].processed = 0;
+		rte_eal_remote_launch(eventdev_bench_worker, &workers[w], lcore_id);
+		w++;
+	}
+
+	start_tsc = rte_rdtsc();
+	do {
+		if (sent < EVENTDEV_BENCH_EVENTS) {
+			nb = RTE_MIN(MAX_PKT_BURST, EVENTDEV_BENCH_EVENTS - sent);
+			for (i = 0; i < nb; i++) {
+				idx = (uint32_t) (rte_rand() % EVENTDEV_BENCH_NAMES);
+				memset(&ev[i], 0, sizeof(ev[i]));
+				ev[i].op = RTE_EVENT_OP_NEW;
+				ev[i].queue_id = 0;
+				ev[i].sched_type = RTE_SCHED_TYPE_ATOMIC;
+				ev[i].event_type = RTE_EVENT_TYPE_CPU;
+				ev[i].flow_id = eventdev_shard_of(crc[idx]);
+				ev[i].u64 = idx;
+			}
+			/* Events refused for lack of credits are dropped */
+			done = rte_event_enqueue_burst(eventdev_conf.dev_id, 0, ev, nb);
+			sent += done;
+		}
+		eventdev_schedule();
+		for (processed = 0, w = 0; w < nb_workers; w++) {
+			processed += workers[w].processed;
+		}
+	} while (processed < sent || sent < EVENTDEV_BENCH_EVENTS);
+	cycles = RTE_MAX(rte_rdtsc() - start_tsc, 1ULL);
+
+	eventdev_bench_stop = 1;
+	rte_eal_mp_wait_lcore();
+	rte_event_dev_stop(eventdev_conf.dev_id);
+	return (double) processed * rte_get_tsc_hz() / cycles / 1e6;
+}
+
+
+void eventdev_bench(void) {
+	struct eventdev_bench_worker *workers;
+	uint8_t *names;
+	uint32_t *crc;
+	unsigned i, max_workers;
+	uint8_t nb_workers;
+
+	/* The master lcore injects events and runs the scheduler */
+	max_workers = RTE_MIN(rte_lcore_count() - 1, 16U);
+	if (max_workers == 0) {
+		rte_exit(EXIT_FAILURE, "The eventdev benchmark needs at least 2 lcores\n");
+	}
+	if (eventdev_shards_create(EVENTDEV_NB_SHARDS, 1, PIT_NUM_BUCKETS,
+			PIT_MAX_ELEMENTS, PIT_TTL_US, 0, 0, 0, rte_socket_id()) < 0) {
+		rte_exit(EXIT_FAILURE, "Cannot create shards for eventdev benchmark\n");
+	}
+	workers = rte_zmalloc(NULL, max_workers * sizeof(*workers), RTE_CACHE_LINE_SIZE);
+	names = rte_zmalloc(NULL, EVENTDEV_BENCH_NAMES * EVENTDEV_BENCH_NAME_LEN, 0);
+	crc = rte_zmalloc(NULL, EVENTDEV_BENCH_NAMES * sizeof(*crc), 0);
+	if (workers == NULL || names == NULL || crc == NULL) {
+		rte_exit(EXIT_FAILURE, "Cannot allocate memory for eventdev benchmark\n");
+	}
+	for (i = 0; i < EVENTDEV_BENCH_NAMES * EVENTDEV_BENCH_NAME_LEN; i++) {
+		names[i] = 'a' + rte_rand() % 26;
+	}
+	for (i = 0; i < EVENTDEV_BENCH_NAMES; i++) {
+		crc[i] = rte_hash_crc(names + i * EVENTDEV_BENCH_NAME_LEN,
+				EVENTDEV_BENCH_NAME_LEN, MASTER_CRC_SEED);
+	}
+	for (i = 0; i < max_workers; i++) {
+		workers[i].names = names;
+		workers[i].crc = crc;
+	}
+
+	EVENTDEV_LOG("Mevents/s processing %u events of %u names over %u shards\n",
+			EVENTDEV_BENCH_EVENTS, EVENTDEV_BENCH_NAMES, EVENTDEV_NB_SHARDS);
+	EVENTDEV_LOG("%8s %12s\n", "Workers", "Mevents/s");
+	for (nb_workers = 1; nb_workers <= max_workers; nb_workers *= 2) {
+		EVENTDEV_LOG("%8u %12.2f\n", nb_workers,
+				eventdev_bench_run(workers, nb_workers, crc));
+	}
+
+	rte_free(crc);
+	rte_free(names);
+	rte_free(workers);
+}
+
+#else /* RTE_LIBRTE_EVENTDEV */
+
+int eventdev_init(struct app_global_config *app, struct app_lcore_config lcore[]) {
+	RTE_SET_USED(app);
+	RTE_SET_USED(lcore);
+	return -ENOTSUP;
+}
+
+
+void eventdev_schedule(void) {
+}
+
+
+void eventdev_bench(void) {
+	EVENTDEV_LOG("DPDK has been built without event device support\n");
+}
+
+#endif /* RTE_LIBRTE_EVENTDEV */
@@ -0,0 +1,106 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _EVENTDEV_H_
+#define _EVENTDEV_H_
+
+/**
+ * @file
+ *
+ * Scheduling of packets to workers by a DPDK event device
+ *
+ * In eventdev mode, the PIT and CS are split in EVENTDEV_NB_SHARDS shards,
+ * instead of being owned by lcores. RX lcores parse and hash received packets
+ * and inject them in the software event device (event_sw) as events whose
+ * flow is the shard of their name. Flows are scheduled ATOMIC, so a shard is
+ * processed by one worker at a time, without locks, and the packets of a name
+ * are processed in order, while shards move across workers to balance load.
+ *
+ * Event devices are available in DPDK 17.11 and later, built with
+ * CONFIG_RTE_LIBRTE_EVENTDEV and CONFIG_RTE_LIBRTE_PMD_SW_EVENTDEV. With older
+ * DPDK versions, this mode is not available.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+
+#include <pit/pit.h>
+#include <cs/cs.h>
+
+#include <config.h>
+
+#include "init.h"
+
+#define EVENTDEV_BENCH_NAMES	4096	/**< number of distinct names of the scaling benchmark */
+#define EVENTDEV_BENCH_EVENTS	(1 << 22)	/**< number of events of each run of the scaling benchmark */
+
+/**
+ * Shard of the PIT and CS, processed by one worker at a time
+ */
+struct eventdev_shard {
+	pit_t *pit;
+	cs_t *cs;
+	uint64_t prev_purge_tsc;	/**< last time expired entries were purged */
+} __rte_cache_aligned;
+
+/**
+ * Event device shared by RX lcores and workers
+ */
+struct eventdev_conf {
+	uint8_t dev_id;
+	uint32_t service_id;	/**< service running the scheduler of the device */
+	uint16_t nb_shards;
+	struct eventdev_shard *shards;
+};
+
+extern struct eventdev_conf eventdev_conf;
+
+/**
+ * Return the shard of a name. The high bits of its hash are used, since the
+ * low ones select the buckets of the tables
+ *
+ * @param crc
+ *   CRC32 hash of the name
+ */
+static inline uint16_t
+eventdev_shard_of(uint32_t crc) {
+	return (uint16_t) (((uint64_t) crc * eventdev_conf.nb_shards) >> 32);
+}
+
+/**
+ * Create the event device, with one event port per RX lcore and per worker,
+ * and the shards of the PIT and CS. The event port of each lcore is stored in
+ * its configuration
+ *
+ * @param app
+ *   Global configuration
+ * @param lcore
+ *   Configuration of all lcores, with their roles assigned
+ *
+ * @return
+ *  - 0 on success
+ *  - -ENOTSUP if DPDK has no event device support
+ *  - a negative errno value if the device or the shards cannot be created
+ */
+int eventdev_init(struct app_global_config *app, struct app_lcore_config lcore[]);
+
+/**
+ * Run one iteration of the scheduler of the event device. Called by RX lcores,
+ * as the software event device has no scheduling thread of its own
+ */
+void eventdev_schedule(void);
+
+/**
+ * Measure the throughput of PIT operations on shards scheduled by the event
+ * device with 1 to 16 workers, as many as enabled lcores allow, print the
+ * results and stop the device. Must be called after the EAL is initialized,
+ * from the master lcore, which injects events
+ */
+void eventdev_bench(void);
+
+#endif /* _EVENTDEV_H_ */
@@ -0,0 +1,145 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_debug.h>
+#include <rte_byteorder.h>
+#include <rte_hash_crc.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+
+#include <config.h>
+#include <packet.h>
+#include <name_hash.h>
+
+#include "hash_bench.h"
+
+#define HASH_BENCH_LOG(...) printf("[HASH_BENCH]: " __VA_ARGS__)
+
+/* Name lengths measured */
+static const uint16_t hash_bench_len[] = { 16, 32, 64, 128, 256 };
+
+/* Prevents the compiler from optimizing away the hashes */
+static volatile uint32_t hash_bench_sink;
+
+
+/* Hash all names one by one, with the hashes of their prefixes if any */
+static void
+hash_bench_serial(struct icn_packet *pkts) {
+	uint32_t sink = 0;
+	uint16_t len;
+	unsigned r, i, c;
+
+	for (r = 0; r < HASH_BENCH_ROUNDS; r++) {
+		for (i = 0; i < HASH_BENCH_NAMES; i++) {
+			for (c = 0; c < pkts[i].component_nr; c++) {
+				len = rte_be_to_cpu_16(((uint16_t *) pkts[i].component_offsets)[c]) + 1;
+				pkts[i].crc[c] = rte_hash_crc(pkts[i].name, len, MASTER_CRC_SEED);
+			}
+			sink ^= rte_hash_crc(pkts[i].name, pkts[i].name_len, MASTER_CRC_SEED);
+		}
+	}
+	hash_bench_sink = sink;
+}
+
+
+/* Hash all names a burst of MAX_PKT_BURST names at a time */
+static void
+hash_bench_burst(struct icn_packet *pkts) {
+	struct icn_packet *burst[MAX_PKT_BURST];
+	uint32_t crc[MAX_PKT_BURST];
+	uint32_t sink = 0;
+	unsigned r, i, j;
+
+	for (r = 0; r < HASH_BENCH_ROUNDS; r++) {
+		for (i = 0; i < HASH_BENCH_NAMES; i += MAX_PKT_BURST) {
+			for (j = 0; j < MAX_PKT_BURST; j++) {
+				burst[j] = &pkts[i + j];
+			}
+			name_hash_burst(burst, MAX_PKT_BURST, MASTER_CRC_SEED, crc);
+			sink ^= crc[0];
+		}
+	}
+	hash_bench_sink = sink;
+}
+
+
+/* Return the millions of names hashed per second by a run of the benchmark */
+static double
+hash_bench_run(void (*run)(struct icn_packet *), struct icn_packet *pkts) {
+	uint64_t start_tsc, cycles;
+
+	/* Warm up caches */
+	run(pkts);
+	start_tsc = rte_rdtsc();
+	run(pkts);
+	cycles = RTE_MAX(rte_rdtsc() - start_tsc, 1ULL);
+	return (double) HASH_BENCH_NAMES * HASH_BENCH_ROUNDS * rte_get_tsc_hz() /
+			cycles / 1e6;
+}
+
+
+void hash_bench(void) {
+	struct icn_packet *pkts;
+	uint8_t *names;
+	uint16_t *offsets;
+	double serial, burst, serial_prefix, burst_prefix;
+	uint16_t max_len, len;
+	unsigned i, j, c;
+
+	RTE_BUILD_BUG_ON(HASH_BENCH_NAMES % MAX_PKT_BURST != 0);
+	max_len = hash_bench_len[RTE_DIM(hash_bench_len) - 1];
+	pkts = rte_zmalloc(NULL, HASH_BENCH_NAMES * sizeof(*pkts), RTE_CACHE_LINE_SIZE);
+	names = rte_zmalloc(NULL, HASH_BENCH_NAMES * max_len, RTE_CACHE_LINE_SIZE);
+	offsets = rte_zmalloc(NULL, HASH_BENCH_NAMES * HASH_BENCH_COMPONENTS *
+			sizeof(*offsets), RTE_CACHE_LINE_SIZE);
+	if (pkts == NULL || names == NULL || offsets == NULL) {
+		rte_exit(EXIT_FAILURE, "Cannot allocate memory for hash benchmark\n");
+	}
+	for (i = 0; i < HASH_BENCH_NAMES * max_len; i++) {
+		names[i] = 'a' + rte_rand() % 26;
+	}
+
+	HASH_BENCH_LOG("Mnames/s hashing %u names of %u components %u times\n",
+			HASH_BENCH_NAMES, HASH_BENCH_COMPONENTS, HASH_BENCH_ROUNDS);
+	HASH_BENCH_LOG("%8s %12s %12s %14s %14s\n", "Length", "Serial",
+			"Burst", "Serial+prefix", "Burst+prefix");
+	for (j = 0; j < RTE_DIM(hash_bench_len); j++) {
+		len = hash_bench_len[j];
+		for (i = 0; i < HASH_BENCH_NAMES; i++) {
+			pkts[i].name = &names[i * max_len];
+			pkts[i].name_len = len;
+			pkts[i].component_offsets = (uint8_t *) &offsets[i * HASH_BENCH_COMPONENTS];
+			/* The last component ends the name, as in parsed packets */
+			for (c = 0; c < HASH_BENCH_COMPONENTS; c++) {
+				offsets[i * HASH_BENCH_COMPONENTS + c] =
+						rte_cpu_to_be_16((c + 1) * len / HASH_BENCH_COMPONENTS - 1);
+				pkts[i].name[(c + 1) * len / HASH_BENCH_COMPONENTS - 1] = '/';
+			}
+			pkts[i].component_nr = 0;
+		}
+		serial = hash_bench_run(hash_bench_serial, pkts);
+		burst = hash_bench_run(hash_bench_burst, pkts);
+		for (i = 0; i < HASH_BENCH_NAMES; i++) {
+			pkts[i].component_nr = HASH_BENCH_COMPONENTS;
+		}
+		serial_prefix = hash_bench_run(hash_bench_serial, pkts);
+		burst_prefix = hash_bench_run(hash_bench_burst, pkts);
+		HASH_BENCH_LOG("%8u %12.2f %12.2f %14.2f %14.2f\n", len, serial, burst,
+				serial_prefix, burst_prefix);
+	}
+
+	rte_free(offsets);
+	rte_free(names);
+	rte_free(pkts);
+}
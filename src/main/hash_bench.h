@@ -0,0 +1,31 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _HASH_BENCH_H_
+#define _HASH_BENCH_H_
+
+/**
+ * @file
+ *
+ * Benchmark of name hashing
+ *
+ * Measures the number of names hashed per second, for several name lengths,
+ * hashing names one by one with rte_hash_crc and a burst at a time with
+ * name_hash_burst, both with and without the hashes of their prefixes.
+ */
+
+#define HASH_BENCH_NAMES		1024	/**< number of distinct names hashed */
+#define HASH_BENCH_ROUNDS		2048	/**< times each name is hashed */
+#define HASH_BENCH_COMPONENTS	4		/**< number of components of each name */
+
+/**
+ * Run the benchmark and print its results. Must be called after the EAL is
+ * initialized
+ */
+void hash_bench(void);
+
+#endif /* _HASH_BENCH_H_ */
@@ -0,0 +1,103 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_interrupts.h>
+#include <rte_lcore.h>
+
+#include <config.h>
+
+#include "idle.h"
+
+#define IDLE_LOG(...) printf("[IDLE]: " __VA_ARGS__)
+
+
+int idle_policy_parse(const char *name) {
+	if (!strcmp(name, "poll")) {
+		return IDLE_POLICY_POLL;
+	} else if (!strcmp(name, "pause")) {
+		return IDLE_POLICY_PAUSE;
+	} else if (!strcmp(name, "sleep")) {
+		return IDLE_POLICY_SLEEP;
+	} else if (!strcmp(name, "intr")) {
+		return IDLE_POLICY_INTR;
+	}
+	return -1;
+}
+
+
+void idle_init(struct idle_state *idle, uint8_t policy,
+		const struct app_lcore_config *conf) {
+	int i, ret;
+
+	memset(idle, 0, sizeof(*idle));
+	idle->sleep_us = IDLE_SLEEP_MIN_US;
+	idle->max_level = policy;
+	if (policy != IDLE_POLICY_INTR) {
+		return;
+	}
+	/* Interrupts are only raised by RX queues */
+	if (conf->nb_rx_ports == 0) {
+		idle->max_level = IDLE_POLICY_SLEEP;
+		return;
+	}
+	for (i = 0; i < conf->nb_rx_ports; i++) {
+		ret = rte_eth_dev_rx_intr_ctl_q(conf->rx_queue[i].port_id,
+				conf->rx_queue[i].queue_id, RTE_EPOLL_PER_THREAD,
+				RTE_INTR_EVENT_ADD, NULL);
+		if (ret != 0) {
+			IDLE_LOG("[LCORE_%u] Cannot register RX interrupt of (port_id=%u, queue_id=%u): "
+					"err=%d, sleeping instead\n", rte_lcore_id(), conf->rx_queue[i].port_id,
+					conf->rx_queue[i].queue_id, ret);
+			idle->max_level = IDLE_POLICY_SLEEP;
+			return;
+		}
+	}
+}
+
+
+uint64_t idle_sleep(struct idle_state *idle) {
+	uint64_t start = rte_rdtsc();
+
+	usleep(idle->sleep_us);
+	idle->sleep_us = RTE_MIN(idle->sleep_us * 2, (uint32_t) IDLE_SLEEP_MAX_US);
+	idle->last_sleep = rte_rdtsc() - start;
+	idle->woken = IDLE_POLICY_SLEEP;
+	return idle->last_sleep;
+}
+
+
+uint64_t idle_intr_wait(struct idle_state *idle, const struct app_lcore_config *conf) {
+	struct rte_epoll_event event[APP_MAX_ETH_PORTS];
+	uint64_t start = rte_rdtsc();
+	uint8_t pending = 0;
+	int i;
+
+	for (i = 0; i < conf->nb_rx_ports; i++) {
+		rte_eth_dev_rx_intr_enable(conf->rx_queue[i].port_id, conf->rx_queue[i].queue_id);
+	}
+	/* Packets received before interrupts were enabled raise none */
+	for (i = 0; i < conf->nb_rx_ports && !pending; i++) {
+		pending = rte_eth_rx_queue_count(conf->rx_queue[i].port_id,
+				conf->rx_queue[i].queue_id) > 0;
+	}
+	if (!pending) {
+		rte_epoll_wait(RTE_EPOLL_PER_THREAD, event, conf->nb_rx_ports,
+				IDLE_INTR_TIMEOUT_MS);
+	}
+	for (i = 0; i < conf->nb_rx_ports; i++) {
+		rte_eth_dev_rx_intr_disable(conf->rx_queue[i].port_id, conf->rx_queue[i].queue_id);
+	}
+	idle->last_sleep = rte_rdtsc() - start;
+	idle->woken = IDLE_POLICY_INTR;
+	return idle->last_sleep;
+}
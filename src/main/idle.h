@@ -0,0 +1,146 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _IDLE_H_
+#define _IDLE_H_
+
+/**
+ * @file
+ *
+ * Idle policies of forwarding lcores
+ *
+ * By default, lcores poll their RX queues and rings continuously, using their
+ * core fully whatever the load. With an idle policy, an lcore backs off as
+ * consecutive polls return no packets, escalating up to the level allowed by
+ * the policy:
+ *  - after IDLE_PAUSE_POLLS empty polls, it pauses the CPU between polls
+ *  - after IDLE_SLEEP_POLLS, it sleeps between polls, for IDLE_SLEEP_MIN_US
+ *    at first and twice as long after each empty poll, up to
+ *    IDLE_SLEEP_MAX_US, leaving its core to other processes
+ *  - after IDLE_INTR_POLLS, it enables the RX interrupts of its queues and
+ *    waits for one, for at most IDLE_INTR_TIMEOUT_MS
+ * The first poll returning packets restores busy polling.
+ */
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+
+#include <config.h>
+
+#include "init.h"
+
+#define IDLE_POLICY_POLL	0	/**< always poll */
+#define IDLE_POLICY_PAUSE	1	/**< pause the CPU between empty polls */
+#define IDLE_POLICY_SLEEP	2	/**< then sleep between empty polls */
+#define IDLE_POLICY_INTR	3	/**< then wait for RX interrupts */
+
+/**
+ * Idle state of an lcore
+ */
+struct idle_state {
+	uint32_t empty_polls;	/**< number of consecutive polls which returned no packets */
+	uint32_t sleep_us;		/**< duration of the next sleep */
+	uint8_t max_level;		/**< IDLE_POLICY_* the lcore may escalate to */
+	uint8_t woken;			/**< IDLE_POLICY_SLEEP or IDLE_POLICY_INTR if the last poll followed a sleep or a wait */
+	uint64_t last_sleep;	/**< duration of the last sleep or wait, in TSC cycles */
+};
+
+/**
+ * Return the IDLE_POLICY_* value of the name of a policy
+ *
+ * @param name
+ *   "poll", "pause", "sleep" or "intr"
+ *
+ * @return
+ *   The policy, a negative value if the name is unknown
+ */
+int idle_policy_parse(const char *name);
+
+/**
+ * Initialize the idle state of the calling lcore. With the RX interrupt
+ * policy, the RX interrupts of its queues are registered in the epoll
+ * instance of its thread. If they cannot be, or the lcore has no RX queues,
+ * it only escalates to sleeps
+ *
+ * @param idle
+ *   Idle state of the lcore
+ * @param policy
+ *   Idle policy, IDLE_POLICY_*
+ * @param conf
+ *   Configuration of the lcore
+ */
+void idle_init(struct idle_state *idle, uint8_t policy,
+		const struct app_lcore_config *conf);
+
+/**
+ * Count a poll which returned no packets and return how the lcore must back
+ * off before polling again
+ *
+ * @param idle
+ *   Idle state of the lcore
+ *
+ * @return
+ *   IDLE_POLICY_POLL to poll again now, or IDLE_POLICY_PAUSE,
+ *   IDLE_POLICY_SLEEP or IDLE_POLICY_INTR
+ */
+static inline uint8_t
+idle_empty_poll(struct idle_state *idle) {
+	idle->woken = IDLE_POLICY_POLL;
+	if (likely(++idle->empty_polls < IDLE_PAUSE_POLLS) ||
+			idle->max_level == IDLE_POLICY_POLL) {
+		return IDLE_POLICY_POLL;
+	}
+	if (idle->empty_polls < IDLE_SLEEP_POLLS || idle->max_level == IDLE_POLICY_PAUSE) {
+		return IDLE_POLICY_PAUSE;
+	}
+	if (idle->empty_polls < IDLE_INTR_POLLS || idle->max_level == IDLE_POLICY_SLEEP) {
+		return IDLE_POLICY_SLEEP;
+	}
+	return IDLE_POLICY_INTR;
+}
+
+/**
+ * Restore busy polling once a poll returned packets
+ *
+ * @param idle
+ *   Idle state of the lcore
+ */
+static inline void
+idle_reset(struct idle_state *idle) {
+	idle->empty_polls = 0;
+	idle->sleep_us = IDLE_SLEEP_MIN_US;
+	idle->woken = IDLE_POLICY_POLL;
+}
+
+/**
+ * Sleep, doubling the duration of the next sleep
+ *
+ * @param idle
+ *   Idle state of the lcore
+ *
+ * @return
+ *   Time slept, in TSC cycles
+ */
+uint64_t idle_sleep(struct idle_state *idle);
+
+/**
+ * Wait for an RX interrupt of the queues of the calling lcore, or for
+ * IDLE_INTR_TIMEOUT_MS. Interrupts are only enabled while waiting
+ *
+ * @param idle
+ *   Idle state of the lcore
+ * @param conf
+ *   Configuration of the lcore
+ *
+ * @return
+ *   Time waited, in TSC cycles
+ */
+uint64_t idle_intr_wait(struct idle_state *idle, const struct app_lcore_config *conf);
+
+#endif /* _IDLE_H_ */
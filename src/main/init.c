@@ -9,12 +9,14 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 #include <net/if.h>
 
 #include <rte_lcore.h>
@@ -27,11 +29,16 @@
 #include <fib/fib.h>
 #include <pit/pit.h>
 #include <cs/cs.h>
+#include <cs/cs_disk.h>
 
 #define MYPORT 9000    // the port users will be connecting to
 
 #include "data_plane.h"
+#include "elastic.h"
+#include "eventdev.h"
+#include "idle.h"
 #include "init.h"
+#include "steering.h"
 
 #define INIT_LOG(...) printf("[INIT]: " __VA_ARGS__)
 
@@ -109,12 +116,24 @@ init_mbuf_pools(struct app_global_config *app, struct app_lcore_config lcore[])
 	unsigned lcore_id;
 	char pool_name[64];
 	struct rte_mempool *pool[APP_MAX_SOCKETS];
+	struct rte_mempool *hdr_pool[APP_MAX_SOCKETS];
+	struct rte_mempool *clone_pool[APP_MAX_SOCKETS];
+	struct rte_pktmbuf_pool_private mbp_priv;
+
+	/* Packet mbufs store the descriptor of the parsed packet after the mbuf */
+	RTE_BUILD_BUG_ON(sizeof(struct icn_desc) > MBUF_PRIV_SIZE);
+	mbp_priv.mbuf_data_room_size = (uint16_t) (app->mbuf_size - sizeof(struct rte_mbuf));
+	mbp_priv.mbuf_priv_size = app->mbuf_priv_size;
 	/* This loop is needed */
 	for (socket_id = 0; socket_id < APP_MAX_SOCKETS; socket_id++) {
 		pool[socket_id] = NULL;
+		hdr_pool[socket_id] = NULL;
+		clone_pool[socket_id] = NULL;
 	}
 	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
 		lcore[lcore_id].pktmbuf_pool = NULL;
+		lcore[lcore_id].hdr_pool = NULL;
+		lcore[lcore_id].clone_pool = NULL;
 
 		if (!rte_lcore_is_enabled(lcore_id)) {
 			continue;
@@ -131,10 +150,10 @@ init_mbuf_pools(struct app_global_config *app, struct app_lcore_config lcore[])
 				rte_mempool_create(
 						pool_name,					// Name
 						app->nb_mbuf, 				// Number of elements
-						app->mbuf_size, 			// Size of each element
+						app->mbuf_size + app->mbuf_priv_size,	// Size of each element
 						app->mempool_cache_size,	// Per-lcore cache size
 						sizeof(struct rte_pktmbuf_pool_private),	// private data size
-						rte_pktmbuf_pool_init, NULL,	// pointer to func init mempool	and args
+						rte_pktmbuf_pool_init, &mbp_priv,	// pointer to func init mempool	and args
 						rte_pktmbuf_init, NULL,			// pointer to func init mbuf and args
 						socket_id,				// socket ID
 						0);						// flags
@@ -147,6 +166,38 @@ init_mbuf_pools(struct app_global_config *app, struct app_lcore_config lcore[])
 			}
 		}
 		lcore[lcore_id].pktmbuf_pool = pool[socket_id];
+
+		/*
+		 * Header and indirect mbufs are used to transmit the same packet
+		 * to several faces without ever writing in the shared packet
+		 */
+		if (hdr_pool[socket_id] == NULL) {
+			snprintf(pool_name, sizeof(pool_name), "hdr_pool_%d", socket_id);
+			hdr_pool[socket_id] =
+				rte_pktmbuf_pool_create(pool_name, app->nb_hdr_mbuf,
+						app->mempool_cache_size, 0,
+						app->hdr_mbuf_data_size, socket_id);
+			if (hdr_pool[socket_id] == NULL) {
+				rte_exit(EXIT_FAILURE,
+						"Cannot init header mbuf pool on socket %d\n", socket_id);
+			}
+			INIT_LOG("Allocated header mbuf pool on socket %d\n", socket_id);
+		}
+		lcore[lcore_id].hdr_pool = hdr_pool[socket_id];
+
+		if (clone_pool[socket_id] == NULL) {
+			snprintf(pool_name, sizeof(pool_name), "clone_pool_%d", socket_id);
+			/* Indirect mbufs have no data room of their own */
+			clone_pool[socket_id] =
+				rte_pktmbuf_pool_create(pool_name, app->nb_clone_mbuf,
+						app->mempool_cache_size, 0, 0, socket_id);
+			if (clone_pool[socket_id] == NULL) {
+				rte_exit(EXIT_FAILURE,
+						"Cannot init indirect mbuf pool on socket %d\n", socket_id);
+			}
+			INIT_LOG("Allocated indirect mbuf pool on socket %d\n", socket_id);
+		}
+		lcore[lcore_id].clone_pool = clone_pool[socket_id];
 	}
 	return 0;
 }
@@ -185,31 +236,43 @@ static int start_ports(uint32_t portmask, uint8_t promisc_mode) {
  *
  * @params portmask
  *   User-provided port mask
+ * @params tx_weights
+ *   DRR weights of the classes of TX backlogs, NULL to serve them by priority
  */
-static void init_queues(uint32_t portmask, struct app_lcore_config lcore[]) {
+static void init_queues(uint32_t portmask, uint8_t nb_rx_queues,
+		uint32_t tx_lcore_mask, const uint32_t *tx_weights,
+		struct app_lcore_config lcore[]) {
 	// Iterate over cores and ports to enable HW queues and map them to cores
 
 	int ret;
 	/*
-	 * queue_id is needed to keep track of the queue IDs assigned to each
+	 * queue IDs are needed to keep track of the queue IDs assigned to each
 	 * lcore because there can be holes in the sequence of lcore IDs
 	 * (e.g. 1, 2, 4) but there cannot be holes in the RX and TX queues
-	 * lists. 
+	 * lists. In pipeline mode, only RX lcores have RX queues and only TX
+	 * lcores (or workers, if there are no TX lcores) have TX queues. With
+	 * software steering, lcores beyond the RX queues of the ports have none
 	 */
-	uint8_t port_id, queue_id;
+	uint8_t port_id, rx_queue_id, tx_queue_id;
 	uint8_t socket_id, lcore_id;
 	uint8_t nb_ports;
 	uint8_t nb_ports_available;
+	uint8_t role, has_rx, has_tx;
 
 	/* Get number of ports enabled via command line */
 	nb_ports = rte_eth_dev_count();
 	nb_ports_available = get_nb_ports_available(portmask);
-	for (lcore_id = 0, queue_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+	for (lcore_id = 0, rx_queue_id = 0, tx_queue_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
 		/* if lcore is not enabled, skip queues initialization */
 		if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE)) {
 			continue;
 		}
-		lcore[lcore_id].nb_rx_ports = nb_ports_available;
+		role = lcore[lcore_id].role;
+		has_rx = (role == LCORE_ROLE_FWD || role == LCORE_ROLE_RX) &&
+				rx_queue_id < nb_rx_queues;
+		has_tx = role == LCORE_ROLE_FWD || role == LCORE_ROLE_TX ||
+				(role == LCORE_ROLE_WORKER && tx_lcore_mask == 0);
+		lcore[lcore_id].nb_rx_ports = has_rx ? nb_ports_available : 0;
 		lcore[lcore_id].nb_ports = nb_ports;
 		socket_id = (uint8_t) rte_lcore_to_socket_id(lcore_id);
 
@@ -219,16 +282,18 @@ static void init_queues(uint32_t portmask, struct app_lcore_config lcore[]) {
 				continue;
 			}
 
-			lcore[lcore_id].rx_queue[port_id].port_id = port_id;
-			lcore[lcore_id].rx_queue[port_id].queue_id = queue_id;
-
-			//TODO: Review rx_conf, nv_rxd
-			ret = rte_eth_rx_queue_setup(port_id, (uint16_t) queue_id, nb_rxd,
-					socket_id,	&rx_conf, lcore[lcore_id].pktmbuf_pool);
-			if (ret < 0) {
-				rte_exit(EXIT_FAILURE,
-						"rte_eth_rx_queue_setup:err=%d, port=%u\n",
-					  ret, (unsigned) port_id);
+			if (has_rx) {
+				lcore[lcore_id].rx_queue[port_id].port_id = port_id;
+				lcore[lcore_id].rx_queue[port_id].queue_id = rx_queue_id;
+
+				//TODO: Review rx_conf, nv_rxd
+				ret = rte_eth_rx_queue_setup(port_id, (uint16_t) rx_queue_id, nb_rxd,
+						socket_id,	&rx_conf, lcore[lcore_id].pktmbuf_pool);
+				if (ret < 0) {
+					rte_exit(EXIT_FAILURE,
+							"rte_eth_rx_queue_setup:err=%d, port=%u\n",
+						  ret, (unsigned) port_id);
+				}
 			}
 			/* init one TX queue on each port
 			 *
@@ -237,18 +302,217 @@ static void init_queues(uint32_t portmask, struct app_lcore_config lcore[]) {
 			 * flexibility. See whether I should improve the situation at some
 			 * point
 			 */
-			lcore[lcore_id].tx_queue_id[port_id] = queue_id;
-			ret = rte_eth_tx_queue_setup(port_id, queue_id, nb_txd, socket_id, &tx_conf);
-			if (ret < 0)
-				rte_exit(EXIT_FAILURE,
-						"rte_eth_tx_queue_setup:err=%d, port=%u\n",
-						ret, (unsigned) port_id);
+			if (has_tx) {
+				lcore[lcore_id].tx_queue_id[port_id] = tx_queue_id;
+				ret = rte_eth_tx_queue_setup(port_id, tx_queue_id, nb_txd, socket_id, &tx_conf);
+				if (ret < 0)
+					rte_exit(EXIT_FAILURE,
+							"rte_eth_tx_queue_setup:err=%d, port=%u\n",
+							ret, (unsigned) port_id);
+				lcore[lcore_id].tx_backlog[port_id] = tx_backlog_create(tx_weights,
+						socket_id);
+				if (lcore[lcore_id].tx_backlog[port_id] == NULL) {
+					rte_exit(EXIT_FAILURE, "Cannot create TX backlog of lcore %u, port %u\n",
+							lcore_id, (unsigned) port_id);
+				}
+			}
+		}
+		rx_queue_id += has_rx;
+		tx_queue_id += has_tx;
+	}
+}
+
+
+/*
+ * Assign a role to each forwarding lcore. Without pipeline, all lcores
+ * process the packets they receive to completion. Otherwise, lcores of the
+ * RX and TX masks receive and transmit packets and all other lcores are
+ * workers. Without pipeline, all lcores own names, the ones mapped to them
+ * by RSS or by software steering, as workers do, and are listed in
+ * worker_lcore.
+ *
+ * The numbers of lcores with RX queues and with TX queues are stored in
+ * nb_rx_lcores and nb_tx_lcores
+ */
+static void init_lcore_roles(struct app_global_config *app,
+		struct app_lcore_config lcore[], uint8_t *nb_rx_lcores,
+		uint8_t *nb_tx_lcores) {
+	uint8_t lcore_id, nb_lcores = 0, nb_rx = 0, nb_tx = 0;
+	uint32_t mask = 0;
+
+	app->nb_workers = 0;
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE)) {
+			continue;
+		}
+		mask |= 1 << lcore_id;
+		nb_lcores++;
+		if (!app->pipeline) {
+			lcore[lcore_id].role = LCORE_ROLE_FWD;
+			lcore[lcore_id].worker_id = app->nb_workers;
+			app->worker_lcore[app->nb_workers++] = lcore_id;
+		} else if (app->rx_lcore_mask & (1 << lcore_id)) {
+			lcore[lcore_id].role = LCORE_ROLE_RX;
+			nb_rx++;
+		} else if (app->tx_lcore_mask & (1 << lcore_id)) {
+			lcore[lcore_id].role = LCORE_ROLE_TX;
+			nb_tx++;
+		} else {
+			lcore[lcore_id].role = LCORE_ROLE_WORKER;
+			lcore[lcore_id].worker_id = app->nb_workers;
+			app->worker_lcore[app->nb_workers++] = lcore_id;
+		}
+	}
+	if (!app->pipeline) {
+		*nb_rx_lcores = nb_lcores;
+		*nb_tx_lcores = nb_lcores;
+		return;
+	}
+	if ((app->rx_lcore_mask | app->tx_lcore_mask) & ~mask) {
+		rte_exit(EXIT_FAILURE, "RX and TX lcores must be enabled forwarding lcores\n");
+	}
+	if (app->rx_lcore_mask & app->tx_lcore_mask) {
+		rte_exit(EXIT_FAILURE, "An lcore cannot be both an RX and a TX lcore\n");
+	}
+	if (app->nb_workers == 0) {
+		rte_exit(EXIT_FAILURE, "No lcore left to be a worker\n");
+	}
+	*nb_rx_lcores = nb_rx;
+	*nb_tx_lcores = nb_tx > 0 ? nb_tx : app->nb_workers;
+	INIT_LOG("Pipeline of %u RX lcores, %u workers and %u TX lcores\n",
+			nb_rx, app->nb_workers, nb_tx);
+}
+
+
+/*
+ * Connect the lcores of the pipeline with single-producer single-consumer
+ * rings: each RX lcore to each worker and each worker to a TX lcore, assigned
+ * round robin. Rings are allocated on the socket of their consumer
+ */
+static void init_pipeline_rings(struct app_global_config *app,
+		struct app_lcore_config lcore[]) {
+	uint8_t lcore_id, tx_lcore[APP_MAX_LCORES];
+	uint8_t i, w, nb_tx = 0;
+	struct app_lcore_config *worker;
+	struct rte_ring *ring;
+	char ring_name[64];
+
+	if (!app->pipeline) {
+		return;
+	}
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		lcore[lcore_id].nb_in_rings = 0;
+		lcore[lcore_id].tx_ring = NULL;
+		if (rte_lcore_is_enabled(lcore_id) && lcore_id != CONTROL_PLANE_LCORE &&
+				lcore[lcore_id].role == LCORE_ROLE_TX) {
+			tx_lcore[nb_tx++] = lcore_id;
 		}
-		queue_id++;
+	}
+	/* Packets reach workers through the event device instead */
+	if (app->eventdev) {
+		return;
+	}
+	for (w = 0; w < app->nb_workers; w++) {
+		worker = &lcore[app->worker_lcore[w]];
+		for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+			if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE) ||
+					lcore[lcore_id].role != LCORE_ROLE_RX) {
+				continue;
+			}
+			snprintf(ring_name, sizeof(ring_name), "rx_%u_worker_%u",
+					lcore_id, app->worker_lcore[w]);
+			ring = rte_ring_create(ring_name, PIPELINE_RING_SIZE,
+					rte_lcore_to_socket_id(app->worker_lcore[w]),
+					RING_F_SP_ENQ | RING_F_SC_DEQ);
+			if (ring == NULL) {
+				rte_exit(EXIT_FAILURE, "Cannot create ring %s\n", ring_name);
+			}
+			lcore[lcore_id].out_ring[w] = ring;
+			worker->in_ring[worker->nb_in_rings++] = ring;
+		}
+		if (nb_tx == 0) {
+			continue;
+		}
+		i = tx_lcore[w % nb_tx];
+		snprintf(ring_name, sizeof(ring_name), "worker_%u_tx_%u",
+				app->worker_lcore[w], i);
+		ring = rte_ring_create(ring_name, PIPELINE_RING_SIZE,
+				rte_lcore_to_socket_id(i), RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (ring == NULL) {
+			rte_exit(EXIT_FAILURE, "Cannot create ring %s\n", ring_name);
+		}
+		worker->tx_ring = ring;
+		lcore[i].in_ring[lcore[i].nb_in_rings++] = ring;
 	}
 }
 
 
+/*
+ * Connect each pair of forwarding lcores with a single-producer
+ * single-consumer ring, over which the first one hands packets over to the
+ * second one when their names are owned by it: all packets with software
+ * steering, Data reaching the wrong lcore with RSS
+ */
+static void init_steering_rings(struct app_global_config *app,
+		struct app_lcore_config lcore[]) {
+	struct app_lcore_config *src, *dst;
+	struct rte_ring *ring;
+	char ring_name[64];
+	uint8_t i, j;
+
+	if (app->pipeline) {
+		return;
+	}
+	for (i = 0; i < app->nb_workers; i++) {
+		lcore[app->worker_lcore[i]].nb_in_rings = 0;
+		lcore[app->worker_lcore[i]].tx_ring = NULL;
+	}
+	for (i = 0; i < app->nb_workers; i++) {
+		src = &lcore[app->worker_lcore[i]];
+		for (j = 0; j < app->nb_workers; j++) {
+			src->out_ring[j] = NULL;
+			if (i == j) {
+				continue;
+			}
+			dst = &lcore[app->worker_lcore[j]];
+			snprintf(ring_name, sizeof(ring_name), "steer_%u_%u",
+					app->worker_lcore[i], app->worker_lcore[j]);
+			ring = rte_ring_create(ring_name, PIPELINE_RING_SIZE,
+					rte_lcore_to_socket_id(app->worker_lcore[j]),
+					RING_F_SP_ENQ | RING_F_SC_DEQ);
+			if (ring == NULL) {
+				rte_exit(EXIT_FAILURE, "Cannot create ring %s\n", ring_name);
+			}
+			src->out_ring[j] = ring;
+			dst->in_ring[dst->nb_in_rings++] = ring;
+		}
+	}
+	if (app->sw_steering) {
+		INIT_LOG("Software steering over %u lcores\n", app->nb_workers);
+	}
+}
+
+
+/*
+ * Return the max number of RX queues that all enabled ports support
+ */
+static uint8_t get_max_rx_queues(uint32_t portmask) {
+	struct rte_eth_dev_info dev_info;
+	uint8_t port_id, nb_ports;
+	uint16_t max_rx_queues = UINT8_MAX;
+
+	nb_ports = RTE_MIN(rte_eth_dev_count(), (uint8_t) APP_MAX_ETH_PORTS);
+	for (port_id = 0; port_id < nb_ports; port_id++) {
+		if ((portmask & (1 << port_id)) == 0) {
+			continue;
+		}
+		rte_eth_dev_info_get(port_id, &dev_info);
+		max_rx_queues = RTE_MIN(max_rx_queues, dev_info.max_rx_queues);
+	}
+	return (uint8_t) max_rx_queues;
+}
+
+
 /**
  * @param portmask
  *   The mask of enabled ports passed via command line
@@ -256,10 +520,16 @@ static void init_queues(uint32_t portmask, struct app_lcore_config lcore[]) {
  *   The number of RX queues enabled in each port
  * @param nb_tx_queues
  *   The number of TX queues enabled in each port
+ * @param rss
+ *   Whether NICs steer packets to RX queues with RSS
+ * @param rx_intr
+ *   Whether RX queues raise interrupts, when enabled by idle lcores
  *
  */
 static int
-init_ports(uint32_t portmask, uint8_t nb_rx_queues, uint8_t nb_tx_queues) {
+init_ports(uint32_t portmask, uint8_t nb_rx_queues, uint8_t nb_tx_queues,
+		uint8_t rss, uint8_t rx_intr) {
+	struct rte_eth_conf conf = port_conf;
 	int ret;
 	uint8_t port_id, nb_ports, nb_ports_available;
 	/*
@@ -342,7 +612,13 @@ init_ports(uint32_t portmask, uint8_t nb_rx_queues, uint8_t nb_tx_queues) {
 		 * NIC such as RSS configuration, checksum calculation offload,
 		 * VLAN and JumboFrame support. It is defined further up in this file
 		 */
-		ret = rte_eth_dev_configure(port_id, nb_rx_queues, nb_tx_queues, &port_conf);
+		if (!rss) {
+			conf.rxmode.mq_mode = ETH_MQ_RX_NONE;
+			conf.rx_adv_conf.rss_conf.rss_hf = 0;
+		}
+		/* Idle lcores may wait for RX interrupts */
+		conf.intr_conf.rxq = rx_intr;
+		ret = rte_eth_dev_configure(port_id, nb_rx_queues, nb_tx_queues, &conf);
 		if (ret < 0) {
 			rte_exit(EXIT_FAILURE, "Cannot configure device: err=%d, port=%u\n",
 					ret, port_id);
@@ -429,13 +705,27 @@ static void init_addr_table(uint32_t portmask, struct app_lcore_config lcore[],
 
 static void init_fwd_data_structures(struct app_global_config *app,
 	struct app_lcore_config lcore[]) {
-	uint8_t lcore_id, socket_id;
+	uint8_t lcore_id, socket_id, port_id;
 	fib_t *fibs[APP_MAX_SOCKETS];
 	fib_t *fib;
+	cs_shared_t *cs_shared[APP_MAX_SOCKETS];
+	uint32_t nb_fwd_lcores[APP_MAX_SOCKETS];
 
 	/* Reset fibs array */
 	for (socket_id = 0; socket_id < APP_MAX_SOCKETS; socket_id++) {
 		fibs[socket_id] = NULL;
+		cs_shared[socket_id] = NULL;
+		nb_fwd_lcores[socket_id] = 0;
+	}
+
+	/* A shared CS is as large as the per-lcore CSs of its socket together */
+	if (app->cs_shared) {
+		for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+			if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE)) {
+				continue;
+			}
+			nb_fwd_lcores[rte_lcore_to_socket_id(lcore_id)]++;
+		}
 	}
 
 	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
@@ -450,19 +740,131 @@ static void init_fwd_data_structures(struct app_global_config *app,
 		}
 		lcore[lcore_id].fib = fib;
 
+		/*
+		 * RX and TX lcores of a pipeline do not look up names, workers of
+		 * the event device use the tables of the shards scheduled to them
+		 */
+		lcore[lcore_id].pit = NULL;
+		lcore[lcore_id].cs = NULL;
+		lcore[lcore_id].cs_shared = NULL;
+		lcore[lcore_id].hot = NULL;
+		lcore[lcore_id].strategy = NULL;
+		/* The Interests of a face are spread over the lcores owning names */
+		for (port_id = 0; port_id < APP_MAX_ETH_PORTS; port_id++) {
+			rate_limit_init(&lcore[lcore_id].face_rate[port_id], app->face_rate == 0 ? 0 :
+					RTE_MAX(app->face_rate / app->nb_workers, 1U), FACE_RATE_BURST);
+		}
+		/* Workers of the event device forward Interests with their own FIB */
+		if (app->rtt_strategy && lcore_has_tables(&lcore[lcore_id])) {
+			/* PIT entries record the FIB entries of their upstream in 16 bits */
+			lcore[lcore_id].strategy = strategy_create(RTE_MIN(app->fib_max_elements,
+					(uint32_t) PIT_MAX_NEXTHOPS), socket_id);
+			if (lcore[lcore_id].strategy == NULL) {
+				rte_exit(EXIT_FAILURE, "Cannot create forwarding strategy of lcore %u\n",
+						lcore_id);
+			}
+		}
+		if (!lcore_has_tables(&lcore[lcore_id]) || app->eventdev) {
+			continue;
+		}
 		lcore[lcore_id].pit = pit_create(app->pit_num_buckets,
 				app->pit_max_elements, socket_id,
 				app->pit_ttl_us);
-
+		if (lcore[lcore_id].pit == NULL) {
+			rte_exit(EXIT_FAILURE, "Cannot create PIT of lcore %u\n", lcore_id);
+		}
+		pit_set_face_quota(lcore[lcore_id].pit,
+				RTE_MAX((uint32_t) ((uint64_t) app->pit_max_elements *
+				app->pit_face_quota / 100), 1U));
+
+		if (app->cs_shared) {
+			if (cs_shared[socket_id] == NULL) {
+				cs_shared[socket_id] = cs_shared_create(
+						app->cs_num_buckets * nb_fwd_lcores[socket_id],
+						app->cs_max_elements * nb_fwd_lcores[socket_id],
+						app->cs_shared_shards, socket_id);
+				if (cs_shared[socket_id] == NULL) {
+					rte_exit(EXIT_FAILURE, "Cannot create shared CS on socket %u\n",
+							socket_id);
+				}
+			}
+			cs_shared_register(cs_shared[socket_id], lcore_id);
+			lcore[lcore_id].cs_shared = cs_shared[socket_id];
+			lcore[lcore_id].cs = NULL;
+			continue;
+		}
 		lcore[lcore_id].cs = cs_create(app->cs_num_buckets,
-				app->cs_max_elements, socket_id);
+				app->cs_max_elements, app->cs_bf_size, socket_id);
+		if (lcore[lcore_id].cs == NULL) {
+			rte_exit(EXIT_FAILURE, "Cannot create CS of lcore %u\n", lcore_id);
+		}
+		if (app->cs_seg && cs_seg_enable(lcore[lcore_id].cs, app->cs_seg_num_buckets,
+				app->cs_seg_max_blocks, socket_id) < 0) {
+			rte_exit(EXIT_FAILURE, "Cannot create CS segment index of lcore %u\n",
+					lcore_id);
+		}
+		/* Once replicated, the Interests of a hot name are spread over all lcores */
+		if (app->hot_names) {
+			lcore[lcore_id].hot = hot_names_create(app->hot_threshold,
+					app->hot_threshold / app->nb_workers, app->hot_epoch_us, socket_id);
+			if (lcore[lcore_id].hot == NULL) {
+				rte_exit(EXIT_FAILURE, "Cannot create hot names of lcore %u\n", lcore_id);
+			}
+		}
+	}
+}
+
+/*
+ * Attach a disk tier to the CS of each forwarding lcore. All tiers share the
+ * same file, each using its own region
+ */
+static void init_cs_disk(struct app_global_config *app,
+	struct app_lcore_config lcore[]) {
+	cs_disk_t *disks[APP_MAX_LCORES];
+	cs_disk_t *disk;
+	unsigned nb_disks = 0;
+	uint64_t region_size;
+	uint8_t lcore_id;
+	int fd;
+
+	if (app->cs_disk_path[0] == '\0') {
+		return;
 	}
+	fd = open(app->cs_disk_path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		rte_exit(EXIT_FAILURE, "Cannot open CS disk tier file %s\n",
+				app->cs_disk_path);
+	}
+	app->cs_disk_fd = fd;
+	region_size = (uint64_t) (app->cs_disk_max_elements + 1) * CS_DISK_SLOT_SIZE;
+
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE) ||
+				!lcore_has_tables(&lcore[lcore_id])) {
+			continue;
+		}
+		disk = cs_disk_create(fd, nb_disks * region_size,
+				app->cs_disk_num_buckets, app->cs_disk_max_elements,
+				rte_lcore_to_socket_id(lcore_id), lcore_id);
+		if (disk == NULL) {
+			rte_exit(EXIT_FAILURE, "Cannot create CS disk tier for lcore %u\n",
+					lcore_id);
+		}
+		cs_set_disk(lcore[lcore_id].cs, disk);
+		disks[nb_disks++] = disk;
+	}
+	if (cs_disk_io_start(disks, nb_disks) < 0) {
+		rte_exit(EXIT_FAILURE, "Cannot start CS disk I/O thread\n");
+	}
+	INIT_LOG("CS disk tier enabled on %s (%u regions)\n", app->cs_disk_path,
+			nb_disks);
 }
 
 void init_fib_update_process(int *sockfd)
 {
 	struct addrinfo *servinfo, *p;
 	struct sockaddr_in hints;
+	struct timeval tv;
 	int numbytes;
 	struct sockaddr_storage their_addr;
 
@@ -488,24 +890,51 @@ void init_fib_update_process(int *sockfd)
 		perror("listener: bind");
 		return;
 	}
+
+	/* Do not block forever, so that the control plane can be stopped */
+	tv.tv_sec = CTRL_RECV_TIMEOUT_US / 1000000;
+	tv.tv_usec = CTRL_RECV_TIMEOUT_US % 1000000;
+	if (setsockopt((*sockfd), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1)
+	{
+		perror("listener: setsockopt");
+	}
 }
 
 void init_app(struct app_global_config *app, struct app_lcore_config lcore[]) {
-	uint8_t nb_lcores = get_nb_lcores_available();
-	nb_lcores -= 1; //One core is reserved for control plane
-	
+	uint8_t nb_rx_lcores, nb_tx_lcores;
+
+	init_lcore_roles(app, lcore, &nb_rx_lcores, &nb_tx_lcores);
 	INIT_LOG("Initializing mbuf pools\n");
 	init_mbuf_pools(app, lcore);
 	INIT_LOG("Initializing ICN forwarding data structures (FIB, PIT, CS)\n");
 	init_fwd_data_structures(app, lcore);
+	init_cs_disk(app, lcore);
+	init_pipeline_rings(app, lcore);
+	init_steering_rings(app, lcore);
+	if (app->eventdev) {
+		INIT_LOG("Initializing event device\n");
+		if (eventdev_init(app, lcore) < 0) {
+			rte_exit(EXIT_FAILURE, "Cannot initialize event device %s\n", EVENTDEV_NAME);
+		}
+	}
+	/* With software steering, any lcore can receive any packet */
+	if (app->sw_steering) {
+		nb_rx_lcores = RTE_MIN(nb_rx_lcores, get_max_rx_queues(app->portmask));
+	}
 	INIT_LOG("Initializing ports\n");
-	init_ports(app->portmask, nb_lcores, nb_lcores);
+	init_ports(app->portmask, nb_rx_lcores, nb_tx_lcores, !app->sw_steering,
+			app->idle_policy == IDLE_POLICY_INTR);
 	INIT_LOG("Initializing hardware queues\n");
-	init_queues(app->portmask, lcore);
+	init_queues(app->portmask, nb_rx_lcores, app->tx_lcore_mask,
+			app->tx_drr ? app->tx_weights : NULL, lcore);
 	INIT_LOG("Starting ports\n");
 	start_ports(app->portmask, app->promic_mode);
 	INIT_LOG("Setting MAC address table\n");
 	init_addr_table(app->portmask, lcore, app->config_remote_addr);
+	steering_init(app->portmask, lcore);
+	if (app->elastic && elastic_init(app, lcore) < 0) {
+		rte_exit(EXIT_FAILURE, "Cannot read RETA, required for elastic scaling\n");
+	}
 	init_fib_update_process(&(app->sockfd));
 	INIT_LOG("Initializing FIB table update process\n");
 	INIT_LOG("Initialization complete\n");
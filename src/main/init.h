@@ -28,6 +28,7 @@
 #include <rte_ip.h>
 #include <rte_mempool.h>
 #include <rte_mbuf.h> //pkt_fwd_loop
+#include <rte_ring.h>
 #include <rte_hash_crc.h>
 #include <rte_memory.h>
 #include <rte_ether.h>
@@ -35,6 +36,12 @@
 #include <fib/fib.h>
 #include <pit/pit.h>
 #include <cs/cs.h>
+#include <cs/cs_shared.h>
+#include <cs/cs_snapshot.h>
+#include <hot_names.h>
+#include <tx_backlog.h>
+#include <rate_limit.h>
+#include <strategy.h>
 
 #include <config.h>
 
@@ -103,6 +110,27 @@ static const struct rte_eth_txconf tx_conf = {
 };
 
 
+/*
+ * Roles of forwarding lcores. By default, each lcore processes the packets it
+ * receives to completion. In pipeline mode, RX lcores receive, parse and hash
+ * packets and steer them to the worker owning their name, which processes
+ * them and hands them over to a TX lcore, if any, for transmission
+ */
+#define LCORE_ROLE_FWD		0	/**< receive, process and transmit packets */
+#define LCORE_ROLE_RX		1	/**< receive packets and steer them to workers */
+#define LCORE_ROLE_WORKER	2	/**< process packets received from RX lcores */
+#define LCORE_ROLE_TX		3	/**< transmit packets processed by workers */
+
+/*
+ * States of forwarding lcores with elastic scaling, set by the control plane
+ * according to load. No packets are steered to a draining lcore any more, but
+ * it still serves the Data matching its PIT entries, handed over by the lcores
+ * now receiving them. A parked lcore sleeps until activated again
+ */
+#define LCORE_ACTIVE	0
+#define LCORE_DRAINING	1
+#define LCORE_PARKED	2
+
 /**
  * Structure tracking local and remote MAC addresses for each port
  */
@@ -126,6 +154,39 @@ struct stats {
 	uint32_t nic_pkt_drop; /**< number of packet dropped in the NIC due to queue overflow */
 	uint32_t sw_pkt_drop;	/**< number of packet dropped by SW data strucutre overflow */
 	uint32_t malformed;		/**< number of malformed packets received */
+	uint32_t int_cs_disk_hit;	/**< number of Interest packets served by the CS disk tier */
+	uint32_t int_cs_bf_skip;	/**< number of CS lookups skipped thanks to the CS Bloom filter */
+	uint32_t int_cs_bf_fp;		/**< number of CS misses not detected by the CS Bloom filter (false positives) */
+	uint32_t name_hash_mismatch;	/**< number of packets dropped because their embedded name hash is wrong */
+	uint32_t int_rate_drop[APP_MAX_ETH_PORTS];	/**< number of Interests of each face dropped by its rate limit */
+	uint32_t int_quota_drop[APP_MAX_ETH_PORTS];	/**< number of Interests of each face not inserted in the PIT because of its quota */
+	uint32_t ring_drop;		/**< number of packets dropped because a handoff ring is full */
+	uint32_t handoff;		/**< number of packets handed over to the lcore owning their name */
+	uint32_t data_handoff_out;	/**< number of Data without PIT entry handed over to the lcore RSS steers their name to */
+	uint32_t data_handoff_in;	/**< number of Data handed over by other lcores */
+	uint32_t hot_replica_out;	/**< number of replicas of hot Data sent to other lcores */
+	uint32_t hot_replica_in;	/**< number of replicas of hot Data received from other lcores */
+	uint32_t int_hot_hit;		/**< number of Interests served by replicas of hot Data */
+	uint32_t cs_migrated_out;	/**< number of CS entries migrated to other lcores after a RETA update */
+	uint32_t cs_migrated_in;	/**< number of CS entries migrated from other lcores */
+	uint32_t int_probe;			/**< number of Interests forwarded to probe a next hop other than the best one */
+	uint32_t rtt_samples;		/**< number of Data whose RTT was measured by the forwarding strategy */
+	uint64_t rtt_cycles;		/**< sum of the RTTs measured, in CPU cycles */
+	uint32_t idle_sleeps;		/**< number of sleeps after empty polls */
+	uint32_t idle_intr_waits;	/**< number of waits for RX interrupts after empty polls */
+	uint32_t idle_intr_wakeups;	/**< number of waits for RX interrupts after which packets were received */
+	uint32_t idle_wakeups;		/**< number of sleeps after which packets were received */
+	uint64_t idle_cycles;		/**< number of CPU cycles spent sleeping or waiting for RX interrupts */
+	uint64_t wakeup_cycles;		/**< number of CPU cycles spent in sleeps after which packets were received */
+	uint64_t max_wakeup_cycles;	/**< longest sleep after which packets were received, in CPU cycles */
+	uint32_t tx_backlogged;		/**< number of packets held in TX backlogs because the NIC queue was full */
+	uint32_t tx_backlog_max;	/**< max number of packets held in the TX backlog of a port */
+	uint32_t tx_backlog_int_drop;	/**< number of Interests dropped because a TX backlog was full */
+	uint32_t tx_backlog_data_drop;	/**< number of Data dropped because a TX backlog was full */
+	uint32_t tx_backlog_sent[TX_NB_CLASSES];	/**< number of packets of each class transmitted from TX backlogs */
+	uint64_t rx_pkts;			/**< number of packets received */
+	uint32_t tx_delay_hist[APP_MAX_ETH_PORTS][TX_DELAY_HIST_BUCKETS];	/**< batches per TX port by delay of their oldest packet */
+	uint64_t busy_cycles;		/**< number of CPU cycles spent processing received packets */
 }__attribute__((__packed__)) __rte_cache_aligned;
 
 
@@ -139,19 +200,58 @@ struct app_global_config {
 	uint32_t pit_num_buckets;
 	uint32_t pit_max_elements;
 	uint32_t pit_ttl_us;
+	uint32_t pit_face_quota;	/**< max share of each PIT taken by the entries of a face, in percent */
+	uint32_t face_rate;		/**< max rate of Interests admitted from each face, in packets per second, 0 if unlimited */
+	uint8_t  rtt_strategy;	/**< forward Interests to the next hop with the lowest measured RTT */
 
 	/* CS settings */
 	uint32_t cs_num_buckets;
 	uint32_t cs_max_elements;
+	uint32_t cs_bf_size;
+	uint8_t  cs_shared;		/**< one CS shared by all lcores of a socket instead of one per lcore */
+	uint32_t cs_shared_shards;
+	uint8_t  cs_seg;		/**< store chunks of segmented objects in the segment index of the CS */
+	uint32_t cs_seg_num_buckets;
+	uint32_t cs_seg_max_blocks;
+	char     cs_disk_path[CS_DISK_PATH_LEN];	/**< file of the disk tier, empty if disabled */
+	uint32_t cs_disk_num_buckets;
+	uint32_t cs_disk_max_elements;
+	int      cs_disk_fd;		/**< file of the disk tier, -1 if not open */
+	char     cs_snapshot_path[CS_DISK_PATH_LEN];	/**< file of the CS snapshot, empty if disabled */
+	struct cs_snapshot cs_snapshot;	/**< snapshot being reloaded, if any */
 
 	/* Packet burst settings */
 	uint16_t tx_burst_size;
 	uint16_t rx_burst_size;
+	uint32_t tx_slo_us;		/**< max TX batching delay with adaptive batching, 0 for fixed batching */
+	uint8_t  tx_drr;		/**< serve the classes of TX backlogs by DRR instead of by priority */
+	uint32_t tx_weights[TX_NB_CLASSES];	/**< DRR weight of each class of TX backlogs */
+	uint8_t  staged_burst;	/**< process received bursts in stages instead of packet by packet */
+	uint8_t  trust_name_hash;	/**< use the name hash embedded in the source IPv4 address instead of computing it */
+	uint8_t  tokenize_names;	/**< find component offsets by tokenizing names instead of trusting the component offsets TLV */
+
+	/* Pipeline settings */
+	uint8_t  pipeline;		/**< split forwarding lcores in RX, worker and TX lcores */
+	uint32_t rx_lcore_mask;	/**< lcores receiving packets in pipeline mode */
+	uint32_t tx_lcore_mask;	/**< lcores transmitting packets in pipeline mode, 0 if workers transmit */
+	uint8_t  sw_steering;	/**< steer names to lcores in software instead of relying on RSS */
+	uint8_t  eventdev;		/**< schedule packets from RX lcores to workers with an event device */
+	uint8_t  hot_names;		/**< replicate the Data of hot names in the CS of all lcores */
+	uint32_t hot_threshold;	/**< Interests per epoch making a name hot */
+	uint32_t hot_epoch_us;
+	uint8_t  elastic;		/**< activate and park forwarding lcores at runtime according to load */
+	uint8_t  idle_policy;	/**< how lcores back off after empty polls, IDLE_POLICY_* */
+	uint8_t  nb_workers;	/**< number of lcores owning names, i.e. workers or forwarding lcores */
+	uint8_t  worker_lcore[APP_MAX_LCORES];	/**< lcore ID of each lcore owning names */
 
 	/* Packet pool settings */
 	uint32_t nb_mbuf;
 	uint32_t mbuf_size;
+	uint16_t mbuf_priv_size;	/**< size of the private area of packet mbufs, storing packet descriptors */
 	uint32_t mempool_cache_size;
+	uint32_t nb_hdr_mbuf;
+	uint16_t hdr_mbuf_data_size;
+	uint32_t nb_clone_mbuf;
 
 	/* Other config */
 	uint8_t promic_mode;
@@ -159,6 +259,7 @@ struct app_global_config {
 	uint8_t numa_on;
 	char    config_remote_addr[APP_MAX_ETH_PORTS][18];
 	int sockfd;
+	volatile uint8_t force_quit;	/**< set on SIGINT or SIGTERM to stop all lcores */
 
 }__attribute__((__packed__)) __rte_cache_aligned;
 
@@ -172,17 +273,36 @@ struct lcore_rx_queue {
 struct app_lcore_config {
 	/* packet buffers */
 	struct rte_mempool *pktmbuf_pool;
+	struct rte_mempool *hdr_pool;	/**< pool of mbufs holding Ethernet headers of TX packets */
+	struct rte_mempool *clone_pool;	/**< pool of indirect mbufs attached to shared packets */
 
 	/* ports */
 	uint8_t nb_rx_ports;
 	uint8_t nb_ports;
 	struct lcore_rx_queue rx_queue[APP_MAX_ETH_PORTS];
 	uint16_t tx_queue_id[APP_MAX_ETH_PORTS];
+	tx_backlog_t *tx_backlog[APP_MAX_ETH_PORTS];	/**< packets waiting for room in each TX queue, NULL if the lcore has none */
+
+	/* pipeline */
+	uint8_t role;			/**< LCORE_ROLE_* */
+	uint8_t worker_id;		/**< index of the lcore in worker_lcore, if any */
+	uint8_t nb_in_rings;
+	struct rte_ring *in_ring[APP_MAX_LCORES];	/**< rings from lcores steering packets to this one, or from workers (TX lcores) */
+	struct rte_ring *out_ring[APP_MAX_LCORES];	/**< rings to the lcores owning names, indexed by worker ID */
+	struct rte_ring *tx_ring;	/**< ring to the TX lcore of a worker, NULL if it transmits itself */
+	uint8_t event_port;		/**< port of the event device, in eventdev mode */
+	volatile uint8_t state;	/**< LCORE_ACTIVE, LCORE_DRAINING or LCORE_PARKED */
+	uint8_t in_handoff;		/**< processing packets handed over by other lcores, not to be handed over again */
 
 	/* data structures */
 	fib_t *fib;
 	pit_t *pit;
 	cs_t *cs;
+	cs_shared_t *cs_shared;	/**< CS shared by the lcores of the socket, if enabled (then cs is NULL) */
+	hot_names_t *hot;		/**< hot names owned by the lcore and replicas it holds, if enabled */
+	strategy_t *strategy;	/**< RTT measurements of the next hops of the FIB, if the RTT strategy is enabled */
+	struct rate_limit face_rate[APP_MAX_ETH_PORTS];	/**< rate limit of the Interests of each face */
+	struct cs_freshness_rules freshness;	/**< default freshness periods of Data, set by the control plane */
 
 	/* stats */
 	struct stats stats;
@@ -193,6 +313,16 @@ struct app_lcore_config {
 }__attribute__((__packed__)) __rte_cache_aligned;
 
 
+/**
+ * Tell whether an lcore has its own PIT and CS, i.e. whether it processes
+ * packets
+ */
+static inline int
+lcore_has_tables(const struct app_lcore_config *conf) {
+	return conf->role == LCORE_ROLE_FWD || conf->role == LCORE_ROLE_WORKER;
+}
+
+
 /**
  * Initialize all configuration parameters of the application
  */
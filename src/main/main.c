@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <getopt.h>
 #include <signal.h>
+#include <unistd.h>
 
 #include <rte_eal.h>
 #include <rte_per_lcore.h>
@@ -26,10 +27,15 @@
 #include <util.h>
 #include <config.h>
 #include <packet.h>
+#include <cs/cs_disk.h>
 
 #include "init.h"
 #include "data_plane.h"
 #include "control_plane.h"
+#include "eventdev.h"
+#include "idle.h"
+#include "hash_bench.h"
+#include "parse_bench.h"
 
 #include "main.h"
 
@@ -40,6 +46,30 @@ struct user_params {
 	uint8_t numa_on;
 	uint8_t promisc_mode;
 	char config_remote_addr[APP_MAX_ETH_PORTS][18];
+	char cs_disk_path[CS_DISK_PATH_LEN];
+	uint32_t cs_disk_max_elements;
+	uint8_t cs_shared;
+	uint8_t cs_seg;
+	char cs_snapshot_path[CS_DISK_PATH_LEN];
+	uint8_t staged_burst;
+	uint8_t trust_name_hash;
+	uint8_t tokenize_names;
+	uint32_t rx_lcore_mask;
+	uint32_t tx_lcore_mask;
+	uint8_t sw_steering;
+	uint8_t eventdev;
+	uint8_t hot_names;
+	uint8_t elastic;
+	uint8_t idle_policy;
+	uint32_t tx_slo_us;
+	uint8_t tx_drr;
+	uint32_t face_rate;
+	uint32_t pit_face_quota;
+	uint8_t rtt_strategy;
+	uint32_t tx_weights[TX_NB_CLASSES];
+	uint8_t hash_bench;
+	uint8_t parse_bench;
+	uint8_t eventdev_bench;
 };
 
 /* These are declared as extern in data plane */
@@ -53,6 +83,12 @@ print_usage(const char *prgname)
 {
 	printf ("Usage:\n"
 			"  %s [EAL options] -- -p PORTMASK -P [--no-numa] -m MAC0 [MAC1 .. MACN]\n"
+			"     [--cs-disk FILE [--cs-disk-elements N] | --shared-cs] [--seg-cs]\n"
+			"     [--cs-snapshot FILE] [--staged] [--trust-name-hash] [--tokenize-names]\n"
+			"     [--rx-lcores MASK [--tx-lcores MASK | --eventdev] | --sw-steering [--hot-names] | --elastic]\n"
+			"     [--idle poll|pause|sleep|intr] [--tx-slo-us N] [--tx-weights D,C,I]\n"
+			"     [--face-rate PPS] [--pit-quota PCT] [--rtt-strategy]\n"
+			"  %s [EAL options] -- (--hash-bench | --parse-bench | --eventdev-bench)\n"
 			"  %s [EAL options] -- (--help | -h)\n"
 			"  %s [EAL options] -- (--version | -v)\n"
 			"\n"
@@ -61,9 +97,32 @@ print_usage(const char *prgname)
 			"  -m MAC0 [MAC1 .. MACN]:      list of MAC addresses associated to port0, port1, ..., portN (separated by a space)\n"
 			"  -P                           Enable promiscuous mode\n"
 			"  --no-numa                    Disable NUMA awareness\n"
+			"  --cs-disk FILE               Spill packets evicted from the CS to FILE (file or block device)\n"
+			"  --cs-disk-elements N         Max number of packets stored on disk per lcore\n"
+			"  --shared-cs                  Use one CS per NUMA socket shared by all its lcores\n"
+			"  --seg-cs                     Store chunks of segmented objects in per-object blocks of the CS\n"
+			"  --cs-snapshot FILE           Reload the CS from FILE on startup and save it to FILE on SIGINT/SIGTERM\n"
+			"  --staged                     Process received bursts in stages, prefetching CS and PIT entries\n"
+			"  --trust-name-hash            Use the name hash embedded in the source IPv4 address of packets\n"
+			"  --tokenize-names             Find name components by tokenizing names instead of using the component offsets TLV\n"
+			"  --rx-lcores MASK             Hexadecimal bitmask of lcores receiving packets and steering them to worker lcores\n"
+			"  --tx-lcores MASK             Hexadecimal bitmask of lcores transmitting packets processed by worker lcores\n"
+			"  --sw-steering                Steer names to lcores in software, for NICs and virtual devices without RSS\n"
+			"  --eventdev                   Schedule packets from RX lcores to worker lcores with the software event device\n"
+			"  --hot-names                  Replicate the Data of hot names in the CS of all lcores and spread their Interests\n"
+			"  --elastic                    Activate and park forwarding lcores at runtime according to load\n"
+			"  --idle POLICY                Back off after empty polls: poll (default), pause, sleep or intr (RX interrupts)\n"
+			"  --tx-slo-us N                Adapt TX batching to the load of each port, delaying packets by at most N us\n"
+			"  --tx-weights D,C,I           Serve Data, CS hits and Interests waiting for a full TX queue by DRR with these weights\n"
+			"  --face-rate PPS              Max rate of Interests admitted from each face, in packets per second\n"
+			"  --pit-quota PCT              Max share of each PIT taken by the Interests of one face, in percent\n"
+			"  --rtt-strategy               Forward Interests to the next hop with the lowest measured RTT, probing the others\n"
+			"  --hash-bench                 Measure the throughput of name hashing and exit\n"
+			"  --parse-bench                Measure the time taken to parse packets and exit\n"
+			"  --eventdev-bench             Measure the throughput of the event device with 1 to 16 workers and exit\n"
 			"  -h --help                    Show this help\n"
 			"  -v, --version                Show version\n",
-			prgname, prgname, prgname);
+			prgname, prgname, prgname, prgname);
 }
 
 static void print_version() {
@@ -94,6 +153,29 @@ static int parse_args(int argc, char **argv, struct user_params *params) {
 	#define CMD_LINE_OPT_NO_NUMA "no-numa"
 	#define CMD_LINE_OPT_HELP "help"
 	#define CMD_LINE_OPT_VERSION "version"
+	#define CMD_LINE_OPT_CS_DISK "cs-disk"
+	#define CMD_LINE_OPT_CS_DISK_ELEMENTS "cs-disk-elements"
+	#define CMD_LINE_OPT_SHARED_CS "shared-cs"
+	#define CMD_LINE_OPT_SEG_CS "seg-cs"
+	#define CMD_LINE_OPT_CS_SNAPSHOT "cs-snapshot"
+	#define CMD_LINE_OPT_STAGED "staged"
+	#define CMD_LINE_OPT_TRUST_NAME_HASH "trust-name-hash"
+	#define CMD_LINE_OPT_TOKENIZE_NAMES "tokenize-names"
+	#define CMD_LINE_OPT_RX_LCORES "rx-lcores"
+	#define CMD_LINE_OPT_TX_LCORES "tx-lcores"
+	#define CMD_LINE_OPT_SW_STEERING "sw-steering"
+	#define CMD_LINE_OPT_EVENTDEV "eventdev"
+	#define CMD_LINE_OPT_HOT_NAMES "hot-names"
+	#define CMD_LINE_OPT_ELASTIC "elastic"
+	#define CMD_LINE_OPT_IDLE "idle"
+	#define CMD_LINE_OPT_TX_SLO_US "tx-slo-us"
+	#define CMD_LINE_OPT_TX_WEIGHTS "tx-weights"
+	#define CMD_LINE_OPT_FACE_RATE "face-rate"
+	#define CMD_LINE_OPT_PIT_QUOTA "pit-quota"
+	#define CMD_LINE_OPT_RTT_STRATEGY "rtt-strategy"
+	#define CMD_LINE_OPT_HASH_BENCH "hash-bench"
+	#define CMD_LINE_OPT_PARSE_BENCH "parse-bench"
+	#define CMD_LINE_OPT_EVENTDEV_BENCH "eventdev-bench"
 
 	int opt, ret;
 	char **argvopt;
@@ -104,12 +186,58 @@ static int parse_args(int argc, char **argv, struct user_params *params) {
 		{CMD_LINE_OPT_NO_NUMA, no_argument, 0, 0},
 		{CMD_LINE_OPT_HELP, no_argument, 0, 0},
 		{CMD_LINE_OPT_VERSION, no_argument, 0, 0},
+		{CMD_LINE_OPT_CS_DISK, required_argument, 0, 0},
+		{CMD_LINE_OPT_CS_DISK_ELEMENTS, required_argument, 0, 0},
+		{CMD_LINE_OPT_SHARED_CS, no_argument, 0, 0},
+		{CMD_LINE_OPT_SEG_CS, no_argument, 0, 0},
+		{CMD_LINE_OPT_CS_SNAPSHOT, required_argument, 0, 0},
+		{CMD_LINE_OPT_STAGED, no_argument, 0, 0},
+		{CMD_LINE_OPT_TRUST_NAME_HASH, no_argument, 0, 0},
+		{CMD_LINE_OPT_TOKENIZE_NAMES, no_argument, 0, 0},
+		{CMD_LINE_OPT_RX_LCORES, required_argument, 0, 0},
+		{CMD_LINE_OPT_TX_LCORES, required_argument, 0, 0},
+		{CMD_LINE_OPT_SW_STEERING, no_argument, 0, 0},
+		{CMD_LINE_OPT_EVENTDEV, no_argument, 0, 0},
+		{CMD_LINE_OPT_HOT_NAMES, no_argument, 0, 0},
+		{CMD_LINE_OPT_ELASTIC, no_argument, 0, 0},
+		{CMD_LINE_OPT_IDLE, required_argument, 0, 0},
+		{CMD_LINE_OPT_TX_SLO_US, required_argument, 0, 0},
+		{CMD_LINE_OPT_TX_WEIGHTS, required_argument, 0, 0},
+		{CMD_LINE_OPT_FACE_RATE, required_argument, 0, 0},
+		{CMD_LINE_OPT_PIT_QUOTA, required_argument, 0, 0},
+		{CMD_LINE_OPT_RTT_STRATEGY, no_argument, 0, 0},
+		{CMD_LINE_OPT_HASH_BENCH, no_argument, 0, 0},
+		{CMD_LINE_OPT_PARSE_BENCH, no_argument, 0, 0},
+		{CMD_LINE_OPT_EVENTDEV_BENCH, no_argument, 0, 0},
 		{NULL, 0, 0, 0}
 	};
 	argvopt = argv;
 
 	/* Init default options */
 	params->numa_on = 1;
+	params->cs_disk_path[0] = '\0';
+	params->cs_disk_max_elements = CS_DISK_MAX_ELEMENTS;
+	params->cs_shared = 0;
+	params->cs_seg = 0;
+	params->cs_snapshot_path[0] = '\0';
+	params->staged_burst = 0;
+	params->trust_name_hash = 0;
+	params->tokenize_names = 0;
+	params->rx_lcore_mask = 0;
+	params->tx_lcore_mask = 0;
+	params->sw_steering = 0;
+	params->eventdev = 0;
+	params->hot_names = 0;
+	params->elastic = 0;
+	params->idle_policy = IDLE_POLICY_POLL;
+	params->tx_slo_us = 0;
+	params->tx_drr = 0;
+	params->face_rate = 0;
+	params->pit_face_quota = 100;
+	params->rtt_strategy = 0;
+	params->hash_bench = 0;
+	params->parse_bench = 0;
+	params->eventdev_bench = 0;
 
 	/*
 	 * The 3rd argument is a list of short options.
@@ -168,6 +296,120 @@ static int parse_args(int argc, char **argv, struct user_params *params) {
 			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_VERSION, sizeof(CMD_LINE_OPT_VERSION))) {
 				print_version(prgname);
 				rte_exit(EXIT_SUCCESS, NULL);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_CS_DISK, sizeof(CMD_LINE_OPT_CS_DISK))) {
+				if (strlen(optarg) >= CS_DISK_PATH_LEN) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "CS disk tier path too long");
+				}
+				strcpy(params->cs_disk_path, optarg);
+				MAIN_LOG("CS disk tier enabled on %s\n", params->cs_disk_path);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_CS_DISK_ELEMENTS, sizeof(CMD_LINE_OPT_CS_DISK_ELEMENTS))) {
+				params->cs_disk_max_elements = (uint32_t) strtoul(optarg, NULL, 10);
+				if (params->cs_disk_max_elements == 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid number of CS disk tier elements");
+				}
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_SHARED_CS, sizeof(CMD_LINE_OPT_SHARED_CS))) {
+				MAIN_LOG("Shared CS enabled\n");
+				params->cs_shared = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_SEG_CS, sizeof(CMD_LINE_OPT_SEG_CS))) {
+				MAIN_LOG("CS segment index enabled\n");
+				params->cs_seg = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_CS_SNAPSHOT, sizeof(CMD_LINE_OPT_CS_SNAPSHOT))) {
+				if (strlen(optarg) >= CS_DISK_PATH_LEN) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "CS snapshot path too long");
+				}
+				strcpy(params->cs_snapshot_path, optarg);
+				MAIN_LOG("CS snapshot enabled on %s\n", params->cs_snapshot_path);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_STAGED, sizeof(CMD_LINE_OPT_STAGED))) {
+				MAIN_LOG("Staged burst processing enabled\n");
+				params->staged_burst = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_TRUST_NAME_HASH, sizeof(CMD_LINE_OPT_TRUST_NAME_HASH))) {
+				MAIN_LOG("Trusting name hashes embedded in packets\n");
+				params->trust_name_hash = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_TOKENIZE_NAMES, sizeof(CMD_LINE_OPT_TOKENIZE_NAMES))) {
+				MAIN_LOG("Tokenizing names instead of using component offsets TLVs\n");
+				params->tokenize_names = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_RX_LCORES, sizeof(CMD_LINE_OPT_RX_LCORES))) {
+				params->rx_lcore_mask = parse_mask_32(optarg);
+				if (params->rx_lcore_mask == 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid RX lcore mask");
+				}
+				MAIN_LOG("Pipeline enabled with RX lcores 0x%x\n", params->rx_lcore_mask);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_TX_LCORES, sizeof(CMD_LINE_OPT_TX_LCORES))) {
+				params->tx_lcore_mask = parse_mask_32(optarg);
+				if (params->tx_lcore_mask == 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid TX lcore mask");
+				}
+				MAIN_LOG("TX lcores 0x%x\n", params->tx_lcore_mask);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_SW_STEERING, sizeof(CMD_LINE_OPT_SW_STEERING))) {
+				MAIN_LOG("Software steering enabled\n");
+				params->sw_steering = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_EVENTDEV, sizeof(CMD_LINE_OPT_EVENTDEV))) {
+				MAIN_LOG("Event device scheduling enabled\n");
+				params->eventdev = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_HOT_NAMES, sizeof(CMD_LINE_OPT_HOT_NAMES))) {
+				MAIN_LOG("Hot name replication enabled\n");
+				params->hot_names = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_ELASTIC, sizeof(CMD_LINE_OPT_ELASTIC))) {
+				MAIN_LOG("Elastic scaling enabled\n");
+				params->elastic = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_IDLE, sizeof(CMD_LINE_OPT_IDLE))) {
+				ret = idle_policy_parse(optarg);
+				if (ret < 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid idle policy");
+				}
+				params->idle_policy = (uint8_t) ret;
+				MAIN_LOG("Idle policy %s\n", optarg);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_TX_SLO_US, sizeof(CMD_LINE_OPT_TX_SLO_US))) {
+				params->tx_slo_us = (uint32_t) strtoul(optarg, NULL, 10);
+				if (params->tx_slo_us == 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid TX batching delay");
+				}
+				MAIN_LOG("Adaptive TX batching enabled, max delay %u us\n", params->tx_slo_us);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_TX_WEIGHTS, sizeof(CMD_LINE_OPT_TX_WEIGHTS))) {
+				if (sscanf(optarg, "%u,%u,%u", &params->tx_weights[TX_CLASS_DATA],
+						&params->tx_weights[TX_CLASS_CS_HIT],
+						&params->tx_weights[TX_CLASS_INTEREST]) != TX_NB_CLASSES ||
+						params->tx_weights[TX_CLASS_DATA] == 0 ||
+						params->tx_weights[TX_CLASS_CS_HIT] == 0 ||
+						params->tx_weights[TX_CLASS_INTEREST] == 0 ||
+						params->tx_weights[TX_CLASS_DATA] > TX_DRR_MAX_WEIGHT ||
+						params->tx_weights[TX_CLASS_CS_HIT] > TX_DRR_MAX_WEIGHT ||
+						params->tx_weights[TX_CLASS_INTEREST] > TX_DRR_MAX_WEIGHT) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid TX weights");
+				}
+				params->tx_drr = 1;
+				MAIN_LOG("TX DRR enabled, weights %s\n", optarg);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_FACE_RATE, sizeof(CMD_LINE_OPT_FACE_RATE))) {
+				params->face_rate = (uint32_t) strtoul(optarg, NULL, 10);
+				if (params->face_rate == 0) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid face Interest rate");
+				}
+				MAIN_LOG("Interest rate limited to %u pps per face\n", params->face_rate);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_PIT_QUOTA, sizeof(CMD_LINE_OPT_PIT_QUOTA))) {
+				params->pit_face_quota = (uint32_t) strtoul(optarg, NULL, 10);
+				if (params->pit_face_quota == 0 || params->pit_face_quota > 100) {
+					print_usage(prgname);
+					rte_exit(EXIT_FAILURE, "Invalid PIT quota");
+				}
+				MAIN_LOG("PIT quota of %u%% per face\n", params->pit_face_quota);
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_RTT_STRATEGY, sizeof(CMD_LINE_OPT_RTT_STRATEGY))) {
+				MAIN_LOG("RTT forwarding strategy enabled\n");
+				params->rtt_strategy = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_HASH_BENCH, sizeof(CMD_LINE_OPT_HASH_BENCH))) {
+				params->hash_bench = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_PARSE_BENCH, sizeof(CMD_LINE_OPT_PARSE_BENCH))) {
+				params->parse_bench = 1;
+			} else if (!strncmp(lgopts[option_index].name, CMD_LINE_OPT_EVENTDEV_BENCH, sizeof(CMD_LINE_OPT_EVENTDEV_BENCH))) {
+				params->eventdev_bench = 1;
 			}
 			break;
 
@@ -177,6 +419,88 @@ static int parse_args(int argc, char **argv, struct user_params *params) {
 		}
 	}
 
+	/* The disk tier is attached to per-lcore CSs */
+	if (params->cs_shared && params->cs_disk_path[0] != '\0') {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--shared-cs and --cs-disk cannot be used together");
+	}
+	/* The segment index is part of per-lcore CSs */
+	if (params->cs_shared && params->cs_seg) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--shared-cs and --seg-cs cannot be used together");
+	}
+	/* Snapshots are taken of per-lcore CSs */
+	if (params->cs_shared && params->cs_snapshot_path[0] != '\0') {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--shared-cs and --cs-snapshot cannot be used together");
+	}
+
+	/* TX lcores transmit packets processed by the workers of a pipeline */
+	if (params->tx_lcore_mask != 0 && params->rx_lcore_mask == 0) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--tx-lcores requires --rx-lcores");
+	}
+	/* RX lcores of a pipeline already steer names in software */
+	if (params->sw_steering && params->rx_lcore_mask != 0) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--sw-steering and --rx-lcores cannot be used together");
+	}
+	/* Workers own the PIT and CS of the names steered to them */
+	if (params->cs_shared && params->rx_lcore_mask != 0) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--shared-cs and --rx-lcores cannot be used together");
+	}
+#ifndef RTE_LIBRTE_EVENTDEV
+	/* Event devices are only available in DPDK 17.11 and later */
+	if (params->eventdev || params->eventdev_bench) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--eventdev and --eventdev-bench require DPDK 17.11 or later "
+				"built with CONFIG_RTE_LIBRTE_EVENTDEV");
+	}
+#endif
+	/* The event device schedules packets from RX lcores to workers */
+	if (params->eventdev && params->rx_lcore_mask == 0) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--eventdev requires --rx-lcores");
+	}
+	/* Workers of the event device transmit the packets they process */
+	if (params->eventdev && params->tx_lcore_mask != 0) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--eventdev and --tx-lcores cannot be used together");
+	}
+	/* Interests of hot names can only be spread by software steering */
+	if (params->hot_names && !params->sw_steering) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--hot-names requires --sw-steering");
+	}
+	/* Replicas are stored in per-lcore CSs */
+	if (params->hot_names && params->cs_shared) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--hot-names and --shared-cs cannot be used together");
+	}
+	/* Disk tiers and snapshots are attached to per-lcore CSs, not to shards */
+	if (params->eventdev && (params->cs_disk_path[0] != '\0' ||
+			params->cs_snapshot_path[0] != '\0')) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--eventdev cannot be used with --cs-disk or --cs-snapshot");
+	}
+	/* Elastic scaling updates the RETA, which steers names to lcores */
+	if (params->elastic && (params->rx_lcore_mask != 0 || params->sw_steering)) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--elastic cannot be used with --rx-lcores or --sw-steering");
+	}
+	/* Parked lcores would stall the reclamation of the shared CS */
+	if (params->elastic && params->cs_shared) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--elastic and --shared-cs cannot be used together");
+	}
+	/* Packets steered over rings raise no RX interrupt */
+	if (params->idle_policy == IDLE_POLICY_INTR && (params->rx_lcore_mask != 0 ||
+			params->sw_steering)) {
+		print_usage(prgname);
+		rte_exit(EXIT_FAILURE, "--idle intr cannot be used with --rx-lcores or --sw-steering");
+	}
+
 	if (optind >= 0)
 		argv[optind-1] = prgname;
 
@@ -198,6 +522,11 @@ signal_handler(int signum) {
 		MAIN_LOG("Received SIGUSR2. Resetting statistics\n");
 		reset_stats();
 		return;
+	case SIGINT:
+	case SIGTERM:
+		MAIN_LOG("Received signal %d. Stopping lcores\n", signum);
+		app_conf.force_quit = 1;
+		return;
 	default:
 		return;
 	}
@@ -208,6 +537,7 @@ int MAIN(int argc, char **argv) {
 	int ret;
 	int i=0;
 	int nb_lcore;
+	cs_t *cs[APP_MAX_LCORES];
 	struct user_params params;
 
 	struct lcore_config lcore[APP_MAX_LCORES];
@@ -216,6 +546,8 @@ int MAIN(int argc, char **argv) {
 	/* Associate signal_hanlder function with appropriate signals */
 	signal(SIGUSR1, signal_handler);
 	signal(SIGUSR2, signal_handler);
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
 
 	/* Parse EAL arguments and init DPDK EAL
 	 *
@@ -247,6 +579,17 @@ int MAIN(int argc, char **argv) {
 	if (ret < 0)
 		rte_exit(EXIT_FAILURE, "Invalid content router arguments\n");
 
+	/* Benchmarks do not need ports */
+	if (params.hash_bench || params.parse_bench || params.eventdev_bench) {
+		if (params.hash_bench)
+			hash_bench();
+		if (params.parse_bench)
+			parse_bench();
+		if (params.eventdev_bench)
+			eventdev_bench();
+		rte_exit(EXIT_SUCCESS, NULL);
+	}
+
 	// Configure the app config object
 	app_conf.fib_num_buckets = FIB_NUM_BUCKETS;
 	app_conf.fib_max_elements = FIB_MAX_ELEMENTS;
@@ -254,19 +597,58 @@ int MAIN(int argc, char **argv) {
 	app_conf.pit_num_buckets = PIT_NUM_BUCKETS;
 	app_conf.pit_max_elements = PIT_MAX_ELEMENTS;
 	app_conf.pit_ttl_us = PIT_TTL_US;
+	app_conf.pit_face_quota = params.pit_face_quota;
+	app_conf.face_rate = params.face_rate;
+	app_conf.rtt_strategy = params.rtt_strategy;
 
 	/* CS settings */
 	app_conf.cs_num_buckets = CS_NUM_BUCKETS;
 	app_conf.cs_max_elements = CS_MAX_ELEMENTS;
+	app_conf.cs_bf_size = CS_BF_SIZE;
+	app_conf.cs_shared = params.cs_shared;
+	app_conf.cs_shared_shards = CS_SHARED_SHARDS;
+	app_conf.cs_seg = params.cs_seg;
+	app_conf.cs_seg_num_buckets = CS_SEG_NUM_BUCKETS;
+	app_conf.cs_seg_max_blocks = CS_SEG_MAX_BLOCKS;
+	strcpy(app_conf.cs_disk_path, params.cs_disk_path);
+	app_conf.cs_disk_max_elements = params.cs_disk_max_elements;
+	app_conf.cs_disk_fd = -1;
+	strcpy(app_conf.cs_snapshot_path, params.cs_snapshot_path);
+	app_conf.force_quit = 0;
+	/* Keep the default load of the disk tier index */
+	app_conf.cs_disk_num_buckets = RTE_MAX(1U, params.cs_disk_max_elements /
+			(CS_DISK_MAX_ELEMENTS / CS_DISK_NUM_BUCKETS));
 
 	/* Packet burst settings */
 	app_conf.tx_burst_size = MAX_PKT_BURST;
 	app_conf.rx_burst_size = MAX_PKT_BURST;
+	app_conf.tx_slo_us = params.tx_slo_us;
+	app_conf.tx_drr = params.tx_drr;
+	memcpy(app_conf.tx_weights, params.tx_weights, sizeof(app_conf.tx_weights));
+	app_conf.staged_burst = params.staged_burst;
+	app_conf.trust_name_hash = params.trust_name_hash;
+	app_conf.tokenize_names = params.tokenize_names;
+
+	/* Pipeline settings */
+	app_conf.pipeline = params.rx_lcore_mask != 0;
+	app_conf.rx_lcore_mask = params.rx_lcore_mask;
+	app_conf.tx_lcore_mask = params.tx_lcore_mask;
+	app_conf.sw_steering = params.sw_steering;
+	app_conf.eventdev = params.eventdev;
+	app_conf.hot_names = params.hot_names;
+	app_conf.hot_threshold = HOT_NAMES_THRESHOLD;
+	app_conf.hot_epoch_us = HOT_NAMES_EPOCH_US;
+	app_conf.elastic = params.elastic;
+	app_conf.idle_policy = params.idle_policy;
 
 	/* Packet pool settings */
 	app_conf.nb_mbuf = NB_MBUF;
 	app_conf.mbuf_size = MBUF_SIZE;
+	app_conf.mbuf_priv_size = MBUF_PRIV_SIZE;
 	app_conf.mempool_cache_size = MEMPOOL_CACHE_SIZE;
+	app_conf.nb_hdr_mbuf = NB_HDR_MBUF;
+	app_conf.hdr_mbuf_data_size = HDR_MBUF_DATA_SIZE;
+	app_conf.nb_clone_mbuf = NB_CLONE_MBUF;
 
 	/* Other config */
 	app_conf.promic_mode = params.promisc_mode;
@@ -279,6 +661,17 @@ int MAIN(int argc, char **argv) {
 	init_app(&app_conf, lcore_conf);
 	reset_stats();
 
+	/* The snapshot is reloaded by each lcore before entering its loop */
+	if (app_conf.cs_snapshot_path[0] != '\0') {
+		ret = cs_snapshot_open(app_conf.cs_snapshot_path, &app_conf.cs_snapshot);
+		if (ret == 0)
+			MAIN_LOG("Reloading %u CS entries from %s\n",
+					app_conf.cs_snapshot.hdr->nb_entries, app_conf.cs_snapshot_path);
+		else if (ret != -ENOENT)
+			MAIN_LOG("Cannot reload CS snapshot %s: %s\n",
+					app_conf.cs_snapshot_path, strerror(-ret));
+	}
+
 	MAIN_LOG("All configuration done. Launching worker lcores\n");
 
 	/* launch per-lcore init on every lcore but lcore 0 and control plane lcore*/
@@ -305,6 +698,24 @@ int MAIN(int argc, char **argv) {
 		if (rte_eal_wait_lcore(lcore_id) < 0)
 			return -1;
 	}
+
+	/* The disk I/O thread may still be writing to the file of the CS */
+	if (app_conf.cs_disk_fd >= 0) {
+		cs_disk_io_stop();
+		close(app_conf.cs_disk_fd);
+	}
+
+	cs_snapshot_close(&app_conf.cs_snapshot);
+	if (app_conf.cs_snapshot_path[0] != '\0') {
+		for (i = 0; i < APP_MAX_LCORES; i++)
+			cs[i] = lcore_conf[i].cs;
+		ret = cs_snapshot_save(app_conf.cs_snapshot_path, cs, APP_MAX_LCORES);
+		if (ret < 0)
+			MAIN_LOG("Cannot save CS snapshot %s: %s\n",
+					app_conf.cs_snapshot_path, strerror(-ret));
+		else
+			MAIN_LOG("Saved %d CS entries to %s\n", ret, app_conf.cs_snapshot_path);
+	}
 	return 0;
 }
 
@@ -0,0 +1,147 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_debug.h>
+#include <rte_byteorder.h>
+#include <rte_malloc.h>
+#include <rte_random.h>
+
+#include <config.h>
+#include <packet.h>
+
+#include "parse_bench.h"
+
+#define PARSE_BENCH_LOG(...) printf("[PARSE_BENCH]: " __VA_ARGS__)
+
+/* Size of the buffer of each packet */
+#define PARSE_BENCH_PKT_SIZE 128
+
+/* Prevents the compiler from optimizing away the parsing */
+static volatile uint32_t parse_bench_sink;
+
+
+/* Append a TLV to a packet, returning its new length */
+static uint16_t
+parse_bench_tlv(uint8_t *pkt, uint16_t len, uint16_t type_be, const void *value,
+		uint16_t value_len) {
+	uint16_t length = rte_cpu_to_be_16(value_len);
+
+	memcpy(pkt + len, &type_be, sizeof(type_be));
+	memcpy(pkt + len + sizeof(type_be), &length, sizeof(length));
+	memcpy(pkt + len + 2 * sizeof(uint16_t), value, value_len);
+	return len + 2 * sizeof(uint16_t) + value_len;
+}
+
+
+/*
+ * Build an Interest with a random name of PARSE_BENCH_COMPONENTS components,
+ * a nonce and a lifetime, with or without the component offsets TLV. Return
+ * its length
+ */
+static uint16_t
+parse_bench_build(uint8_t *pkt, int with_offsets) {
+	struct icn_hdr *hdr = (struct icn_hdr *) pkt;
+	uint16_t offsets[PARSE_BENCH_COMPONENTS];
+	uint16_t name_len = rte_cpu_to_be_16(PARSE_BENCH_NAME_LEN);
+	uint32_t nonce = (uint32_t) rte_rand();
+	uint32_t lifetime = rte_cpu_to_be_32(4000);
+	uint8_t *name = pkt + ICN_HDR_NAME_OFFSET;
+	uint16_t len, i, sep;
+
+	memset(pkt, 0, PARSE_BENCH_PKT_SIZE);
+	memcpy(pkt + sizeof(struct icn_hdr), &name_len, sizeof(name_len));
+	for (i = 0; i < PARSE_BENCH_NAME_LEN; i++) {
+		name[i] = 'a' + rte_rand() % 26;
+	}
+	for (i = 0; i < PARSE_BENCH_COMPONENTS; i++) {
+		sep = (i + 1) * PARSE_BENCH_NAME_LEN / PARSE_BENCH_COMPONENTS - 1;
+		name[sep] = COMPONENT_SEP;
+		offsets[i] = rte_cpu_to_be_16(sep);
+	}
+	len = ICN_HDR_NAME_OFFSET + PARSE_BENCH_NAME_LEN;
+	if (with_offsets) {
+		len = parse_bench_tlv(pkt, len, TLV_TYPE_NAME_COMPONENTS_OFFSET_BE,
+				offsets, sizeof(offsets));
+	}
+	len = parse_bench_tlv(pkt, len, TLV_TYPE_INTEREST_NONCE_BE, &nonce, sizeof(nonce));
+	len = parse_bench_tlv(pkt, len, TLV_TYPE_INTEREST_LIFETIME_BE, &lifetime,
+			sizeof(lifetime));
+	hdr->type = TYPE_INTEREST_BE;
+	hdr->hop_limit = 10;
+	hdr->hdr_len = rte_cpu_to_be_16(len);
+	hdr->pkt_len = rte_cpu_to_be_16(len);
+	return len;
+}
+
+
+/* Return the nanoseconds taken to parse a packet */
+static double
+parse_bench_run(uint8_t *pkts, const uint16_t *len) {
+	struct icn_packet icn_pkt;
+	uint64_t start_tsc = 0, cycles;
+	uint32_t sink = 0;
+	unsigned r, i;
+
+	for (r = 0; r <= PARSE_BENCH_ROUNDS; r++) {
+		/* The first round warms up caches */
+		if (r == 1) {
+			start_tsc = rte_rdtsc();
+		}
+		for (i = 0; i < PARSE_BENCH_PKTS; i++) {
+			sink += parse_packet(pkts + i * PARSE_BENCH_PKT_SIZE, len[i], &icn_pkt);
+			sink += icn_pkt.component_nr;
+		}
+	}
+	cycles = rte_rdtsc() - start_tsc;
+	parse_bench_sink = sink;
+	return (double) cycles * 1e9 / rte_get_tsc_hz() /
+			((double) PARSE_BENCH_PKTS * PARSE_BENCH_ROUNDS);
+}
+
+
+void parse_bench(void) {
+	uint8_t *pkts;
+	uint16_t len[PARSE_BENCH_PKTS];
+	double with_offsets, without_offsets, truncated;
+	unsigned i;
+
+	pkts = rte_zmalloc(NULL, PARSE_BENCH_PKTS * PARSE_BENCH_PKT_SIZE, RTE_CACHE_LINE_SIZE);
+	if (pkts == NULL) {
+		rte_exit(EXIT_FAILURE, "Cannot allocate memory for parse benchmark\n");
+	}
+	PARSE_BENCH_LOG("ns/packet parsing %u Interests with names of %u bytes and "
+			"%u components %u times\n", PARSE_BENCH_PKTS, PARSE_BENCH_NAME_LEN,
+			PARSE_BENCH_COMPONENTS, PARSE_BENCH_ROUNDS);
+
+	for (i = 0; i < PARSE_BENCH_PKTS; i++) {
+		len[i] = parse_bench_build(pkts + i * PARSE_BENCH_PKT_SIZE, 1);
+	}
+	with_offsets = parse_bench_run(pkts, len);
+
+	for (i = 0; i < PARSE_BENCH_PKTS; i++) {
+		len[i] = parse_bench_build(pkts + i * PARSE_BENCH_PKT_SIZE, 0);
+	}
+	without_offsets = parse_bench_run(pkts, len);
+
+	/* Buffers end within the name */
+	for (i = 0; i < PARSE_BENCH_PKTS; i++) {
+		len[i] = ICN_HDR_NAME_OFFSET + rte_rand() % PARSE_BENCH_NAME_LEN;
+	}
+	truncated = parse_bench_run(pkts, len);
+
+	PARSE_BENCH_LOG("%24s %8.2f\n", "With offsets TLV", with_offsets);
+	PARSE_BENCH_LOG("%24s %8.2f\n", "Without offsets TLV", without_offsets);
+	PARSE_BENCH_LOG("%24s %8.2f\n", "Truncated", truncated);
+	rte_free(pkts);
+}
@@ -0,0 +1,32 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _PARSE_BENCH_H_
+#define _PARSE_BENCH_H_
+
+/**
+ * @file
+ *
+ * Benchmark of packet parsing
+ *
+ * Measures the time taken by parse_packet per packet, on Interests with and
+ * without the component offsets TLV and on truncated packets, so that the cost
+ * of validating packets against their length can be checked.
+ */
+
+#define PARSE_BENCH_PKTS		1024	/**< number of distinct packets parsed */
+#define PARSE_BENCH_ROUNDS		2048	/**< times each packet is parsed */
+#define PARSE_BENCH_NAME_LEN	32		/**< length of the names */
+#define PARSE_BENCH_COMPONENTS	4		/**< number of components of each name */
+
+/**
+ * Run the benchmark and print its results. Must be called after the EAL is
+ * initialized
+ */
+void parse_bench(void);
+
+#endif /* _PARSE_BENCH_H_ */
@@ -0,0 +1,215 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include <rte_atomic.h>
+#include <rte_branch_prediction.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_thash.h>
+
+#include <config.h>
+
+#include "steering.h"
+
+#define STEERING_LOG(...) printf("[STEERING]: " __VA_ARGS__)
+
+static struct steering steering;
+
+
+void steering_init(uint32_t portmask, struct app_lcore_config lcore[]) {
+	struct rte_eth_rss_reta_entry64 reta_conf[ETH_RSS_RETA_SIZE_512 / RTE_RETA_GROUP_SIZE];
+	struct rte_eth_dev_info dev_info;
+	unsigned lcore_id, i;
+	uint8_t port_id, nb_queues = 0;
+
+	steering.portmask = portmask;
+	for (port_id = 0; port_id < rte_eth_dev_count(); port_id++) {
+		if (portmask & (1 << port_id)) {
+			break;
+		}
+	}
+	/* Queues have the same ID on all ports, lcores of a pipeline may have none */
+	for (lcore_id = 0; lcore_id < APP_MAX_LCORES; lcore_id++) {
+		if ((!rte_lcore_is_enabled(lcore_id))||(lcore_id == CONTROL_PLANE_LCORE) ||
+				lcore[lcore_id].nb_rx_ports == 0) {
+			continue;
+		}
+		steering.queue_lcore[lcore[lcore_id].rx_queue[port_id].queue_id] = lcore_id;
+		nb_queues++;
+	}
+	steering.nb_queues = nb_queues;
+	steering.nb_active = nb_queues;
+
+	rte_eth_dev_info_get(port_id, &dev_info);
+	steering.reta_size = dev_info.reta_size;
+	if (steering.reta_size > 0 && steering.reta_size <= ETH_RSS_RETA_SIZE_512) {
+		memset(reta_conf, 0, sizeof(reta_conf));
+		for (i = 0; i < steering.reta_size / RTE_RETA_GROUP_SIZE; i++) {
+			reta_conf[i].mask = UINT64_MAX;
+		}
+		if (rte_eth_dev_rss_reta_query(port_id, reta_conf, steering.reta_size) == 0) {
+			for (i = 0; i < steering.reta_size; i++) {
+				steering.reta[i] = (uint8_t) reta_conf[i / RTE_RETA_GROUP_SIZE].reta[i % RTE_RETA_GROUP_SIZE];
+			}
+			STEERING_LOG("Read RETA of %u entries from port %u\n", steering.reta_size, port_id);
+			steering.reta_read = 1;
+			return;
+		}
+	}
+	/* Queues are assigned round robin in the default RETA of all NICs */
+	steering.reta_size = ETH_RSS_RETA_SIZE_128;
+	for (i = 0; i < steering.reta_size; i++) {
+		steering.reta[i] = (uint8_t) (i % nb_queues);
+	}
+	STEERING_LOG("Cannot read RETA of port %u, assuming default one\n", port_id);
+}
+
+
+/* Return the entry of the RETA of packets with a given source IPv4 address */
+static inline uint16_t
+steering_entry(uint32_t src_addr) {
+	/* The RSS key makes the hash only depend on the source address */
+	uint32_t tuple[2] = { src_addr, 0 };
+	uint32_t hash;
+
+	hash = rte_softrss(tuple, RTE_DIM(tuple), RSS_TOEPLITZ_KEY);
+	return (uint16_t) (hash % steering.reta_size);
+}
+
+
+unsigned steering_lcore(uint32_t src_addr) {
+	return steering.queue_lcore[steering.reta[steering_entry(src_addr)]];
+}
+
+
+unsigned steering_prev_lcore(uint32_t src_addr) {
+	if (likely(!steering.draining)) {
+		return APP_MAX_LCORES;
+	}
+	return steering.queue_lcore[steering.prev_reta[steering_entry(src_addr)]];
+}
+
+
+uint8_t steering_reta_known(void) {
+	return steering.reta_read;
+}
+
+
+uint32_t steering_generation(void) {
+	return steering.generation;
+}
+
+
+uint8_t steering_nb_active(void) {
+	return steering.nb_active;
+}
+
+
+/* Program a RETA on all ports, stopping at the first one failing */
+static int
+steering_program(const uint8_t *reta, uint8_t *nb_done) {
+	struct rte_eth_rss_reta_entry64 reta_conf[ETH_RSS_RETA_SIZE_512 / RTE_RETA_GROUP_SIZE];
+	uint8_t port_id;
+	unsigned i;
+	int ret;
+
+	memset(reta_conf, 0, sizeof(reta_conf));
+	for (i = 0; i < steering.reta_size; i++) {
+		reta_conf[i / RTE_RETA_GROUP_SIZE].mask = UINT64_MAX;
+		reta_conf[i / RTE_RETA_GROUP_SIZE].reta[i % RTE_RETA_GROUP_SIZE] = reta[i];
+	}
+	for (port_id = 0; port_id < *nb_done; port_id++) {
+		if ((steering.portmask & (1 << port_id)) == 0) {
+			continue;
+		}
+		ret = rte_eth_dev_rss_reta_update(port_id, reta_conf, steering.reta_size);
+		if (ret < 0) {
+			*nb_done = port_id;
+			return ret;
+		}
+	}
+	return 0;
+}
+
+
+/* Return the number of RETA entries of the k-th of nb_active RX queues */
+static inline uint16_t
+steering_share(uint8_t k, uint8_t nb_active) {
+	return (uint16_t) (steering.reta_size / nb_active + (k < steering.reta_size % nb_active));
+}
+
+
+int steering_update(const uint8_t active[APP_MAX_LCORES]) {
+	uint8_t reta[ETH_RSS_RETA_SIZE_512];
+	uint8_t queues[APP_MAX_LCORES], rank[APP_MAX_LCORES];
+	uint16_t count[APP_MAX_LCORES];
+	uint8_t q, k, nb_active = 0, nb_ports;
+	unsigned i;
+	int ret;
+
+	if (steering.draining) {
+		return -EBUSY;
+	}
+	memset(rank, UINT8_MAX, sizeof(rank));
+	for (q = 0; q < steering.nb_queues; q++) {
+		if (active[steering.queue_lcore[q]]) {
+			rank[q] = nb_active;
+			queues[nb_active++] = q;
+		}
+	}
+	if (nb_active == 0) {
+		return -EINVAL;
+	}
+	/* Entries of active queues stay there, up to their share */
+	memset(count, 0, sizeof(count));
+	for (i = 0; i < steering.reta_size; i++) {
+		reta[i] = UINT8_MAX;
+		k = rank[steering.reta[i]];
+		if (k != UINT8_MAX && count[k] < steering_share(k, nb_active)) {
+			reta[i] = steering.reta[i];
+			count[k]++;
+		}
+	}
+	/* The others fill up the shares of the queues with fewer entries */
+	for (i = 0, k = 0; i < steering.reta_size; i++) {
+		if (reta[i] != UINT8_MAX) {
+			continue;
+		}
+		while (count[k] >= steering_share(k, nb_active)) {
+			k++;
+		}
+		reta[i] = queues[k];
+		count[k]++;
+	}
+
+	nb_ports = rte_eth_dev_count();
+	ret = steering_program(reta, &nb_ports);
+	if (ret < 0) {
+		STEERING_LOG("Cannot update RETA of port %u: %s\n", nb_ports, strerror(-ret));
+		/* Restore the RETA of the ports already updated */
+		steering_program(steering.reta, &nb_ports);
+		return ret;
+	}
+	/* The previous RETA must be complete before the new one is visible */
+	memcpy(steering.prev_reta, steering.reta, steering.reta_size);
+	steering.draining = 1;
+	rte_smp_wmb();
+	memcpy(steering.reta, reta, steering.reta_size);
+	steering.nb_active = nb_active;
+	rte_smp_wmb();
+	steering.generation++;
+	STEERING_LOG("Updated RETA to %u RX queues\n", nb_active);
+	return 0;
+}
+
+
+void steering_end_drain(void) {
+	steering.draining = 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Lorenzo Saino, Massimo Gallo
+ *
+ * Copyright (c) 2016 Alcatel-Lucent, Bell Labs
+ *
+ */
+
+#ifndef _STEERING_H_
+#define _STEERING_H_
+
+/**
+ * @file
+ *
+ * Software model of the RSS steering of the NICs
+ *
+ * Packets are steered to an RX queue, and therefore to an lcore, according to
+ * the Toeplitz hash of their source IPv4 address (see RSS_TOEPLITZ_KEY),
+ * looked up in the redirection table (RETA) of the NIC. This module computes
+ * the same function in software, e.g. to find out which lcore caches a name.
+ *
+ * With elastic scaling, the RETA of all ports is reprogrammed to steer names
+ * only to active lcores. The previous RETA is kept while lcores drain, so that
+ * Data can be handed over to the lcore holding their PIT entries.
+ */
+
+#include <stdint.h>
+
+#include <rte_ethdev.h>
+
+#include <config.h>
+
+#include "init.h"
+
+/**
+ * RSS steering of the NICs
+ */
+struct steering {
+	uint16_t reta_size;						/**< number of entries of the RETA */
+	uint8_t reta[ETH_RSS_RETA_SIZE_512];	/**< RX queue of each RETA entry */
+	uint8_t prev_reta[ETH_RSS_RETA_SIZE_512];	/**< RETA before the last update, while draining */
+	uint8_t queue_lcore[APP_MAX_LCORES];	/**< lcore reading each RX queue */
+	uint8_t nb_queues;
+	volatile uint8_t nb_active;	/**< RX queues the RETA steers packets to */
+	uint8_t reta_read;			/**< the RETA has been read from the NIC */
+	uint32_t portmask;
+	volatile uint8_t draining;	/**< prev_reta is still in use */
+	volatile uint32_t generation;	/**< number of updates of the RETA */
+};
+
+/**
+ * Read the RETA of the first enabled port and the mapping of RX queues to
+ * lcores. All ports are assumed to have the same RETA
+ *
+ * Must be called once ports and queues are configured.
+ *
+ * @param portmask
+ *   The mask of enabled ports passed via command line
+ * @param lcore
+ *   Configuration of lcores
+ */
+void steering_init(uint32_t portmask, struct app_lcore_config lcore[]);
+
+/**
+ * Return the lcore receiving packets with a given source IPv4 address
+ *
+ * @param src_addr
+ *   Source IPv4 address, in host byte order
+ *
+ * @return
+ *   ID of the lcore
+ */
+unsigned steering_lcore(uint32_t src_addr);
+
+/**
+ * Return the lcore which received packets with a given source IPv4 address
+ * before the last update of the RETA, while lcores drain
+ *
+ * @param src_addr
+ *   Source IPv4 address, in host byte order
+ *
+ * @return
+ *   ID of the lcore, APP_MAX_LCORES if no lcore is draining
+ */
+unsigned steering_prev_lcore(uint32_t src_addr);
+
+/**
+ * Tell whether the RETA of the NICs is known, and can therefore be updated
+ */
+uint8_t steering_reta_known(void);
+
+/**
+ * Return the number of updates of the RETA so far. Lcores whose CS must be
+ * migrated watch it
+ */
+uint32_t steering_generation(void);
+
+/**
+ * Return the number of lcores the RETA steers packets to. Lcores dividing a
+ * rate among active lcores read it when the generation changes
+ */
+uint8_t steering_nb_active(void);
+
+/**
+ * Reprogram the RETA of all ports to steer packets only to the RX queues of a
+ * set of lcores, each getting an even share of the entries. Entries already
+ * steered to one of these lcores stay there as far as possible, so that
+ * few names move. The previous RETA is kept until steering_end_drain is
+ * called.
+ *
+ * Called by the control plane.
+ *
+ * @param active
+ *   Nonzero for each lcore to steer packets to
+ *
+ * @return
+ *  - 0 on success
+ *  - -EINVAL if no lcore with RX queues is active
+ *  - -EBUSY if lcores are still draining from the previous update
+ *  - a negative errno value if a port does not support RETA updates, in
+ *    which case the RETA of all ports is left unchanged
+ */
+int steering_update(const uint8_t active[APP_MAX_LCORES]);
+
+/**
+ * Stop steering Data to the lcores of the RETA before the last update
+ */
+void steering_end_drain(void);
+
+#endif /* _STEERING_H_ */
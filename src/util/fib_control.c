@@ -48,7 +48,7 @@ int main(int argc, char *argv[])
 
 	if (argc != 5) {
                 fprintf(stderr,"usage: fib_ctrl -a 'address' -c \"command\"\n");
-		fprintf(stderr,"     command is of the form (ADD,CLR,DEL):prefix_name:port_id\n");
+		fprintf(stderr,"     command is of the form (ADD,CLR,DEL):prefix_name:port_id, FRS:prefix_name:freshness_ms or PRG:prefix_name\n");
                 exit(1);
         }
 	
@@ -124,6 +124,8 @@ int main(int argc, char *argv[])
 	
 
 	pkt.hdr->pkt_len = htons(msg_len);
+	//Copy header again, now that the packet length is known
+	memcpy(msg, pkt.hdr, ntohs(pkt.hdr->hdr_len));
         if ((numbytes = sendto(sockfd, msg, msg_len, 0, p->ai_addr, p->ai_addrlen)) == -1)
         {
                 perror("talker: sendto");